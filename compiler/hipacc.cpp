@@ -73,7 +73,7 @@ void printUsage() {
     << "  -emit-renderscript      Emit Renderscript code for Android\n"
     << "  -emit-filterscript      Emit Filterscript code for Android\n"
     << "  -emit-padding <n>       Emit CUDA/OpenCL/Renderscript image padding, using alignment of <n> bytes for GPU devices\n"
-    << "  -target <n>             Generate code for GPUs with code name <n>.\n"
+    << "  -target <n>             Generate code for devices with code name <n>.\n"
     << "                          Code names for CUDA/OpenCL on NVIDIA devices are:\n"
     << "                            'Tesla-10', 'Tesla-11', 'Tesla-12', and 'Tesla-13' for Tesla architecture.\n"
     << "                            'Fermi-20' and 'Fermi-21' for Fermi architecture.\n"
@@ -85,6 +85,10 @@ void printUsage() {
     << "                            'Midgard' for Mali-T6xx' for Mali.\n"
     << "                          Code names for for OpenCL on Intel Xeon Phi devices are:\n"
     << "                            'KnightsCorner' for Knights Corner Many Integrated Cores architecture.\n"
+    << "                          Code names for C/C++ and OpenCL on x86-64 CPUs are:\n"
+    << "                            'Haswell'   for AVX2 desktop CPUs.\n"
+    << "                            'SkylakeSP' for AVX-512 server CPUs.\n"
+    << "                            'Native'    for the CPU hipacc runs on (default for -emit-cpu and -emit-opencl-cpu).\n"
     << "  -explore-config         Emit code that explores all possible kernel configuration and print its performance\n"
     << "  -use-config <nxm>       Emit code that uses a configuration of nxm threads, e.g. 128x1\n"
     << "  -time-kernels           Emit code that executes each kernel multiple times to get accurate timings\n"
@@ -93,9 +97,29 @@ void printUsage() {
     << "                          Valid values for OpenCL: 'off' and 'Array2D'\n"
     << "  -use-local <o>          Enable/disable usage of shared/local memory in CUDA/OpenCL to stage image pixels to scratchpad\n"
     << "                          Valid values: 'on' and 'off'\n"
-    << "  -vectorize <o>          Enable/disable vectorization of generated CUDA/OpenCL code\n"
+    << "  -vectorize <o>          Enable/disable vectorization of generated CUDA/OpenCL/C++ code\n"
+    << "                          C/C++ code is vectorized by the host compiler, guided by loop pragmas (see HIPACC_SIMD_LOOP)\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -fuse <o>               Enable/disable fusion of producer/consumer kernels communicating via an intermediate image\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -separate <o>           Enable/disable splitting of convolutions with constant rank-1 masks into a row and a column kernel\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -specialize <o>         Enable/disable replacing scalar kernel arguments initialized with compile-time constants by their value\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -precompute <o>         Enable/disable precomputing math functions depending only on counters of loops with constant bounds into tables\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -select-bh <o>          Enable/disable branch-free border handling using conditional selects, allows vectorization of C/C++ border code\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -pad-halo <o>           Enable/disable allocating C/C++ images read with a single boundary mode with a halo filled on write instead of border handling in kernels\n"
     << "                          Valid values: 'on' and 'off'\n"
     << "  -pixels-per-thread <n>  Specify how many pixels should be calculated per thread\n"
+    << "  -cpu-threads <n>        Specify how many threads should execute C/C++ kernels, 0 uses all available cores\n"
+    << "                          Defaults to 0\n"
+    << "                          Can be overridden at runtime using the HIPACC_NUM_THREADS environment variable\n"
+    << "  -cpu-tiling <o>         Enable/disable tiling of C/C++ local operators into cache-sized blocks, or specify the block size, e.g. 256x32\n"
+    << "                          Valid values: 'on', 'off', and '<n>x<m>'\n"
+    << "  -stream-rows <n>        Execute C/C++ kernels in strips of n rows, streamed images keep only the rows of one strip in memory\n"
+    << "                          Images are streamed when declared with row callbacks, e.g. Image<int> IN(w, h, read, write)\n"
     << "  -rs-package <string>    Specify Renderscript package name. (default: \"org.hipacc.rs\")\n"
     << "  -o <file>               Write output to <file>\n"
     << "  --help                  Display available options\n"
@@ -118,6 +142,7 @@ int main(int argc, char *argv[]) {
   SmallVector<const char *, 16> args;
   CompilerOptions compilerOptions = CompilerOptions();
   std::string out;
+  bool user_target = false;
 
   // parse command line options
   for (int i=0; i<argc; ++i) {
@@ -190,11 +215,18 @@ int main(int argc, char *argv[]) {
         compilerOptions.setTargetDevice(Device::Midgard);
       } else if (StringRef(argv[i+1]) == "KnightsCorner") {
         compilerOptions.setTargetDevice(Device::KnightsCorner);
+      } else if (StringRef(argv[i+1]) == "Haswell") {
+        compilerOptions.setTargetDevice(Device::Haswell);
+      } else if (StringRef(argv[i+1]) == "SkylakeSP") {
+        compilerOptions.setTargetDevice(Device::SkylakeSP);
+      } else if (StringRef(argv[i+1]) == "Native") {
+        compilerOptions.setTargetDevice(Device::NativeCPU);
       } else {
         llvm::errs() << "ERROR: Expected valid code name specification for -target switch.\n\n";
         printUsage();
         return EXIT_FAILURE;
       }
+      user_target = true;
       ++i;
       continue;
     }
@@ -267,6 +299,90 @@ int main(int argc, char *argv[]) {
       ++i;
       continue;
     }
+    if (StringRef(argv[i]) == "-fuse") {
+      assert(i<(argc-1) && "Mandatory fusion specification for -fuse switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setFuseKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setFuseKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid fusion specification for -fuse switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-separate") {
+      assert(i<(argc-1) && "Mandatory separation specification for -separate switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setSeparateKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setSeparateKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid separation specification for -separate switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-specialize") {
+      assert(i<(argc-1) && "Mandatory specialization specification for -specialize switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setSpecializeKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setSpecializeKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid specialization specification for -specialize switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-precompute") {
+      assert(i<(argc-1) && "Mandatory precomputation specification for -precompute switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setPrecomputeTables(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setPrecomputeTables(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid precomputation specification for -precompute switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-select-bh") {
+      assert(i<(argc-1) && "Mandatory border handling specification for -select-bh switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setSelectBorderHandling(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setSelectBorderHandling(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid border handling specification for -select-bh switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-pad-halo") {
+      assert(i<(argc-1) && "Mandatory halo specification for -pad-halo switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setPadHalo(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setPadHalo(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid halo specification for -pad-halo switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
     if (StringRef(argv[i]) == "-pixels-per-thread") {
       assert(i<(argc-1) && "Mandatory integer parameter for -pixels-per-thread switch missing.");
       std::istringstream buffer(argv[i+1]);
@@ -281,6 +397,51 @@ int main(int argc, char *argv[]) {
       ++i;
       continue;
     }
+    if (StringRef(argv[i]) == "-cpu-threads") {
+      assert(i<(argc-1) && "Mandatory integer parameter for -cpu-threads switch missing.");
+      std::istringstream buffer(argv[i+1]);
+      int val;
+      buffer >> val;
+      if (buffer.fail() || val < 0) {
+        llvm::errs() << "ERROR: Expected non-negative integer parameter for -cpu-threads switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      compilerOptions.setNumThreads(val);
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-cpu-tiling") {
+      assert(i<(argc-1) && "Mandatory tiling specification for -cpu-tiling switch missing.");
+      int x=0, y=0;
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setCPUTiling(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setCPUTiling(USER_ON);
+      } else if (sscanf(argv[i+1], "%dx%d", &x, &y) == 2 && x > 0 && y > 0) {
+        compilerOptions.setCPUTileSize(x, y);
+      } else {
+        llvm::errs() << "ERROR: Expected valid tiling specification for -cpu-tiling switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-stream-rows") {
+      assert(i<(argc-1) && "Mandatory integer parameter for -stream-rows switch missing.");
+      std::istringstream buffer(argv[i+1]);
+      int val;
+      buffer >> val;
+      if (buffer.fail() || val < 0) {
+        llvm::errs() << "ERROR: Expected non-negative integer parameter for -stream-rows switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      compilerOptions.setStreamRows(val);
+      ++i;
+      continue;
+    }
     if (StringRef(argv[i]) == "-rs-package") {
       assert(i<(argc-1) && "Mandatory package name string for -rs-package switch missing.");
       compilerOptions.setRSPackageName(argv[i+1]);
@@ -306,6 +467,12 @@ int main(int argc, char *argv[]) {
     args.push_back(argv[i]);
   }
 
+  // CPU back ends are tuned for the host CPU unless specified otherwise
+  if (!user_target &&
+      (compilerOptions.emitC99() || compilerOptions.emitOpenCLCPU())) {
+    compilerOptions.setTargetDevice(Device::NativeCPU);
+  }
+
   // create target device description from compiler options
   HipaccDevice targetDevice(compilerOptions);
 
@@ -329,6 +496,14 @@ int main(int argc, char *argv[]) {
     printUsage();
     return EXIT_FAILURE;
   }
+  // CPU devices only supported by the CPU back ends
+  if (targetDevice.isCPU() &&
+      !(compilerOptions.emitC99() || compilerOptions.emitOpenCLCPU())) {
+    llvm::errs() << "ERROR: CPU target device specified, but no CPU code generation back end selected!\n"
+                 << "  Please select correct target device/code generation back end combination.\n\n";
+    printUsage();
+    return EXIT_FAILURE;
+  }
   // OpenCL (ACC) only supported on accelerator devices
   if (compilerOptions.emitOpenCLACC() && !targetDevice.isINTELACC()) {
     llvm::errs() << "ERROR: OpenCL (ACC) code generation selected, but no OpenCL-capable accelerator device specified!\n"
@@ -396,6 +571,47 @@ int main(int argc, char *argv[]) {
                  << "  Local memory disabled!\n";
     compilerOptions.setLocalMemory(USER_OFF);
   }
+  // Kernel fusion not supported in Renderscript/Filterscript
+  if ((compilerOptions.emitFilterscript() ||compilerOptions.emitRenderscript())
+      && compilerOptions.fuseKernels(USER_ON)) {
+    llvm::errs() << "Warning: kernel fusion is not available in Renderscript and Filterscript!\n"
+                 << "  Kernel fusion disabled!\n";
+    compilerOptions.setFuseKernels(USER_OFF);
+  }
+  // Kernel fusion not supported for vectorized kernels
+  if (compilerOptions.vectorizeKernels(USER_ON) &&
+      compilerOptions.fuseKernels(USER_ON)) {
+    llvm::errs() << "Warning: kernel fusion is not supported for vectorized kernels!\n"
+                 << "  Kernel fusion disabled!\n";
+    compilerOptions.setFuseKernels(USER_OFF);
+  }
+  // Kernel separation not supported in Renderscript/Filterscript
+  if ((compilerOptions.emitFilterscript() ||compilerOptions.emitRenderscript())
+      && compilerOptions.separateKernels(USER_ON)) {
+    llvm::errs() << "Warning: kernel separation is not available in Renderscript and Filterscript!\n"
+                 << "  Kernel separation disabled!\n";
+    compilerOptions.setSeparateKernels(USER_OFF);
+  }
+  // Streaming execution is only supported for C/C++ kernels
+  if (!compilerOptions.emitC99() && compilerOptions.streamExecution(USER_ON)) {
+    llvm::errs() << "Warning: streaming execution is only supported for C/C++ code generation!\n"
+                 << "  Streaming execution disabled!\n";
+    compilerOptions.setStreamRows(0);
+  }
+  // Padded halos are only supported for C/C++ kernels, streamed images hold
+  // only a window of rows
+  if (compilerOptions.padHalo(USER_ON) && (!compilerOptions.emitC99() ||
+        compilerOptions.streamExecution())) {
+    llvm::errs() << "Warning: padded halos are only supported for C/C++ code generation without streaming execution!\n"
+                 << "  Padded halos disabled!\n";
+    compilerOptions.setPadHalo(USER_OFF);
+  }
+  // Cache-blocked tiling is only supported for C/C++ kernels
+  if (compilerOptions.cpuTiling(USER_ON) && !compilerOptions.emitC99()) {
+    llvm::errs() << "Warning: cache-blocked tiling is only supported for C/C++ code generation!\n"
+                 << "  Tiling disabled!\n";
+    compilerOptions.setCPUTiling(USER_OFF);
+  }
   if (compilerOptions.timeKernels(USER_ON) &&
       compilerOptions.exploreConfig(USER_ON)) {
     // kernels are timed internally by the runtime in case of exploration
@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 #include "iterationspace.hpp"
 #include "mask.hpp"
@@ -54,15 +55,28 @@ enum class Interpolate : uint8_t {
     L3
 };
 
+// reads or writes row y of a streamed image
+typedef std::function<void(void *row, size_t y)> hipacc_row_fn;
+
+// forward declaration
+template<typename data_t> class Kernel;
+
 template<typename data_t>
 class Image {
     private:
         const int width_, height_;
         data_t *array;
         size_t *refcount;
+        hipacc_row_fn write_;
 
         data_t &pixel(const int x, const int y) { return array[y*width_ + x]; }
 
+        // pass the computed rows of a streamed image to its write callback
+        void write_rows(const int lo, const int hi) {
+            if (!write_) return;
+            for (int y=lo; y<hi; ++y) write_(&array[y*width_], y);
+        }
+
     public:
         Image(const int width, const int height, data_t *init) :
             width_(width),
@@ -82,11 +96,26 @@ class Image {
             std::fill(array, array + width*height, 0);
         }
 
+        // streamed image: rows are provided by read and computed rows are
+        // passed to write; the compiler keeps only a window of rows in memory
+        // when streaming execution is enabled
+        Image(const int width, const int height, const hipacc_row_fn &read,
+              const hipacc_row_fn &write=hipacc_row_fn()) :
+            width_(width),
+            height_(height),
+            array(new data_t[width*height]),
+            refcount(new size_t(1)),
+            write_(write)
+        {
+            for (int y=0; y<height; ++y) read(&array[y*width], y);
+        }
+
         Image(const Image &image) :
             width_(image.width_),
             height_(image.height_),
             array(image.array),
-            refcount(image.refcount)
+            refcount(image.refcount),
+            write_(image.write_)
         {
             ++(*refcount);
         }
@@ -136,6 +165,7 @@ class Image {
         }
 
     template<typename> friend class Accessor;
+    template<typename> friend class Kernel;
 };
 
 
@@ -188,7 +218,7 @@ class BoundaryCondition {
             size_x_(size_x),
             size_y_(size_y),
             bmode(bmode),
-            const_val(),
+            const_val(val),
             dummy(const_val)
         {
             assert(bmode == Boundary::CONSTANT && "Constant for boundary handling specified, but boundary mode is different.");
@@ -199,7 +229,7 @@ class BoundaryCondition {
             size_x_(size),
             size_y_(size),
             bmode(bmode),
-            const_val(),
+            const_val(val),
             dummy(const_val)
         {
             assert(bmode == Boundary::CONSTANT && "Constant for boundary handling specified, but boundary mode is different.");
@@ -210,7 +240,7 @@ class BoundaryCondition {
             size_x_(Mask.size_x()),
             size_y_(Mask.size_y()),
             bmode(bmode),
-            const_val(),
+            const_val(val),
             dummy(const_val)
         {
             assert(bmode == Boundary::CONSTANT && "Constant for boundary handling specified, but boundary mode is different.");
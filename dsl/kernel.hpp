@@ -50,6 +50,7 @@ class Kernel {
         Accessor<data_t> out_acc;
         std::vector<AccessorBase *> images;
         data_t reduction_result;
+        bool scan_defined;
 
     public:
         Kernel(IterationSpace<data_t> &iteration_space) :
@@ -62,6 +63,15 @@ class Kernel {
         virtual ~Kernel() {}
         virtual void kernel() = 0;
         virtual data_t reduce(data_t left, data_t right) { return left; }
+        // the default bin function ignores all pixels
+        virtual unsigned int bin(data_t pixel, unsigned int num_bins) {
+            return num_bins;
+        }
+        // the default scan function keeps the output unchanged
+        virtual data_t scan(data_t left, data_t right) {
+            scan_defined = false;
+            return right;
+        }
 
         void add_accessor(AccessorBase *acc) { images.push_back(acc); }
 
@@ -95,8 +105,42 @@ class Kernel {
             // de-register output accessor
             out_acc.setEI(nullptr);
 
-            // apply reduction
+            // apply scan and reduction
+            scan();
             reduce();
+
+            // write back computed rows of streamed images
+            iteration_space.img.write_rows(iteration_space.offset_y(),
+                    iteration_space.offset_y() + iteration_space.height());
+        }
+
+        // inclusive 2D scan applied in place to the output: rows are scanned
+        // first, columns afterwards, e.g. yielding the summed-area table for
+        // addition
+        void scan(void) {
+            auto iter = iteration_space.begin();
+            const int width = iteration_space.width();
+            const int height = iteration_space.height();
+
+            // register output accessors
+            out_acc.setEI(&iter);
+
+            scan_defined = true;
+            for (int y=0; y<height && scan_defined; ++y) {
+                for (int x=1; x<width && scan_defined; ++x) {
+                    out_acc.pixel_at(x, y) = scan(out_acc.pixel_at(x-1, y),
+                                                  out_acc.pixel_at(x, y));
+                }
+            }
+            for (int y=1; y<height && scan_defined; ++y) {
+                for (int x=0; x<width && scan_defined; ++x) {
+                    out_acc.pixel_at(x, y) = scan(out_acc.pixel_at(x, y-1),
+                                                  out_acc.pixel_at(x, y));
+                }
+            }
+
+            // de-register output accessor
+            out_acc.setEI(nullptr);
         }
 
         void reduce(void) {
@@ -124,6 +168,28 @@ class Kernel {
             return reduction_result;
         }
 
+        // histogram of the output, mapping each pixel to a bin using the bin
+        // function; bin indices outside of the histogram are ignored
+        std::vector<unsigned int> binned_data(unsigned int num_bins) {
+            auto end  = iteration_space.end();
+            auto iter = iteration_space.begin();
+            std::vector<unsigned int> hist(num_bins, 0);
+
+            // register output accessors
+            out_acc.setEI(&iter);
+
+            while (iter != end) {
+                unsigned int idx = bin(out_acc(), num_bins);
+                if (idx < num_bins) ++hist[idx];
+                ++iter;
+            }
+
+            // de-register output accessor
+            out_acc.setEI(nullptr);
+
+            return hist;
+        }
+
 
         // access output image
         data_t &output(void) {
@@ -153,6 +219,22 @@ class Kernel {
         auto reduce(Domain &domain, Reduce mode, const Function &fun) -> decltype(fun());
         template <typename Function>
         void iterate(Domain &domain, const Function &fun);
+
+    private:
+        // select the median using min/max compare-exchange, which works
+        // lane-wise for vector types
+        template <typename T>
+        static T median(std::vector<T> &values) {
+            size_t mid = values.size()/2;
+            for (size_t i=0; i<=mid; ++i) {
+                for (size_t j=i+1; j<values.size(); ++j) {
+                    T lo = hipacc::math::min(values[i], values[j]);
+                    values[j] = hipacc::math::max(values[i], values[j]);
+                    values[i] = lo;
+                }
+            }
+            return values[mid];
+        }
 };
 
 
@@ -166,6 +248,8 @@ auto Kernel<data_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& f
 
     // initialize result - calculate first iteration
     auto result = fun();
+    std::vector<decltype(fun())> values;
+    if (mode == Reduce::MEDIAN) values.push_back(result);
 
     // advance iterator and apply kernel to remaining iteration space
     while (++iter != end) {
@@ -189,11 +273,13 @@ auto Kernel<data_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& f
                 result *= fun();
                 break;
             case Reduce::MEDIAN:
-                assert(0 && "HipaccMEDIAN not implemented yet!");
+                values.push_back(fun());
                 break;
         }
     }
 
+    if (mode == Reduce::MEDIAN) result = median(values);
+
     // de-register mask
     mask.setEI(nullptr);
 
@@ -211,6 +297,8 @@ auto Kernel<data_t>::reduce(Domain &domain, Reduce mode, const Function &fun) ->
 
     // initialize result - calculate first iteration
     auto result = fun();
+    std::vector<decltype(fun())> values;
+    if (mode == Reduce::MEDIAN) values.push_back(result);
 
     // advance iterator and apply kernel to remaining iteration space
     while (++iter != end) {
@@ -232,11 +320,13 @@ auto Kernel<data_t>::reduce(Domain &domain, Reduce mode, const Function &fun) ->
                 result *= fun();
                 break;
             case Reduce::MEDIAN:
-                assert(0 && "HipaccMEDIAN not implemented yet!");
+                values.push_back(fun());
                 break;
         }
     }
 
+    if (mode == Reduce::MEDIAN) result = median(values);
+
     // de-register domain
     domain.setDI(nullptr);
 
@@ -36,6 +36,7 @@
 
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/Expr.h>
+#include <llvm/ADT/DenseMap.h>
 
 
 namespace clang {
@@ -89,6 +90,10 @@ BinaryOperator *createBinaryOperator(ASTContext &Ctx, Expr *lhs, Expr *rhs,
 CompoundAssignOperator *createCompoundAssignOperator(ASTContext &Ctx, Expr *lhs,
     Expr *rhs, BinaryOperator::Opcode opc, QualType ResTy);
 
+// creates an AST node for conditional operators: cond ? lhs : rhs
+ConditionalOperator *createConditionalOperator(ASTContext &Ctx, Expr *cond,
+    Expr *lhs, Expr *rhs, QualType T);
+
 // creates an AST node for paren expressions
 ParenExpr *createParenExpr(ASTContext &Ctx, Expr *val);
 
@@ -112,6 +117,12 @@ LabelDecl *createLabelDecl(ASTContext &Ctx, DeclContext *DC, StringRef Name);
 LabelStmt *createLabelStmt(ASTContext &Ctx, LabelDecl *LD, Stmt *Stmt);
 GotoStmt *createGotoStmt(ASTContext &Ctx, LabelDecl *LD);
 
+// get the value of a constant integer or floating point expression
+bool getConstantValue(ASTContext &Ctx, Expr *E, double &value);
+
+// count references to declarations (DeclRefExpr) and members (MemberExpr)
+void countReferences(Stmt *S, llvm::DenseMap<ValueDecl *, unsigned> &uses);
+
 } // end namespace ASTNode
 } // end namespace hipacc
 } // end namespace clang
@@ -34,11 +34,15 @@
 #ifndef _ASTTRANSLATE_H_
 #define _ASTTRANSLATE_H_
 
+#include <map>
+#include <tuple>
+
 #include <clang/AST/Attr.h>
 #include <clang/AST/Type.h>
 #include <clang/AST/StmtVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Sema/Ownership.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/ADT/SmallVector.h>
 
 #include "hipacc/Analysis/KernelStatistics.h"
@@ -100,8 +104,61 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     SmallVector<Reduce, 4> redModes;
     SmallVector<int, 4> redIdxX, redIdxY;
 
+    // median selection: values are collected in an array (sorting network) or
+    // counted in a histogram (8-bit data, large windows)
+    struct MedianInfo {
+      DeclRefExpr *values;
+      unsigned idx, size;
+      bool histogram;
+    };
+    SmallVector<MedianInfo, 4> medianInfos;
+
+    // C/C++: reductions over constant windows are computed incrementally from
+    // the state of the previous pixel and the column results of the previous
+    // row: running sums for sums with equal weights, van Herk/Gil-Werman for
+    // minimum and maximum
+    struct SlidingWindow {
+      Reduce mode;
+      Expr *term, *coeff;
+      bool border;
+      DeclRefExpr *cols, *rows, *last_x, *last_y;
+      // sum: window sum
+      DeclRefExpr *sum;
+      // min/max: position within the current block, prefix and suffix results
+      // of the block for the window and per column
+      DeclRefExpr *pos, *prefix, *suffix;
+      DeclRefExpr *col_pos, *col_prefix, *col_suffix;
+      // bytes of state allocated on the stack of the kernel
+      unsigned state_size;
+    };
+    llvm::DenseMap<CXXMemberCallExpr *, SlidingWindow> slidingWindows;
+
+    // C/C++: row pointers and border handled indices in y-direction depend
+    // only on gid_y for constant offsets and are computed once per row
+    bool hoistRows;
+    // row of the pixel computed by the current clone when several rows are
+    // computed per iteration; row pointers are shared between the clones
+    int rowOffsetY;
+    SmallVector<Stmt *, 16> rowStmts;
+    std::map<std::pair<HipaccAccessor *, int>, DeclRefExpr *> rowIndices;
+    std::map<std::tuple<HipaccAccessor *, int, bool>, DeclRefExpr *>
+      rowPointers;
+
+    // precomputation: expressions depending only on counters of loops with
+    // constant bounds are read from constant tables
+    struct LoopCounter {
+      VarDecl *var;
+      int lower, upper;
+    };
+    struct PrecomputedExpr {
+      HipaccMask *table;
+      LoopCounter counter_x, counter_y;
+    };
+    llvm::DenseMap<Expr *, PrecomputedExpr> precomputedExprs;
+
     DeclRefExpr *bh_start_left, *bh_start_right, *bh_start_top,
                 *bh_start_bottom, *bh_fall_back;
+    DeclRefExpr *row_start, *row_end;
     DeclRefExpr *outputImage;
     DeclRefExpr *retValRef;
     Expr *writeImageRHS;
@@ -157,6 +214,8 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     void setExprPropsClone(Expr *orig, Expr *clone);
     void setCastPath(CastExpr *orig, CXXCastPath &castPath);
     void initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S);
+    Stmt *createCPULoop(Expr *idx, Expr *lower, Expr *upper, Stmt *body, bool
+        vectorize=false);
     void initCUDA(SmallVector<Stmt *, 16> &kernelBody);
     void initOpenCL(SmallVector<Stmt *, 16> &kernelBody);
     void initRenderscript(SmallVector<Stmt *, 16> &kernelBody);
@@ -206,6 +265,14 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       Kernel->setUsed(bh_fall_back->getNameInfo().getAsString());
       return bh_fall_back;
     }
+    DeclRefExpr *getRowStart() {
+      Kernel->setUsed(row_start->getNameInfo().getAsString());
+      return row_start;
+    }
+    DeclRefExpr *getRowEnd() {
+      Kernel->setUsed(row_end->getNameInfo().getAsString());
+      return row_end;
+    }
 
     // KernelDeclMap - this keeps track of the cloned Decls which are used in
     // expressions, e.g. DeclRefExpr
@@ -227,24 +294,53 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     Expr *addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x, Expr
         *local_offset_y, HipaccAccessor *Acc, SmallVector<Stmt *, 16> &bhStmts,
         SmallVector<CompoundStmt *, 16> &bhCStmt);
-    Stmt *addClampUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool);
-    Stmt *addClampLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool);
-    Stmt *addRepeatUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool);
-    Stmt *addRepeatLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool);
-    Stmt *addMirrorUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool);
-    Stmt *addMirrorLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool);
+    Stmt *addIndexUpdate(Expr *idx, Expr *cond, Expr *val);
+    Stmt *addClampUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool,
+        bool);
+    Stmt *addClampLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool,
+        bool);
+    Stmt *addRepeatUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool,
+        bool);
+    Stmt *addRepeatLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool,
+        bool);
+    Stmt *addMirrorUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, bool,
+        bool);
+    Stmt *addMirrorLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, bool,
+        bool);
     Expr *addConstantUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper, Expr
         *cond);
     Expr *addConstantLower(HipaccAccessor *Acc, Expr *idx, Expr *lower, Expr
         *cond);
+    bool getOffsetRange(Expr *E, int &lower, int &upper);
+    void requiresBorderChecks(HipaccAccessor *Acc, Expr *local_offset, bool
+        dim_x, bool &lower, bool &upper);
+    bool isBoundedOffset(HipaccAccessor *Acc, Expr *local_offset, bool dim_x);
 
     // Convolution.cpp
     Stmt *getConvolutionStmt(Reduce mode, DeclRefExpr *tmp_var, Expr *ret_val);
     Expr *getInitExpr(Reduce mode, QualType QT);
+    Stmt *getMedianStmt(MedianInfo &median, DeclRefExpr *tmp_var);
+    void findSlidingWindows(Stmt *S, SmallVector<Stmt *, 16> &kernelBody);
+    Expr *getWindowTerm(SlidingWindow &window, int x, int y,
+        SmallVector<Stmt *, 16> &stmts);
+    Stmt *getRunningSumStmt(SlidingWindow &sum, HipaccMask *Mask, DeclRefExpr
+        *tmp_var);
+    Stmt *getMinMaxFilterStmt(SlidingWindow &window, HipaccMask *Mask,
+        DeclRefExpr *tmp_var);
+    Expr *accessArray(DeclRefExpr *arr, Expr *idx);
     Stmt *addDomainCheck(HipaccMask *Domain, DeclRefExpr *domain_var, Stmt
         *stmt);
     Expr *convertConvolution(CXXMemberCallExpr *E);
 
+    // Precompute.cpp
+    bool isKernelLocal(VarDecl *VD);
+    bool evaluateInvariant(Expr *E, llvm::DenseMap<VarDecl *, double> &values,
+        double &value, SmallPtrSetImpl<VarDecl *> *counters=nullptr);
+    bool getLoopCounter(ForStmt *S, LoopCounter &counter);
+    bool precomputeExpr(CallExpr *E, ArrayRef<LoopCounter> loops);
+    void findPrecomputableExprs(Stmt *S, SmallVectorImpl<LoopCounter> &loops);
+    Expr *accessPrecomputedExpr(Expr *E);
+
     // Interpolation.cpp
     Expr *addNNInterpolationX(HipaccAccessor *Acc, Expr *idx_x);
     Expr *addNNInterpolationY(HipaccAccessor *Acc, Expr *idx_y);
@@ -266,6 +362,10 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     Expr *accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc, MemoryAccess memAcc,
         Expr *offset_x=nullptr, Expr *offset_y=nullptr);
     Expr *accessMem2DAt(DeclRefExpr *LHS, Expr *idx_x, Expr *idx_y);
+    bool getRowOffset(Expr *local_offset_y, int &offset);
+    DeclRefExpr *getRowPointer(DeclRefExpr *LHS, HipaccAccessor *Acc, int
+        offset, Expr *idx_y, bool border);
+    Expr *accessMemRowAt(DeclRefExpr *row, Expr *idx_x);
     Expr *accessMemArrAt(DeclRefExpr *LHS, Expr *stride, Expr *idx_x, Expr
         *idx_y);
     Expr *accessMemAllocAt(DeclRefExpr *LHS, MemoryAccess memAcc,
@@ -325,11 +425,15 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       convTmp(nullptr),
       convIdxX(0),
       convIdxY(0),
+      hoistRows(false),
+      rowOffsetY(0),
       bh_start_left(nullptr),
       bh_start_right(nullptr),
       bh_start_top(nullptr),
       bh_start_bottom(nullptr),
       bh_fall_back(nullptr),
+      row_start(nullptr),
+      row_end(nullptr),
       outputImage(nullptr),
       retValRef(nullptr),
       writeImageRHS(nullptr),
@@ -79,6 +79,9 @@ class KernelStatistics : public ManagedAnalysis {
     MemoryAccessDetail getMemAccessDetail(const FieldDecl *FD);
     MemoryAccessDetail getOutAccessDetail();
     VectorInfo getVectorizeInfo(const VarDecl *VD);
+    // number of references to a variable other than loads of its value,
+    // e.g. assignments, increments, address-of, or reference bindings
+    unsigned getNumWrites(const VarDecl *VD);
     KernelType getKernelType();
 
     virtual ~KernelStatistics();
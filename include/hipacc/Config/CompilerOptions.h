@@ -78,10 +78,22 @@ class CompilerOptions {
     CompilerOption local_memory;
     CompilerOption multiple_pixels;
     CompilerOption vectorize_kernels;
+    CompilerOption multi_threading;
+    CompilerOption fuse_kernels;
+    CompilerOption separate_kernels;
+    CompilerOption specialize_kernels;
+    CompilerOption precompute_tables;
+    CompilerOption select_border_handling;
+    CompilerOption pad_halo;
+    CompilerOption cpu_tiling;
+    CompilerOption stream_execution;
     // user defined values for target code features
     int kernel_config_x, kernel_config_y;
     int align_bytes;
     int pixels_per_thread;
+    int num_threads;
+    int stream_rows;
+    int cpu_tile_x, cpu_tile_y;
     Texture texture_type;
     std::string rs_package_name;
 
@@ -118,10 +130,23 @@ class CompilerOptions {
       local_memory(AUTO),
       multiple_pixels(AUTO),
       vectorize_kernels(OFF),
+      multi_threading(AUTO),
+      fuse_kernels(OFF),
+      separate_kernels(OFF),
+      specialize_kernels(OFF),
+      precompute_tables(OFF),
+      select_border_handling(OFF),
+      pad_halo(OFF),
+      cpu_tiling(OFF),
+      stream_execution(OFF),
       kernel_config_x(128),
       kernel_config_y(1),
       align_bytes(0),
       pixels_per_thread(1),
+      num_threads(0),
+      stream_rows(0),
+      cpu_tile_x(0),
+      cpu_tile_y(0),
       texture_type(Texture::None),
       rs_package_name("org.hipacc.rs")
     {}
@@ -185,6 +210,50 @@ class CompilerOptions {
       return false;
     }
     int getPixelsPerThread() { return pixels_per_thread; }
+    bool multiThreading(CompilerOption option=(CompilerOption)(AUTO|ON|USER_ON))
+    {
+      if (multi_threading & option) return true;
+      return false;
+    }
+    int getNumThreads() { return num_threads; }
+    bool fuseKernels(CompilerOption option=(CompilerOption)(ON|USER_ON)) {
+      if (fuse_kernels & option) return true;
+      return false;
+    }
+    bool separateKernels(CompilerOption option=(CompilerOption)(ON|USER_ON)) {
+      if (separate_kernels & option) return true;
+      return false;
+    }
+    bool specializeKernels(CompilerOption option=(CompilerOption)(ON|USER_ON))
+    {
+      if (specialize_kernels & option) return true;
+      return false;
+    }
+    bool precomputeTables(CompilerOption option=(CompilerOption)(ON|USER_ON)) {
+      if (precompute_tables & option) return true;
+      return false;
+    }
+    bool selectBorderHandling(CompilerOption
+        option=(CompilerOption)(ON|USER_ON)) {
+      if (select_border_handling & option) return true;
+      return false;
+    }
+    bool padHalo(CompilerOption option=(CompilerOption)(ON|USER_ON)) {
+      if (pad_halo & option) return true;
+      return false;
+    }
+    bool cpuTiling(CompilerOption option=(CompilerOption)(ON|USER_ON)) {
+      if (cpu_tiling & option) return true;
+      return false;
+    }
+    int getCPUTileX() { return cpu_tile_x; }
+    int getCPUTileY() { return cpu_tile_y; }
+    bool streamExecution(CompilerOption option=(CompilerOption)(ON|USER_ON))
+    {
+      if (stream_execution & option) return true;
+      return false;
+    }
+    int getStreamRows() { return stream_rows; }
     std::string getRSPackageName() { return rs_package_name; }
 
     void setTargetLang(Language lang) { target_lang = lang; }
@@ -193,6 +262,15 @@ class CompilerOptions {
     void setTimeKernels(CompilerOption o) { time_kernels = o; }
     void setLocalMemory(CompilerOption o) { local_memory = o; }
     void setVectorizeKernels(CompilerOption o) { vectorize_kernels = o; }
+    void setFuseKernels(CompilerOption o) { fuse_kernels = o; }
+    void setSeparateKernels(CompilerOption o) { separate_kernels = o; }
+    void setSpecializeKernels(CompilerOption o) { specialize_kernels = o; }
+    void setPrecomputeTables(CompilerOption o) { precompute_tables = o; }
+    void setSelectBorderHandling(CompilerOption o) {
+      select_border_handling = o;
+    }
+    void setPadHalo(CompilerOption o) { pad_halo = o; }
+    void setCPUTiling(CompilerOption o) { cpu_tiling = o; }
 
     void setTextureMemory(Texture type) {
       texture_type = type;
@@ -218,6 +296,24 @@ class CompilerOptions {
       else multiple_pixels = USER_OFF;
     }
 
+    void setNumThreads(int threads) {
+      num_threads = threads;
+      if (threads != 1) multi_threading = USER_ON;
+      else multi_threading = USER_OFF;
+    }
+
+    void setCPUTileSize(int x, int y) {
+      cpu_tiling = USER_ON;
+      cpu_tile_x = x;
+      cpu_tile_y = y;
+    }
+
+    void setStreamRows(int rows) {
+      stream_rows = rows;
+      if (rows > 0) stream_execution = USER_ON;
+      else stream_execution = USER_OFF;
+    }
+
     void setRSPackageName(std::string name) {
       rs_package_name = name;
     }
@@ -276,6 +372,31 @@ class CompilerOptions {
       getOptionAsString(multiple_pixels, pixels_per_thread);
       llvm::errs() << "\n  Vectorization of kernels: ";
       getOptionAsString(vectorize_kernels);
+      if (emitC99()) {
+        llvm::errs() << "\n  Multi-threading of kernels: ";
+        getOptionAsString(multi_threading, num_threads);
+        llvm::errs() << "\n  Streaming execution in strips of rows: ";
+        getOptionAsString(stream_execution, stream_rows);
+        llvm::errs() << "\n  Cache-blocked tiling of local operators: ";
+        getOptionAsString(cpu_tiling);
+        if (cpuTiling() && cpu_tile_x) {
+          llvm::errs() << ": " << cpu_tile_x << "x" << cpu_tile_y;
+        }
+      }
+      llvm::errs() << "\n  Fusion of producer/consumer kernels: ";
+      getOptionAsString(fuse_kernels);
+      llvm::errs() << "\n  Separation of convolutions with rank-1 masks: ";
+      getOptionAsString(separate_kernels);
+      llvm::errs() << "\n  Specialization of kernels on constant arguments: ";
+      getOptionAsString(specialize_kernels);
+      llvm::errs() << "\n  Precomputation of loop-invariant expressions: ";
+      getOptionAsString(precompute_tables);
+      llvm::errs() << "\n  Branch-free border handling using selects: ";
+      getOptionAsString(select_border_handling);
+      if (emitC99()) {
+        llvm::errs() << "\n  Images padded with a halo filled by the boundary mode: ";
+        getOptionAsString(pad_halo);
+      }
       llvm::errs() << "\n\n";
     }
 };
@@ -40,6 +40,7 @@
 
 #include <clang/AST/ASTContext.h>
 
+#include <algorithm>
 #include <locale>
 #include <map>
 #include <set>
@@ -143,13 +144,40 @@ class HipaccMemory : public HipaccSize {
 class HipaccImage : public HipaccMemory {
   private:
     ASTContext &Ctx;
+    // physical halo filled according to the boundary mode
+    unsigned halo_x, halo_y;
+    Boundary halo_mode;
+    std::string halo_const;
+    // rows are read and written using callbacks
+    bool streamed;
 
   public:
     HipaccImage(ASTContext &Ctx, VarDecl *VD, QualType QT) :
       HipaccMemory(VD, VD->getNameAsString(), QT),
-      Ctx(Ctx)
+      Ctx(Ctx),
+      halo_x(0), halo_y(0),
+      halo_mode(Boundary::UNDEFINED),
+      halo_const(),
+      streamed(false)
     {}
 
+    void setHalo(unsigned x, unsigned y, Boundary mode, std::string
+        const_str) {
+      halo_x = x;
+      halo_y = y;
+      halo_mode = mode;
+      halo_const = const_str;
+    }
+    bool hasHalo() { return halo_x || halo_y; }
+    unsigned getHaloX() { return halo_x; }
+    unsigned getHaloY() { return halo_y; }
+    Boundary getHaloMode() { return halo_mode; }
+    const std::string &getHaloConst() const { return halo_const; }
+    void setStreamed() { streamed = true; }
+    bool isStreamed() { return streamed; }
+    // pixels per row including the halo
+    unsigned getStride() { return size_x + 2*halo_x; }
+    std::string getStrideStr() { return std::to_string(getStride()); }
     unsigned getPixelSize() { return Ctx.getTypeSize(type)/8; }
     std::string getTextureType();
     std::string getImageReadFunction();
@@ -206,6 +234,8 @@ class HipaccAccessor {
     Interpolate mode;
     std::string name;
     bool crop;
+    // region of interest, if known at compile time
+    unsigned roi_width, roi_height;
     // kernel parameter name for width, height, and stride
     DeclRefExpr *widthDecl, *heightDecl, *strideDecl, *scaleXDecl, *scaleYDecl;
     DeclRefExpr *offsetXDecl, *offsetYDecl;
@@ -217,11 +247,16 @@ class HipaccAccessor {
       mode(mode),
       name(VD->getNameAsString()),
       crop(crop),
+      roi_width(0), roi_height(0),
       widthDecl(nullptr), heightDecl(nullptr), strideDecl(nullptr),
       scaleXDecl(nullptr), scaleYDecl(nullptr),
       offsetXDecl(nullptr), offsetYDecl(nullptr)
     {}
 
+    void setROISize(unsigned width, unsigned height) {
+      roi_width = width;
+      roi_height = height;
+    }
     void setWidthDecl(DeclRefExpr *width) { widthDecl = width; }
     void setHeightDecl(DeclRefExpr *height) { heightDecl = height; }
     void setStrideDecl(DeclRefExpr *stride) { strideDecl = stride; }
@@ -238,6 +273,9 @@ class HipaccAccessor {
     unsigned getSizeY() { return bc->getSizeY(); }
     std::string getSizeXStr() { return bc->getSizeXStr(); }
     std::string getSizeYStr() { return bc->getSizeYStr(); }
+    // 0 if the region of interest is only known at run time
+    unsigned getROIWidth() { return roi_width; }
+    unsigned getROIHeight() { return roi_height; }
     DeclRefExpr *getWidthDecl() { return widthDecl; }
     DeclRefExpr *getHeightDecl() { return heightDecl; }
     DeclRefExpr *getStrideDecl() { return strideDecl; }
@@ -382,32 +420,56 @@ class HipaccKernelClass {
     };
 
     std::string name;
-    CXXMethodDecl *kernelFunction, *reduceFunction;
+    CXXMethodDecl *kernelFunction, *reduceFunction, *scanFunction;
+    CXXMethodDecl *binningFunction;
+    Stmt *kernelBody;
     KernelStatistics *kernelStatistics;
     // kernel member information
     SmallVector<KernelMemberInfo, 16> members;
     SmallVector<FieldDecl *, 16> imgFields;
     SmallVector<FieldDecl *, 16> maskFields;
     SmallVector<FieldDecl *, 16> domainFields;
+    // kernel fusion: producer kernel computing the pixels read by this kernel
+    // via fusedField; the pixel is passed in fusedVar instead of memory
+    HipaccKernelClass *producer;
+    FieldDecl *fusedField;
+    VarDecl *fusedVar;
 
   public:
     HipaccKernelClass(std::string name) :
       name(name),
       kernelFunction(nullptr),
       reduceFunction(nullptr),
+      scanFunction(nullptr),
+      binningFunction(nullptr),
+      kernelBody(nullptr),
       kernelStatistics(nullptr),
       members(0),
       imgFields(0),
       maskFields(0),
-      domainFields(0)
+      domainFields(0),
+      producer(nullptr),
+      fusedField(nullptr),
+      fusedVar(nullptr)
     {}
 
     const std::string &getName() const { return name; }
 
     void setKernelFunction(CXXMethodDecl *fun) { kernelFunction = fun; }
     void setReduceFunction(CXXMethodDecl *fun) { reduceFunction = fun; }
+    void setScanFunction(CXXMethodDecl *fun) { scanFunction = fun; }
+    void setBinningFunction(CXXMethodDecl *fun) { binningFunction = fun; }
     CXXMethodDecl *getKernelFunction() { return kernelFunction; }
     CXXMethodDecl *getReduceFunction() { return reduceFunction; }
+    CXXMethodDecl *getScanFunction() { return scanFunction; }
+    CXXMethodDecl *getBinningFunction() { return binningFunction; }
+
+    // body of the kernel function, overridden for fused kernels
+    void setKernelBody(Stmt *body) { kernelBody = body; }
+    Stmt *getKernelBody() {
+      if (kernelBody) return kernelBody;
+      return kernelFunction->getBody();
+    }
 
     void setKernelStatistics(KernelStatistics *stats) {
       kernelStatistics = stats;
@@ -416,16 +478,49 @@ class HipaccKernelClass {
       return *kernelStatistics;
     }
 
+    void setProducer(HipaccKernelClass *KC, FieldDecl *field, VarDecl *var) {
+      producer = KC;
+      fusedField = field;
+      fusedVar = var;
+    }
+    HipaccKernelClass *getProducer() { return producer; }
+    FieldDecl *getFusedField() { return fusedField; }
+    VarDecl *getFusedVar() { return fusedVar; }
+
+    bool isMember(FieldDecl *decl) {
+      for (auto member : members)
+        if (member.field == decl) return true;
+      return false;
+    }
+
+    // statistics of members taken over from a producer are provided by the
+    // producer's analysis
     MemoryAccess getImgAccess(FieldDecl *decl) {
+      if (producer && producer->isMember(decl))
+        return producer->getImgAccess(decl);
       return kernelStatistics->getMemAccess(decl);
     }
     MemoryAccessDetail getImgAccessDetail(FieldDecl *decl) {
+      if (producer && producer->isMember(decl))
+        return producer->getImgAccessDetail(decl);
       return kernelStatistics->getMemAccessDetail(decl);
     }
     VectorInfo getVectorizeInfo(VarDecl *decl) {
+      if (producer && decl->getParentFunctionOrMethod() ==
+          producer->getKernelFunction())
+        return producer->getVectorizeInfo(decl);
       return kernelStatistics->getVectorizeInfo(decl);
     }
+    unsigned getNumWrites(VarDecl *decl) {
+      if (producer && decl->getParentFunctionOrMethod() ==
+          producer->getKernelFunction())
+        return producer->getNumWrites(decl);
+      return kernelStatistics->getNumWrites(decl);
+    }
     KernelType getKernelType() {
+      if (producer)
+        return std::max(kernelStatistics->getKernelType(),
+                        producer->getKernelType());
       return kernelStatistics->getKernelType();
     }
 
@@ -449,6 +544,32 @@ class HipaccKernelClass {
       imgFields.push_back(FD);
     }
 
+    // add the members of another kernel class, except for the given field
+    void addMembers(HipaccKernelClass *KC, FieldDecl *skip) {
+      for (auto member : KC->members) {
+        if (member.field == skip) continue;
+        members.push_back(member);
+        switch (member.kind) {
+          case FieldKind::Normal:
+            break;
+          case FieldKind::IterationSpace:
+          case FieldKind::Image:
+            imgFields.push_back(member.field);
+            break;
+          case FieldKind::Mask:
+            maskFields.push_back(member.field);
+            break;
+        }
+      }
+    }
+
+    // change the pixel type of an image member, e.g. for kernels reading an
+    // intermediate image of different type
+    void setMemberType(FieldDecl *decl, QualType QT) {
+      for (auto &member : members)
+        if (member.field == decl) member.type = QT;
+    }
+
     ArrayRef<KernelMemberInfo> getMembers() { return members; }
     ArrayRef<FieldDecl *>  getImgFields() { return imgFields; }
     ArrayRef<FieldDecl *>  getMaskFields() { return maskFields; }
@@ -547,6 +668,15 @@ class HipaccKernelFeatures : public HipaccDevice {
     unsigned getPixelsPerThread() {
       return pixels_per_thread[KC->getKernelType()];
     }
+
+    // C/C++: number of vertically adjacent pixels computed per iteration of
+    // local operators; only enabled explicitly using -pixels-per-thread
+    unsigned getPixelsPerIterationCPU() {
+      if (!options.emitC99() || KC->getKernelType() != LocalOperator ||
+          !options.multiplePixelsPerThread(USER_ON))
+        return 1;
+      return getPixelsPerThread();
+    }
 };
 
 
@@ -555,7 +685,7 @@ class HipaccKernel : public HipaccKernelFeatures {
     ASTContext &Ctx;
     VarDecl *VD;
     std::string name;
-    std::string kernelName, reduceName;
+    std::string kernelName, reduceName, scanName, binningName;
     std::string fileName;
     std::string reduceStr, infoStr;
     unsigned infoStrCnt;
@@ -568,12 +698,16 @@ class HipaccKernel : public HipaccKernelFeatures {
     SmallVector<std::string, 16> deviceArgNames;
     SmallVector<FieldDecl *, 16> deviceArgFields;
     SmallVector<FunctionDecl *, 16> deviceFuncs;
+    SmallVector<HipaccMask *, 4> tables;
     std::set<std::string> usedVars;
+    std::map<FieldDecl *, Expr *> constArgs;
     unsigned max_threads_for_kernel;
     unsigned max_size_x, max_size_y;
     unsigned max_size_x_undef, max_size_y_undef;
     unsigned num_threads_x, num_threads_y;
     unsigned num_reg, num_lmem, num_smem, num_cmem;
+    // C/C++ streaming: rows read above/below the current pixel, -1 if unknown
+    int stream_offset_y;
 
     void calcSizes();
     void calcConfig();
@@ -595,6 +729,9 @@ class HipaccKernel : public HipaccKernelFeatures {
       name(VD->getNameAsString()),
       kernelName(options.getTargetPrefix() + KC->getName() + name + "Kernel"),
       reduceName(options.getTargetPrefix() + KC->getName() + name + "Reduce"),
+      scanName(options.getTargetPrefix() + KC->getName() + name + "Scan"),
+      binningName(options.getTargetPrefix() + KC->getName() + name +
+          "Binning"),
       fileName(options.getTargetPrefix() + KC->getName() + VD->getNameAsString()),
       reduceStr(), infoStr(),
       infoStrCnt(0),
@@ -607,6 +744,7 @@ class HipaccKernel : public HipaccKernelFeatures {
       deviceArgNames(),
       deviceArgFields(),
       deviceFuncs(),
+      tables(),
       max_threads_for_kernel(0),
       max_size_x(0), max_size_y(0),
       max_size_x_undef(0), max_size_y_undef(0),
@@ -615,7 +753,8 @@ class HipaccKernel : public HipaccKernelFeatures {
       num_reg(0),
       num_lmem(0),
       num_smem(0),
-      num_cmem(0)
+      num_cmem(0),
+      stream_offset_y(0)
     {
       switch (options.getTargetLang()) {
         default: break;
@@ -633,6 +772,8 @@ class HipaccKernel : public HipaccKernelFeatures {
     const std::string &getName() const { return name; }
     const std::string &getKernelName() const { return kernelName; }
     const std::string &getReduceName() const { return reduceName; }
+    const std::string &getScanName() const { return scanName; }
+    const std::string &getBinningName() const { return binningName; }
     const std::string &getFileName() const { return fileName; }
     void setInfoStr() {
       std::string cnt(std::to_string(infoStrCnt++));
@@ -647,6 +788,7 @@ class HipaccKernel : public HipaccKernelFeatures {
     void resetUsed() {
       usedVars.clear();
       deviceFuncs.clear();
+      tables.clear();
       for (auto map : imgMap)
         map.second->resetDecls();
     }
@@ -659,6 +801,10 @@ class HipaccKernel : public HipaccKernelFeatures {
     void addFunctionCall(FunctionDecl *FD) { deviceFuncs.push_back(FD); }
     ArrayRef<FunctionDecl *> getFunctionCalls() { return deviceFuncs; }
 
+    // keep track of constant tables precomputed for the kernel
+    void addTable(HipaccMask *table) { tables.push_back(table); }
+    ArrayRef<HipaccMask *> getTables() { return tables; }
+
     HipaccIterationSpace *getIterationSpace() { return iterationSpace; }
 
     void insertMapping(FieldDecl *decl, HipaccIterationSpace *iter) {
@@ -700,6 +846,16 @@ class HipaccKernel : public HipaccKernelFeatures {
       createArgInfo();
       return deviceArgNames;
     }
+    // kernel specialization: scalar members initialized with compile-time
+    // constants are replaced by their value
+    void specializeArgs(ArrayRef<Expr *> hostArgs);
+    Expr *getConstantArg(FieldDecl *decl) {
+      auto iter = constArgs.find(decl);
+
+      if (iter == constArgs.end()) return nullptr;
+      else return iter->second;
+    }
+
     void setHostArgNames(ArrayRef<Expr *> hostArgs, std::string &hostLiterals,
         unsigned &literalCount) {
       createArgInfo();
@@ -766,8 +922,15 @@ class HipaccKernel : public HipaccKernelFeatures {
     unsigned getMaxSizeYUndef() {
       return max_size_y_undef<=1?0:max_size_y_undef>>1;
     }
+    void addStreamOffsetY(int offset) {
+      if (stream_offset_y >= 0)
+        stream_offset_y = std::max(stream_offset_y, offset);
+    }
+    void setStreamOffsetYUnknown() { stream_offset_y = -1; }
+    int getStreamOffsetY() { return stream_offset_y; }
     unsigned getNumThreadsX() { return num_threads_x; }
     unsigned getNumThreadsY() { return num_threads_y; }
+    bool getCPUTileSize(unsigned &tile_x, unsigned &tile_y);
     unsigned getNumThreadsReduce() {
       return default_num_threads_x*default_num_threads_y;
     }
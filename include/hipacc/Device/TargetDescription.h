@@ -59,12 +59,40 @@ class HipaccDeviceOptions {
     unsigned pixels_per_thread[NumOperatorTypes];
     Texture require_textures[NumOperatorTypes];
     bool vectorization;
+    // CPU only device properties: SIMD width and cache sizes in bytes
+    unsigned simd_width;
+    unsigned l1_cache_size;
+    unsigned l2_cache_size;
+
+  private:
+    // lanes of vectorized kernels: the OpenCL/CUDA vectorizer emits 4-lane
+    // vector types, C/C++ loops use the SIMD width of the CPU
+    unsigned vector_width;
+    unsigned num_cores;
+    // threads executing C/C++ kernels, 0 uses all cores available at run time
+    unsigned cpu_threads;
+
+    // query SIMD width, cache sizes, and number of cores of the host CPU
+    void detectHostCPU();
+
+  protected:
+    // name, number of cores, and SIMD width of the host CPU
+    std::string getHostCPUName();
 
   public:
     HipaccDeviceOptions(CompilerOptions &options) :
       default_num_threads_x(128),
-      default_num_threads_y(1)
+      default_num_threads_y(1),
+      simd_width(0),
+      l1_cache_size(0),
+      l2_cache_size(0),
+      vector_width(4),
+      num_cores(0),
+      cpu_threads(options.getNumThreads())
     {
+      // C/C++ loops vectorized by the host compiler for CPU targets
+      bool simd_loops = false;
+
       switch (options.getTargetDevice()) {
         case Device::Tesla_10:
         case Device::Tesla_11:
@@ -172,6 +200,41 @@ class HipaccDeviceOptions {
           require_textures[UserOperator] = Texture::None;
           vectorization = true;
           break;
+        case Device::NativeCPU:
+        case Device::Haswell:
+        case Device::SkylakeSP:
+          if (options.getTargetDevice() == Device::NativeCPU) {
+            detectHostCPU();
+          } else if (options.getTargetDevice() == Device::Haswell) {
+            simd_width = 32;    // AVX2
+            l1_cache_size = 32768;
+            l2_cache_size = 262144;
+            num_cores = 4;
+          } else {
+            simd_width = 64;    // AVX-512
+            l1_cache_size = 32768;
+            l2_cache_size = 1048576;
+            num_cores = 28;
+          }
+          alignment = 64;       // cache line
+          // scratchpad memory is emulated in the caches on CPUs, staging
+          // pixels only adds copies and barriers
+          local_memory_threshold = 9999;
+          // one work-group row covers 16 SIMD vectors of 4-byte pixels
+          default_num_threads_x = 16 * simd_width / 4;
+          pixels_per_thread[PointOperator] = 1;
+          pixels_per_thread[LocalOperator] = simd_width >= 64 ? 8 : 4;
+          pixels_per_thread[GlobalOperator] = 32;
+          require_textures[PointOperator] = Texture::None;
+          require_textures[LocalOperator] = Texture::None;
+          require_textures[GlobalOperator] = Texture::None;
+          require_textures[UserOperator] = Texture::None;
+          // C/C++ loops are vectorized by the host compiler, the OpenCL CPU
+          // runtime vectorizes across work-items
+          simd_loops = options.emitC99();
+          vectorization = simd_loops;
+          if (simd_loops) vector_width = simd_width / 4;  // 4-byte pixels
+          break;
       }
 
       // deactivate for custom operators
@@ -211,10 +274,15 @@ class HipaccDeviceOptions {
 
       if (options.vectorizeKernels(USER_ON)) {
         vectorization = true;
-      } else if (options.vectorizeKernels((CompilerOption)(USER_OFF|OFF))) {
+      } else if (options.vectorizeKernels(USER_OFF) ||
+                 (options.vectorizeKernels(OFF) && !simd_loops)) {
         vectorization = false;
       }
     }
+
+    unsigned getVectorWidth() { return vector_width; }
+    unsigned getNumCores() { return num_cores; }
+    unsigned getCPUThreads() { return cpu_threads; }
 };
 
 
@@ -338,6 +406,20 @@ class HipaccDevice : public HipaccDeviceOptions {
           num_alus = 16; // 512 bit vector units - for single precision
           num_sfus = 0;
           break;
+        case Device::NativeCPU:
+        case Device::Haswell:
+        case Device::SkylakeSP:
+          // SIMD lanes for single precision
+          max_threads_per_warp = simd_width / 4;
+          max_blocks_per_multiprocessor = 1;
+          max_threads_per_block = 8192;
+          max_warps_per_multiprocessor = 8192 / max_threads_per_warp;
+          max_threads_per_multiprocessor = 8192;
+          max_total_registers = simd_width >= 64 ? 32 : 16;
+          max_total_shared_memory = l1_cache_size;
+          num_alus = simd_width / 4;
+          num_sfus = 0;
+          break;
       }
     }
 
@@ -363,6 +445,15 @@ class HipaccDevice : public HipaccDeviceOptions {
       }
     }
 
+    bool isCPU() {
+      switch (target_device) {
+        default:                return false;
+        case Device::NativeCPU:
+        case Device::Haswell:
+        case Device::SkylakeSP: return true;
+      }
+    }
+
     bool isNVIDIAGPU() {
       switch (target_device) {
         default:                return false;
@@ -379,7 +470,6 @@ class HipaccDevice : public HipaccDeviceOptions {
 
     std::string getTargetDeviceName() {
       switch (target_device) {
-        //case Device::CPU:             return "x86_64 CPU";
         case Device::Tesla_10:        return "NVIDIA Tesla (10)";
         case Device::Tesla_11:        return "NVIDIA Tesla (11)";
         case Device::Tesla_12:        return "NVIDIA Tesla (12)";
@@ -393,6 +483,10 @@ class HipaccDevice : public HipaccDeviceOptions {
         //case Device::SouthernIsland:  return "AMD Southern Island";
         case Device::Midgard:         return "ARM Midgard: Mali-T6xx";
         case Device::KnightsCorner:   return "Intel MIC: Knights Corner";
+        case Device::NativeCPU:
+          return getHostCPUName();
+        case Device::Haswell:         return "Intel Haswell: AVX2";
+        case Device::SkylakeSP:       return "Intel Skylake-SP: AVX-512";
       }
     }
 
@@ -51,7 +51,11 @@ enum class Device {
   NorthernIsland    = 69,
   //SouthernIsland    = 79
   Midgard           = 600,
-  KnightsCorner     = 7120
+  KnightsCorner     = 7120,
+  // x86-64 CPUs for the C/C++ and OpenCL (CPU) back ends
+  NativeCPU         = 1,
+  Haswell           = 4770,
+  SkylakeSP         = 8180
 };
 
 // texture memory specification
@@ -78,6 +78,9 @@ class CreateHostStrings {
     void writeReductionDeclaration(HipaccKernel *K, std::string &resultStr);
     void writeMemoryAllocation(HipaccImage *Img, std::string width, std::string
         height, std::string host, std::string &resultStr);
+    void writeMemoryAllocationStreamed(HipaccImage *Img, std::string width,
+        std::string height, std::string read, std::string write, std::string
+        &resultStr);
     void writeMemoryAllocationConstant(HipaccMask *Buf, std::string &resultStr);
     void writeMemoryTransfer(HipaccImage *Img, std::string mem,
         MemoryTransferDirection direction, std::string &resultStr);
@@ -96,6 +99,8 @@ class CreateHostStrings {
         HipaccKernel *K, std::string &resultStr);
     void writeReduceCall(HipaccKernelClass *KC, HipaccKernel *K, std::string
         &resultStr);
+    void writeScanCall(HipaccKernel *K, std::string &resultStr);
+    void writeBinningCall(HipaccKernel *K, std::string &resultStr);
     void writeInterpolationDefinition(HipaccKernel *K, HipaccAccessor *Acc,
         std::string function_name, std::string type_suffix, Interpolate ip_mode,
         Boundary bh_mode, std::string &resultStr);
@@ -301,6 +301,13 @@ CompoundAssignOperator *createCompoundAssignOperator(ASTContext &Ctx, Expr *lhs,
 }
 
 
+ConditionalOperator *createConditionalOperator(ASTContext &Ctx, Expr *cond,
+    Expr *lhs, Expr *rhs, QualType T) {
+  return new (Ctx) ConditionalOperator(cond, SourceLocation(), lhs,
+      SourceLocation(), rhs, T, VK_RValue, OK_Ordinary);
+}
+
+
 ParenExpr *createParenExpr(ASTContext &Ctx, Expr *val) {
   return new (Ctx) ParenExpr(SourceLocation(), SourceLocation(), val);
 }
@@ -333,6 +340,40 @@ GotoStmt *createGotoStmt(ASTContext &Ctx, LabelDecl *LD) {
   return new (Ctx) GotoStmt(LD, SourceLocation(), SourceLocation());
 }
 
+
+bool getConstantValue(ASTContext &Ctx, Expr *E, double &value) {
+  Expr::EvalResult val;
+  if (!E->EvaluateAsRValue(val, Ctx)) return false;
+
+  if (val.Val.isInt()) {
+    value = val.Val.getInt().getSExtValue();
+    return true;
+  }
+  if (val.Val.isFloat()) {
+    llvm::APFloat fval(val.Val.getFloat());
+    bool loses_info;
+    fval.convert(llvm::APFloat::IEEEdouble, llvm::APFloat::rmNearestTiesToEven,
+        &loses_info);
+    value = fval.convertToDouble();
+    return true;
+  }
+
+  return false;
+}
+
+
+void countReferences(Stmt *S, llvm::DenseMap<ValueDecl *, unsigned> &uses) {
+  if (!S) return;
+
+  if (auto DRE = dyn_cast<DeclRefExpr>(S))
+    uses[DRE->getDecl()]++;
+  if (auto ME = dyn_cast<MemberExpr>(S))
+    uses[ME->getMemberDecl()]++;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    countReferences(*it, uses);
+}
+
 } // end ASTNode namespace
 } // end hipacc namespace
 } // end clang namespace
@@ -161,30 +161,16 @@ T *ASTTranslate::lookup(std::string name, QualType QT, NamespaceDecl *NS) {
 void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   VarDecl *gid_x = nullptr, *gid_y = nullptr;
 
-  // C/C++: int gid_x = offset_x;
-  if (Kernel->getIterationSpace()->getOffsetXDecl()) {
-    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy,
-        getOffsetXDecl(Kernel->getIterationSpace()));
-  } else {
-    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy,
-        createIntegerLiteral(Ctx, 0));
-  }
-
-  // C/C++: int gid_y = offset_y;
-  if (Kernel->getIterationSpace()->getOffsetYDecl()) {
-    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
-        getOffsetYDecl(Kernel->getIterationSpace()));
-  } else {
-    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
-        createIntegerLiteral(Ctx, 0));
-  }
+  // C/C++: int gid_x, gid_y;
+  gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy, nullptr);
+  gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy, nullptr);
 
   // add gid_x and gid_y statements
   DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
   DC->addDecl(gid_x);
   DC->addDecl(gid_y);
-  DeclStmt *gid_x_stmt = createDeclStmt(Ctx, gid_x);
-  DeclStmt *gid_y_stmt = createDeclStmt(Ctx, gid_y);
+  kernelBody.push_back(createDeclStmt(Ctx, gid_x));
+  kernelBody.push_back(createDeclStmt(Ctx, gid_y));
 
   tileVars.global_id_x = createDeclRefExpr(Ctx, gid_x);
   tileVars.global_id_y = createDeclRefExpr(Ctx, gid_y);
@@ -199,55 +185,343 @@ void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   tileVars.local_size_y = createIntegerLiteral(Ctx, 0);
 
   // check if we need border handling
+  bool kernel_x = false;
+  bool kernel_y = false;
   if (KernelClass->getKernelType() != UserOperator) {
     for (auto img : KernelClass->getImgFields()) {
       HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
 
-      // check if we need border handling
       if (Acc->getBoundaryMode() != Boundary::UNDEFINED) {
-        if (Acc->getSizeX() > 1) {
-            bh_variant.borders.left = 1;
-            bh_variant.borders.right = 1;
-        }
-        if (Acc->getSizeY() > 1) {
-            bh_variant.borders.top = 1;
-            bh_variant.borders.bottom = 1;
-        }
+        if (Acc->getSizeX() > 1) kernel_x = true;
+        if (Acc->getSizeY() > 1) kernel_y = true;
       }
     }
   }
 
-  // convert the function body to kernel syntax
-  Stmt *clonedStmt = Clone(S);
-  assert(isa<CompoundStmt>(clonedStmt) && "CompoundStmt for kernel function body expected!");
-
-  //
-  // for (int gid_y=offset_y; gid_y<is_height+offset_y; gid_y++) {
-  //     for (int gid_x=offset_x; gid_x<is_width+offset_x; gid_x++) {
-  //         body
-  //     }
-  // }
-  //
+  // iteration space bounds:
+  // x: [offset_x, is_width+offset_x)
+  // y: [row_start+offset_y, row_end+offset_y)
+  // row_start and row_end select the rows of the iteration space assigned to
+  // the calling thread; the serial version passes 0 and is_height.
+  Expr *lower_x = createIntegerLiteral(Ctx, 0);
   Expr *upper_x = getWidthDecl(Kernel->getIterationSpace());
-  Expr *upper_y = getHeightDecl(Kernel->getIterationSpace());
+  Expr *lower_y = getRowStart();
+  Expr *upper_y = getRowEnd();
   if (Kernel->getIterationSpace()->getOffsetXDecl()) {
+    lower_x = getOffsetXDecl(Kernel->getIterationSpace());
     upper_x = createBinaryOperator(Ctx, upper_x,
         getOffsetXDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
   }
   if (Kernel->getIterationSpace()->getOffsetYDecl()) {
+    lower_y = createBinaryOperator(Ctx, lower_y,
+        getOffsetYDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
     upper_y = createBinaryOperator(Ctx, upper_y,
         getOffsetYDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
   }
-  ForStmt *innerLoop = createForStmt(Ctx, gid_x_stmt, createBinaryOperator(Ctx,
-        tileVars.global_id_x, upper_x, BO_LT, Ctx.BoolTy),
-      createUnaryOperator(Ctx, tileVars.global_id_x, UO_PostInc,
-        tileVars.global_id_x->getType()), clonedStmt);
-  ForStmt *outerLoop = createForStmt(Ctx, gid_y_stmt, createBinaryOperator(Ctx,
-        tileVars.global_id_y, upper_y, BO_LT, Ctx.BoolTy),
-      createUnaryOperator(Ctx, tileVars.global_id_y, UO_PostInc,
-        tileVars.global_id_y->getType()), innerLoop);
-
-  kernelBody.push_back(outerLoop);
+
+  // cache-blocked tiling: the loops over gid_y and gid_x iterate only over the
+  // block [_tile_y, _tile_end_y) x [_tile_x, _tile_end_x) of the iteration
+  // space
+  //
+  // for (_tile_y=lower_y; _tile_y<upper_y; _tile_y+=TILE_Y) {
+  //     int _tile_end_y = min(_tile_y+TILE_Y, upper_y);
+  //     for (_tile_x=lower_x; _tile_x<upper_x; _tile_x+=TILE_X) {
+  //         int _tile_end_x = min(_tile_x+TILE_X, upper_x);
+  //         loops
+  //     }
+  // }
+  //
+  unsigned tile_size_x = 0, tile_size_y = 0;
+  bool tiling = Kernel->getCPUTileSize(tile_size_x, tile_size_y);
+  Expr *loop_lower_x = lower_x, *loop_upper_x = upper_x;
+  Expr *loop_lower_y = lower_y, *loop_upper_y = upper_y;
+  SmallVector<Stmt *, 4> tileStmts;
+  auto createMin = [&] (Expr *lhs, Expr *rhs) -> Expr * {
+    return createConditionalOperator(Ctx, createBinaryOperator(Ctx, lhs, rhs,
+          BO_LT, Ctx.BoolTy), lhs, rhs, Ctx.IntTy);
+  };
+  auto createTileVar = [&] (StringRef name, Expr *init) -> DeclRefExpr * {
+    VarDecl *VD = createVarDecl(Ctx, kernelDecl, name, Ctx.IntTy, init);
+    DC->addDecl(VD);
+    if (init) tileStmts.push_back(createDeclStmt(Ctx, VD));
+    else kernelBody.push_back(createDeclStmt(Ctx, VD));
+    return createDeclRefExpr(Ctx, VD);
+  };
+  if (tiling) {
+    loop_lower_x = createTileVar("_tile_x", nullptr);
+    loop_lower_y = createTileVar("_tile_y", nullptr);
+    loop_upper_y = createTileVar("_tile_end_y", createMin(createBinaryOperator(
+            Ctx, loop_lower_y, createIntegerLiteral(Ctx, tile_size_y), BO_Add,
+            Ctx.IntTy), upper_y));
+    loop_upper_x = createTileVar("_tile_end_x", createMin(createBinaryOperator(
+            Ctx, loop_lower_x, createIntegerLiteral(Ctx, tile_size_x), BO_Add,
+            Ctx.IntTy), upper_x));
+  }
+  auto createTileLoops = [&] (Stmt *loops) -> Stmt * {
+    if (!tiling) return loops;
+
+    // tileStmts: _tile_end_y, _tile_end_x, and tile-local column bounds
+    SmallVector<Stmt *, 4> bodyX(tileStmts.begin() + 1, tileStmts.end());
+    bodyX.push_back(loops);
+    Stmt *loopX = createForStmt(Ctx, createBinaryOperator(Ctx, loop_lower_x,
+          lower_x, BO_Assign, Ctx.IntTy), createBinaryOperator(Ctx,
+          loop_lower_x, upper_x, BO_LT, Ctx.BoolTy), createBinaryOperator(Ctx,
+          loop_lower_x, createIntegerLiteral(Ctx, tile_size_x), BO_AddAssign,
+          Ctx.IntTy), createCompoundStmt(Ctx, bodyX));
+    Stmt *bodyY[] = { tileStmts[0], loopX };
+    return createForStmt(Ctx, createBinaryOperator(Ctx, loop_lower_y,
+          lower_y, BO_Assign, Ctx.IntTy), createBinaryOperator(Ctx,
+          loop_lower_y, upper_y, BO_LT, Ctx.BoolTy), createBinaryOperator(Ctx,
+          loop_lower_y, createIntegerLiteral(Ctx, tile_size_y), BO_AddAssign,
+          Ctx.IntTy), createCompoundStmt(Ctx, bodyY));
+  };
+
+  // statements depending only on gid_y, e.g. row pointers, are collected in
+  // rowStmts while cloning and precede the loops over gid_x:
+  // for (gid_y=...) { <row statements> for (gid_x=...) body }
+  hoistRows = true;
+  auto createRowBody = [&] (ArrayRef<Stmt *> loops) -> Stmt * {
+    SmallVector<Stmt *, 16> rowBody(rowStmts.begin(), rowStmts.end());
+    rowBody.append(loops.begin(), loops.end());
+    rowStmts.clear();
+    rowIndices.clear();
+    rowPointers.clear();
+    return createCompoundStmt(Ctx, rowBody);
+  };
+
+  // local operators may compute PPT vertically adjacent pixels per iteration:
+  // the body is cloned for gid_y+0 ... gid_y+PPT-1, the clones share the row
+  // pointers so that the host compiler can reuse pixels loaded for one row
+  // for the next rows. Rows not covered by a full group are computed singly.
+  //
+  // for (gid_y=...; gid_y<...; gid_y++) {
+  //     if (gid_y+PPT <= upper_y && <all rows are interior rows>) {
+  //         for (gid_x=...) { body<gid_y+0> ... body<gid_y+PPT-1> }
+  //         gid_y += PPT-1;
+  //     } else {
+  //         for (gid_x=...) body
+  //     }
+  // }
+  //
+  unsigned ppt = Kernel->getPixelsPerIterationCPU();
+
+  // sliding windows carry state from one pixel to the next and cannot be
+  // combined with multiple rows per iteration or vectorization
+  if (ppt == 1) findSlidingWindows(S, kernelBody);
+  bool vectorize = Kernel->vectorize() && slidingWindows.empty();
+  auto cloneRows = [&] (unsigned rows) -> Stmt * {
+    if (rows == 1) return Clone(S);
+
+    SmallVector<Stmt *, 8> clones;
+    for (unsigned p=0; p<rows; ++p) {
+      // clear all stored decls before cloning, otherwise existing VarDecls
+      // will be reused and we will miss declarations
+      KernelDeclMap.clear();
+      rowOffsetY = p;
+      gidYRef = p ? createBinaryOperator(Ctx, tileVars.global_id_y,
+          createIntegerLiteral(Ctx, (int32_t)p), BO_Add, Ctx.IntTy) :
+        tileVars.global_id_y;
+      clones.push_back(Clone(S));
+    }
+    rowOffsetY = 0;
+    gidYRef = tileVars.global_id_y;
+
+    return createCompoundStmt(Ctx, clones);
+  };
+  auto addMultiRows = [&] (Stmt *rowStmt, Stmt *multiRowStmt, Expr *cond) ->
+      Stmt * {
+    if (ppt == 1) return rowStmt;
+
+    Expr *end = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+          tileVars.global_id_y, createIntegerLiteral(Ctx, (int32_t)ppt),
+          BO_Add, Ctx.IntTy), loop_upper_y, BO_LE, Ctx.BoolTy);
+    if (cond) end = createBinaryOperator(Ctx, end, cond, BO_LAnd, Ctx.BoolTy);
+    Stmt *multiRow[] = { multiRowStmt, createBinaryOperator(Ctx,
+      tileVars.global_id_y, createIntegerLiteral(Ctx, (int32_t)(ppt-1)),
+      BO_AddAssign, Ctx.IntTy) };
+    return createIfStmt(Ctx, end, createCompoundStmt(Ctx, multiRow),
+        rowStmt);
+  };
+
+  if (!kernel_x && !kernel_y) {
+    //
+    // for (gid_y=row_start+offset_y; gid_y<row_end+offset_y; gid_y++) {
+    //     for (gid_x=offset_x; gid_x<is_width+offset_x; gid_x++) {
+    //         body
+    //     }
+    // }
+    //
+    auto createRowVariant = [&] (unsigned rows) -> Stmt * {
+      // convert the function body to kernel syntax
+      Stmt *clonedStmt = cloneRows(rows);
+      assert(isa<CompoundStmt>(clonedStmt) && "CompoundStmt for kernel function body expected!");
+      return createRowBody(createCPULoop(tileVars.global_id_x, loop_lower_x,
+            loop_upper_x, clonedStmt, vectorize));
+    };
+    Stmt *rowStmt = createRowVariant(1);
+    Stmt *multiRowStmt = ppt > 1 ? createRowVariant(ppt) : nullptr;
+
+    kernelBody.push_back(createTileLoops(createCPULoop(tileVars.global_id_y,
+            loop_lower_y, loop_upper_y, addMultiRows(rowStmt, multiRowStmt,
+              nullptr))));
+    hoistRows = false;
+
+    return;
+  }
+
+  //
+  // Border handling is only required within the halo of the iteration space:
+  // split the iteration space into the interior, the border strips, and the
+  // corners, each with its own code variant. The interior is computed without
+  // any boundary checks. bh_start_* denote the first row/column that requires
+  // no (left, top) or again (right, bottom) border handling.
+  //
+  // if (bh_fall_back) {
+  //     for (gid_y=...) for (gid_x=...) body<all borders>
+  // } else {
+  //     for (gid_y=row_start+offset_y; gid_y<row_end+offset_y; gid_y++) {
+  //         if (gid_y < bh_start_top) {
+  //             for (gid_x=offset_x; gid_x<bh_start_left; gid_x++) body<TL>
+  //             for (gid_x=bh_start_left; gid_x<bh_start_right; gid_x++) body<T>
+  //             for (gid_x=bh_start_right; gid_x<is_width+offset_x; gid_x++) body<TR>
+  //         } else if (gid_y >= bh_start_bottom) {
+  //             body<BL>, body<B>, body<BR>
+  //         } else {
+  //             body<L>, body<NO>, body<R>
+  //         }
+  //     }
+  // }
+  //
+
+  // fall back: in case the image is too small, use code variant with boundary
+  // handling for all borders
+  if (kernel_y) {
+    bh_variant.borders.top = 1;
+    bh_variant.borders.bottom = 1;
+  }
+  if (kernel_x) {
+    bh_variant.borders.left = 1;
+    bh_variant.borders.right = 1;
+  }
+  Stmt *clonedStmt = Clone(S);
+  assert(isa<CompoundStmt>(clonedStmt) && "CompoundStmt for kernel function body expected!");
+  Stmt *fallBackLoop = createCPULoop(tileVars.global_id_y, lower_y, upper_y,
+      createRowBody(createCPULoop(tileVars.global_id_x, lower_x, upper_x,
+          clonedStmt)));
+
+  // border columns within the current block:
+  // int _tile_bh_left = bh_start_left < _tile_x ? _tile_x :
+  //                     min(bh_start_left, _tile_end_x);
+  Expr *bh_left = nullptr, *bh_right = nullptr;
+  if (kernel_x) {
+    bh_left = getBHStartLeft();
+    bh_right = getBHStartRight();
+    if (tiling) {
+      auto createClamp = [&] (Expr *val) -> Expr * {
+        return createConditionalOperator(Ctx, createBinaryOperator(Ctx, val,
+              loop_lower_x, BO_LT, Ctx.BoolTy), loop_lower_x, createMin(val,
+                loop_upper_x), Ctx.IntTy);
+      };
+      bh_left = createTileVar("_tile_bh_left", createClamp(bh_left));
+      bh_right = createTileVar("_tile_bh_right", createClamp(bh_right));
+    }
+  }
+
+  // 0: top, 1: interior, 2: bottom rows
+  // 0: left, 1: interior, 2: right columns
+  auto createRowVariant = [&] (size_t r, unsigned rows) -> Stmt * {
+    Expr *col_bounds[4] = { loop_lower_x, loop_lower_x, loop_upper_x,
+                            loop_upper_x };
+    if (kernel_x) {
+      col_bounds[1] = bh_left;
+      col_bounds[2] = bh_right;
+    }
+
+    SmallVector<Stmt *, 16> rowBody;
+    for (size_t c=0; c<3; ++c) {
+      if (c!=1 && !kernel_x) continue;
+
+      // set border handling mode
+      bh_variant.borderVal = 0;
+      if (r==0) bh_variant.borders.top = 1;
+      if (r==2) bh_variant.borders.bottom = 1;
+      if (c==0) bh_variant.borders.left = 1;
+      if (c==2) bh_variant.borders.right = 1;
+
+      // clear all stored decls before cloning, otherwise existing VarDecls
+      // will be reused and we will miss declarations
+      KernelDeclMap.clear();
+      clonedStmt = cloneRows(rows);
+      assert(isa<CompoundStmt>(clonedStmt) && "CompoundStmt for kernel function body expected!");
+
+      // only the x-loop of the interior columns is free of x-dependent
+      // boundary checks and thus suited for vectorization, unless boundary
+      // checks are lowered to selects
+      bool simd = c==1 || compilerOptions.selectBorderHandling();
+      rowBody.push_back(createCPULoop(tileVars.global_id_x, col_bounds[c],
+            col_bounds[c+1], clonedStmt, simd && vectorize));
+    }
+    return createRowBody(rowBody);
+  };
+
+  Stmt *rowVariants[3] = { nullptr, nullptr, nullptr };
+  for (size_t r=0; r<3; ++r) {
+    if (r!=1 && !kernel_y) continue;
+    rowVariants[r] = createRowVariant(r, 1);
+  }
+  // groups of rows are computed only if all rows are interior rows
+  Stmt *multiRowVariant = nullptr;
+  Expr *multiRowCond = nullptr;
+  if (ppt > 1) {
+    multiRowVariant = createRowVariant(1, ppt);
+    if (kernel_y) {
+      multiRowCond = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+            tileVars.global_id_y, getBHStartTop(), BO_GE, Ctx.BoolTy),
+          createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+              tileVars.global_id_y, createIntegerLiteral(Ctx, (int32_t)ppt),
+              BO_Add, Ctx.IntTy), getBHStartBottom(), BO_LE, Ctx.BoolTy),
+          BO_LAnd, Ctx.BoolTy);
+    }
+  }
+  // reset image border configuration
+  bh_variant.borderVal = 0;
+  hoistRows = false;
+
+  Stmt *rowStmt = rowVariants[1];
+  if (kernel_y) {
+    // if (gid_y < bh_start_top) ... else if (gid_y >= bh_start_bottom) ...
+    // else ...
+    rowStmt = createIfStmt(Ctx, createBinaryOperator(Ctx,
+          tileVars.global_id_y, getBHStartTop(), BO_LT, Ctx.BoolTy),
+        rowVariants[0], createIfStmt(Ctx, createBinaryOperator(Ctx,
+            tileVars.global_id_y, getBHStartBottom(), BO_GE, Ctx.BoolTy),
+          rowVariants[2], rowVariants[1]));
+  }
+  rowStmt = addMultiRows(rowStmt, multiRowVariant, multiRowCond);
+  Stmt *splitLoop = createTileLoops(createCPULoop(tileVars.global_id_y,
+        loop_lower_y, loop_upper_y, rowStmt));
+
+  kernelBody.push_back(createIfStmt(Ctx, getBHFallBack(), fallBackLoop,
+        splitLoop));
+}
+
+
+// C/C++: for (idx=lower; idx<upper; idx++) body
+Stmt *ASTTranslate::createCPULoop(Expr *idx, Expr *lower, Expr *upper, Stmt
+    *body, bool vectorize) {
+  Stmt *loop = createForStmt(Ctx, createBinaryOperator(Ctx, idx, lower,
+        BO_Assign, idx->getType()), createBinaryOperator(Ctx, idx, upper,
+        BO_LT, Ctx.BoolTy), createUnaryOperator(Ctx, idx, UO_PostInc,
+        idx->getType()), body);
+
+  // mark loop for vectorization by the host compiler: the label is replaced
+  // by a HIPACC_SIMD_LOOP* macro (loop pragma) when the kernel is printed
+  if (vectorize) {
+    loop = createLabelStmt(Ctx, createLabelDecl(Ctx, kernelDecl,
+          "HIPACC_SIMD_LOOP"), loop);
+  }
+
+  return loop;
 }
 
 
@@ -589,6 +863,16 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
       continue;
     }
 
+    // search for row range parameters of multi-threaded CPU kernels
+    if (param->getName().equals("row_start")) {
+      row_start = parm_ref;
+      continue;
+    }
+    if (param->getName().equals("row_end")) {
+      row_end = parm_ref;
+      continue;
+    }
+
     if (compilerOptions.emitRenderscript() ||
         compilerOptions.emitFilterscript()) {
       // search for uint32_t x, uint32_t y parameters
@@ -639,6 +923,13 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
     }
   }
 
+  // search for math functions depending only on loop counters
+  if (compilerOptions.precomputeTables() &&
+      !(Kernel->vectorize() && !compilerOptions.emitC99())) {
+    SmallVector<LoopCounter, 4> loops;
+    findPrecomputableExprs(S, loops);
+  }
+
   // initialize target-specific variables and add gid_x and gid_y declarations
   // to kernel body
   DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
@@ -1539,6 +1830,9 @@ Stmt *ASTTranslate::VisitReturnStmtTranslate(ReturnStmt *S) {
 
 
 Expr *ASTTranslate::VisitCallExprTranslate(CallExpr *E) {
+  // read values of precomputed function calls from constant table
+  if (Expr *result = accessPrecomputedExpr(E)) return result;
+
   if (E->getDirectCallee()) {
     // lookup if this function call is supported and choose appropriate
     // function, e.g. exp() instead of expf() in case of OpenCL
@@ -1689,6 +1983,11 @@ Expr *ASTTranslate::VisitMemberExprTranslate(MemberExpr *E) {
   ValueDecl *VD = E->getMemberDecl();
   ValueDecl *paramDecl = nullptr;
 
+  // specialized kernel: use the constant passed to the kernel member
+  if (auto FD = dyn_cast<FieldDecl>(VD))
+    if (Expr *constArg = Kernel->getConstantArg(FD))
+      return Clone(constArg);
+
   // search for member name in kernel parameter list
   for (auto param : kernelDecl->params()) {
     // parameter name matches
@@ -1892,6 +2191,17 @@ Expr *ASTTranslate::VisitCXXOperatorCallExprTranslate(CXXOperatorCallExpr *E) {
   assert(isa<FieldDecl>(ME->getMemberDecl()) && "Image must be a C++-class member.");
   FieldDecl *FD = dyn_cast<FieldDecl>(ME->getMemberDecl());
 
+  // fused kernel: the pixel of the intermediate image was computed by the
+  // producer and is passed in a temporary
+  if (FD == KernelClass->getFusedField()) {
+    assert(E->getNumArgs()==1 &&
+        "only accesses without offset supported for fused images!");
+    result = Clone(createDeclRefExpr(Ctx, KernelClass->getFusedVar()));
+    setExprProps(E, result);
+
+    return result;
+  }
+
   // MemberExpr is converted to DeclRefExpr when cloning
   DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(Clone(E->getArg(0)));
 
@@ -2222,6 +2532,16 @@ Expr *ASTTranslate::VisitCXXMemberCallExprTranslate(CXXMemberCallExpr *E) {
     if (ME->getMemberNameInfo().getAsString() == "output") {
       assert(E->getNumArgs()==0 && "no arguments for output() method supported!");
 
+      // fused kernel: the producer writes its pixel to a temporary
+      if (KernelClass->getProducer() &&
+          ME->getBase()->IgnoreImpCasts()->getType()->getPointeeCXXRecordDecl()
+          == KernelClass->getProducer()->getKernelFunction()->getParent()) {
+        result = Clone(createDeclRefExpr(Ctx, KernelClass->getFusedVar()));
+        setExprProps(E, result);
+
+        return result;
+      }
+
       switch (compilerOptions.getTargetLang()) {
         case Language::Renderscript:
           if (Kernel->getPixelsPerThread() <= 1) {
@@ -2249,16 +2569,24 @@ Expr *ASTTranslate::VisitCXXMemberCallExprTranslate(CXXMemberCallExpr *E) {
     }
   } else if (isa<MemberExpr>(ME->getBase()->IgnoreImpCasts())) {
     // Accessor context -> use Accessor
-    // MemberExpr is converted to DeclRefExpr when cloning
-    LHS = dyn_cast<DeclRefExpr>(Clone(ME->getBase()->IgnoreImpCasts()));
-
     // find corresponding Image user class member variable
     MemberExpr *ImgAcc = dyn_cast<MemberExpr>(ME->getBase()->IgnoreImpCasts());
     FieldDecl *FD = dyn_cast<FieldDecl>(ImgAcc->getMemberDecl());
 
-    Acc = Kernel->getImgFromMapping(FD);
-    HipaccMask *Mask = Kernel->getMaskFromMapping(FD);
-    memAcc = KernelClass->getImgAccess(FD);
+    HipaccMask *Mask = nullptr;
+    if (FD == KernelClass->getFusedField()) {
+      // fused kernel: the intermediate image is computed on the iteration
+      // space of the consumer
+      Acc = Kernel->getIterationSpace();
+      memAcc = READ_ONLY;
+    } else {
+      // MemberExpr is converted to DeclRefExpr when cloning
+      LHS = dyn_cast<DeclRefExpr>(Clone(ME->getBase()->IgnoreImpCasts()));
+
+      Acc = Kernel->getImgFromMapping(FD);
+      Mask = Kernel->getMaskFromMapping(FD);
+      memAcc = KernelClass->getImgAccess(FD);
+    }
     assert((Acc || Mask) &&
            "Could not find Image/Accessor/Mask/Domain Field Decl.");
 
@@ -30,6 +30,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "hipacc/AST/ASTTranslate.h"
 
 using namespace clang;
@@ -37,73 +39,86 @@ using namespace hipacc;
 using namespace ASTNode;
 
 
+// update index: if (cond) idx = val; or branch-free: idx = cond ? val : idx;
+Stmt *ASTTranslate::addIndexUpdate(Expr *idx, Expr *cond, Expr *val) {
+  if (compilerOptions.selectBorderHandling()) {
+    return createBinaryOperator(Ctx, idx, createConditionalOperator(Ctx, cond,
+          val, idx, Ctx.IntTy), BO_Assign, Ctx.IntTy);
+  }
+
+  return createIfStmt(Ctx, cond, createBinaryOperator(Ctx, idx, val, BO_Assign,
+        Ctx.IntTy), nullptr, nullptr);
+}
+
+
 // add border handling: CLAMP
 Stmt *ASTTranslate::addClampUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper,
-    bool) {
+    bool, bool) {
   // if (idx >= upper) idx = upper-1;
   Expr *bo_upper = createBinaryOperator(Ctx, idx, upper, BO_GE, Ctx.BoolTy);
 
-  return createIfStmt(Ctx, bo_upper, createBinaryOperator(Ctx, idx,
-        createBinaryOperator(Ctx, upper, createIntegerLiteral(Ctx, 1), BO_Sub,
-          Ctx.IntTy), BO_Assign, Ctx.IntTy), nullptr, nullptr);
+  return addIndexUpdate(idx, bo_upper, createBinaryOperator(Ctx, upper,
+        createIntegerLiteral(Ctx, 1), BO_Sub, Ctx.IntTy));
 }
 Stmt *ASTTranslate::addClampLower(HipaccAccessor *Acc, Expr *idx, Expr *lower,
-    bool) {
+    bool, bool) {
   // if (idx < lower) idx = lower;
   Expr *bo_lower = createBinaryOperator(Ctx, idx, lower, BO_LT, Ctx.BoolTy);
 
-  return createIfStmt(Ctx, bo_lower, createBinaryOperator(Ctx, idx, lower,
-        BO_Assign, Ctx.IntTy), nullptr, nullptr);
+  return addIndexUpdate(idx, bo_lower, lower);
 }
 
 
 // add border handling: REPEAT
 Stmt *ASTTranslate::addRepeatUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper,
-    bool is_x) {
+    bool is_x, bool bounded) {
   // while (idx >= upper) idx -= is_width | is_height;
   Expr *bo_upper = createBinaryOperator(Ctx, idx, upper, BO_GE, Ctx.BoolTy);
   Expr *stride = is_x ? getWidthDecl(Acc) : getHeightDecl(Acc);
+  Expr *val = createBinaryOperator(Ctx, idx, stride, BO_Sub, Ctx.IntTy);
+
+  // a single wrap around suffices for offsets not exceeding the Accessor
+  if (bounded) return addIndexUpdate(idx, bo_upper, val);
 
   return createWhileStmt(Ctx, nullptr, bo_upper, createBinaryOperator(Ctx, idx,
-        createBinaryOperator(Ctx, idx, stride, BO_Sub, Ctx.IntTy), BO_Assign,
-        Ctx.IntTy));
+        val, BO_Assign, Ctx.IntTy));
 }
 Stmt *ASTTranslate::addRepeatLower(HipaccAccessor *Acc, Expr *idx, Expr *lower,
-    bool is_x) {
+    bool is_x, bool bounded) {
   // while (idx < lower) idx += is_width | is_height;
   Expr *bo_lower = createBinaryOperator(Ctx, idx, lower, BO_LT, Ctx.BoolTy);
   Expr *stride = is_x ? getWidthDecl(Acc) : getHeightDecl(Acc);
+  Expr *val = createBinaryOperator(Ctx, idx, stride, BO_Add, Ctx.IntTy);
+
+  // a single wrap around suffices for offsets not exceeding the Accessor
+  if (bounded) return addIndexUpdate(idx, bo_lower, val);
 
   return createWhileStmt(Ctx, nullptr, bo_lower, createBinaryOperator(Ctx, idx,
-        createBinaryOperator(Ctx, idx, stride, BO_Add, Ctx.IntTy), BO_Assign,
-        Ctx.IntTy));
+        val, BO_Assign, Ctx.IntTy));
 }
 
 
 // add border handling: MIRROR
 Stmt *ASTTranslate::addMirrorUpper(HipaccAccessor *Acc, Expr *idx, Expr *upper,
-    bool) {
+    bool, bool) {
   // if (idx >= upper) idx = upper - (idx+1 - upper);
   Expr *bo_upper = createBinaryOperator(Ctx, idx, upper, BO_GE, Ctx.BoolTy);
 
-  return createIfStmt(Ctx, bo_upper, createBinaryOperator(Ctx, idx,
-        createBinaryOperator(Ctx, upper, createParenExpr(Ctx,
-            createBinaryOperator(Ctx, createBinaryOperator(Ctx, idx,
-                createIntegerLiteral(Ctx, 1), BO_Add, Ctx.IntTy),
-              createParenExpr(Ctx, upper), BO_Sub, Ctx.IntTy)) , BO_Sub,
-          Ctx.IntTy), BO_Assign, Ctx.IntTy), nullptr, nullptr);
+  return addIndexUpdate(idx, bo_upper, createBinaryOperator(Ctx, upper,
+        createParenExpr(Ctx, createBinaryOperator(Ctx,
+            createBinaryOperator(Ctx, idx, createIntegerLiteral(Ctx, 1),
+              BO_Add, Ctx.IntTy), createParenExpr(Ctx, upper), BO_Sub,
+            Ctx.IntTy)), BO_Sub, Ctx.IntTy));
 }
 Stmt *ASTTranslate::addMirrorLower(HipaccAccessor *Acc, Expr *idx, Expr *lower,
-    bool) {
+    bool, bool) {
   // if (idx < lower) idx = lower + (lower - idx-1);
   Expr *bo_lower = createBinaryOperator(Ctx, idx, lower, BO_LT, Ctx.BoolTy);
 
-  return createIfStmt(Ctx, bo_lower, createBinaryOperator(Ctx, idx,
-        createBinaryOperator(Ctx, lower, createParenExpr(Ctx,
-            createBinaryOperator(Ctx, lower, createBinaryOperator(Ctx, idx,
-                createIntegerLiteral(Ctx, 1), BO_Sub, Ctx.IntTy), BO_Sub,
-              Ctx.IntTy)) , BO_Add, Ctx.IntTy), BO_Assign, Ctx.IntTy), nullptr,
-      nullptr);
+  return addIndexUpdate(idx, bo_lower, createBinaryOperator(Ctx, lower,
+        createParenExpr(Ctx, createBinaryOperator(Ctx, lower,
+            createBinaryOperator(Ctx, idx, createIntegerLiteral(Ctx, 1),
+              BO_Sub, Ctx.IntTy), BO_Sub, Ctx.IntTy)), BO_Add, Ctx.IntTy));
 }
 
 
@@ -132,6 +147,112 @@ Expr *ASTTranslate::addConstantLower(HipaccAccessor *Acc, Expr *idx, Expr
 }
 
 
+// interval analysis: get the range [lower, upper] of an offset composed of
+// integer constants, additions, subtractions, negations, and conditionals
+bool ASTTranslate::getOffsetRange(Expr *E, int &lower, int &upper) {
+  E = E->IgnoreParenImpCasts();
+
+  llvm::APSInt val;
+  if (E->EvaluateAsInt(val, Ctx)) {
+    lower = upper = val.getSExtValue();
+    return true;
+  }
+
+  // constant variables with initializer
+  if (auto DRE = dyn_cast<DeclRefExpr>(E)) {
+    auto VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (VD && VD->getType().isConstQualified() && VD->hasInit())
+      return getOffsetRange(VD->getInit(), lower, upper);
+    return false;
+  }
+
+  if (auto UO = dyn_cast<UnaryOperator>(E)) {
+    int lo, hi;
+    if (!getOffsetRange(UO->getSubExpr(), lo, hi)) return false;
+    switch (UO->getOpcode()) {
+      case UO_Plus:  lower = lo;  upper = hi;  return true;
+      case UO_Minus: lower = -hi; upper = -lo; return true;
+      default: return false;
+    }
+  }
+
+  if (auto BO = dyn_cast<BinaryOperator>(E)) {
+    int lhs_lo, lhs_hi, rhs_lo, rhs_hi;
+    if ((BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub) ||
+        !getOffsetRange(BO->getLHS(), lhs_lo, lhs_hi) ||
+        !getOffsetRange(BO->getRHS(), rhs_lo, rhs_hi))
+      return false;
+    if (BO->getOpcode() == BO_Add) {
+      lower = lhs_lo + rhs_lo;
+      upper = lhs_hi + rhs_hi;
+    } else {
+      lower = lhs_lo - rhs_hi;
+      upper = lhs_hi - rhs_lo;
+    }
+    return true;
+  }
+
+  if (auto CO = dyn_cast<ConditionalOperator>(E)) {
+    int true_lo, true_hi, false_lo, false_hi;
+    if (!getOffsetRange(CO->getTrueExpr(), true_lo, true_hi) ||
+        !getOffsetRange(CO->getFalseExpr(), false_lo, false_hi))
+      return false;
+    lower = std::min(true_lo, false_lo);
+    upper = std::max(true_hi, false_hi);
+    return true;
+  }
+
+  return false;
+}
+
+
+// check whether pixels accessed at the given offset can be outside the region
+// of interest of the Accessor at its lower (left, top) or upper (right,
+// bottom) border. Accessor coordinates are relative to the iteration space,
+// hence only negative offsets can underrun the Accessor, and positive offsets
+// overrun it only when exceeding the margin the Accessor has beyond the
+// iteration space. Only the C/C++ back end is considered, where no pixels
+// outside the iteration space are processed.
+void ASTTranslate::requiresBorderChecks(HipaccAccessor *Acc, Expr
+    *local_offset, bool dim_x, bool &lower, bool &upper) {
+  lower = upper = local_offset != nullptr;
+
+  int lo, hi;
+  if (!local_offset || !compilerOptions.emitC99() ||
+      Acc->getInterpolationMode() != Interpolate::NO ||
+      !getOffsetRange(local_offset, lo, hi))
+    return;
+
+  HipaccIterationSpace *IS = Kernel->getIterationSpace();
+  int acc_size = dim_x ? Acc->getROIWidth() : Acc->getROIHeight();
+  int is_size = dim_x ? IS->getROIWidth() : IS->getROIHeight();
+  int margin = acc_size && is_size ? std::max(acc_size - is_size, 0) : 0;
+
+  lower = lo < 0;
+  upper = hi > margin;
+}
+
+
+// check whether the offset is known to not exceed the size of the Accessor,
+// so that a single wrap around suffices for REPEAT. The index is in the range
+// [lo, is_size-1 + hi], hence the iteration space must not exceed the Accessor
+// either; both sizes have to be known at compile time.
+bool ASTTranslate::isBoundedOffset(HipaccAccessor *Acc, Expr *local_offset,
+    bool dim_x) {
+  int lo, hi;
+  if (!local_offset || !compilerOptions.emitC99() ||
+      Acc->getInterpolationMode() != Interpolate::NO ||
+      !getOffsetRange(local_offset, lo, hi))
+    return false;
+
+  HipaccIterationSpace *IS = Kernel->getIterationSpace();
+  int acc_size = dim_x ? Acc->getROIWidth() : Acc->getROIHeight();
+  int is_size = dim_x ? IS->getROIWidth() : IS->getROIHeight();
+  return acc_size && is_size && is_size <= acc_size && -lo <= acc_size &&
+    hi <= acc_size;
+}
+
+
 // add border handling statements to the AST
 Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     Expr *local_offset_y, HipaccAccessor *Acc) {
@@ -166,6 +287,13 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     upperY = getHeightDecl(Acc);
   }
 
+  // border checks required for the range of the offsets
+  bool check_left, check_right, check_top, check_bottom;
+  requiresBorderChecks(Acc, local_offset_x, true, check_left, check_right);
+  requiresBorderChecks(Acc, local_offset_y, false, check_top, check_bottom);
+  bool bounded_x = isBoundedOffset(Acc, local_offset_x, true);
+  bool bounded_y = isBoundedOffset(Acc, local_offset_y, false);
+
   Expr *idx_x = tileVars.global_id_x;
   Expr *idx_y = gidYRef;
 
@@ -212,6 +340,22 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     }
   }
 
+  // C/C++: for constant offsets, idx_y and its border handling depend only on
+  // gid_y and are computed once per row before the loop over gid_x
+  int row_offset = 0;
+  bool row_invariant = compilerOptions.emitC99() &&
+    Acc->getInterpolationMode() == Interpolate::NO &&
+    getRowOffset(local_offset_y, row_offset);
+  bool border_y = local_offset_y != nullptr;
+  auto addStmtY = [&] (Stmt *S) {
+    if (row_invariant) {
+      rowStmts.push_back(S);
+    } else {
+      bhStmts.push_back(S);
+      bhCStmt.push_back(curCStmt);
+    }
+  };
+
   // add temporary variables for updated idx_x and idx_y
   if (local_offset_x) {
     VarDecl *tmp_x = createVarDecl(Ctx, kernelDecl, gidx_str, Ctx.IntTy, idx_x);
@@ -222,11 +366,19 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
   }
 
   if (local_offset_y) {
-    VarDecl *tmp_y = createVarDecl(Ctx, kernelDecl, gidy_str, Ctx.IntTy, idx_y);
-    DC->addDecl(tmp_y);
-    idx_y = createDeclRefExpr(Ctx, tmp_y);
-    bhStmts.push_back(createDeclStmt(Ctx, tmp_y));
-    bhCStmt.push_back(curCStmt);
+    auto key = std::make_pair(Acc, row_offset);
+    if (row_invariant && rowIndices.count(key)) {
+      // border handling in y-direction has been added for this row already
+      idx_y = rowIndices[key];
+      border_y = false;
+    } else {
+      VarDecl *tmp_y = createVarDecl(Ctx, kernelDecl, gidy_str, Ctx.IntTy,
+          idx_y);
+      DC->addDecl(tmp_y);
+      idx_y = createDeclRefExpr(Ctx, tmp_y);
+      addStmtY(createDeclStmt(Ctx, tmp_y));
+      if (row_invariant) rowIndices[key] = dyn_cast<DeclRefExpr>(idx_y);
+    }
   }
 
   if (Acc->getBoundaryMode() == Boundary::CONSTANT) {
@@ -242,23 +394,54 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     bhCStmt.push_back(curCStmt);
 
     Expr *bo_constant = nullptr;
-    if (bh_variant.borders.right && local_offset_x) {
+    if (bh_variant.borders.right && check_right) {
       // < _gid_x<0> >= offset_x+width >
       bo_constant = addConstantUpper(Acc, idx_x, upperX, bo_constant);
     }
-    if (bh_variant.borders.bottom && local_offset_y) {
+    if (bh_variant.borders.bottom && check_bottom) {
       // if (_gid_y<0> >= offset_y+height)
       bo_constant = addConstantUpper(Acc, idx_y, upperY, bo_constant);
     }
-    if (bh_variant.borders.left && local_offset_x) {
+    if (bh_variant.borders.left && check_left) {
       // if (_gid_x<0> < offset_x)
       bo_constant = addConstantLower(Acc, idx_x, lowerX, bo_constant);
     }
-    if (bh_variant.borders.top && local_offset_y) {
+    if (bh_variant.borders.top && check_top) {
       // if (_gid_y<0> < offset_y)
       bo_constant = addConstantLower(Acc, idx_y, lowerY, bo_constant);
     }
 
+    // branch-free: load from clamped indices so that the load is always
+    // within the image, and select the constant afterwards
+    bool select_const = bo_constant && compilerOptions.selectBorderHandling();
+    auto clampIndex = [&] (Expr *idx, Expr *lower, Expr *upper, bool
+        check_lower, bool check_upper, std::string name) -> Expr * {
+      if (!check_lower && !check_upper) return idx;
+      // int _clamp_gid_[x|y]<0> = _gid_[x|y]<0>;
+      VarDecl *tmp = createVarDecl(Ctx, kernelDecl, name, Ctx.IntTy, idx);
+      DC->addDecl(tmp);
+      Expr *tmp_ref = createDeclRefExpr(Ctx, tmp);
+      bhStmts.push_back(createDeclStmt(Ctx, tmp));
+      bhCStmt.push_back(curCStmt);
+      if (check_upper) {
+        bhStmts.push_back(addClampUpper(Acc, tmp_ref, upper, false, false));
+        bhCStmt.push_back(curCStmt);
+      }
+      if (check_lower) {
+        bhStmts.push_back(addClampLower(Acc, tmp_ref, lower, false, false));
+        bhCStmt.push_back(curCStmt);
+      }
+      return tmp_ref;
+    };
+    if (select_const) {
+      idx_x = clampIndex(idx_x, lowerX, upperX, bh_variant.borders.left &&
+          check_left, bh_variant.borders.right && check_right,
+          "_clamp" + gidx_str);
+      idx_y = clampIndex(idx_y, lowerY, upperY, bh_variant.borders.top &&
+          check_top, bh_variant.borders.bottom && check_bottom,
+          "_clamp" + gidy_str);
+    }
+
     switch (compilerOptions.getTargetLang()) {
       case Language::C99:
           RHS = accessMem2DAt(LHS, idx_x, idx_y);
@@ -286,7 +469,13 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     setExprProps(LHS, RHS);
 
     // tmp<0> = RHS;
-    if (bo_constant) {
+    if (select_const) {
+      // tmp<0> = bo_constant ? RHS : tmp<0>;
+      bhStmts.push_back(createBinaryOperator(Ctx, tmp_t_ref,
+            createConditionalOperator(Ctx, bo_constant, RHS, tmp_t_ref,
+              tmp_t_ref->getType()), BO_Assign, tmp_t_ref->getType()));
+      bhCStmt.push_back(curCStmt);
+    } else if (bo_constant) {
       bhStmts.push_back(createIfStmt(Ctx, bo_constant, createBinaryOperator(Ctx,
                       tmp_t_ref, RHS, BO_Assign, tmp_t_ref->getType()), nullptr,
                   nullptr));
@@ -299,9 +488,9 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     result = tmp_t_ref;
   } else {
     Stmt *(clang::hipacc::ASTTranslate::*lowerFun)
-      (HipaccAccessor *Acc, Expr *idx, Expr *lower, bool) = nullptr;
+      (HipaccAccessor *Acc, Expr *idx, Expr *lower, bool, bool) = nullptr;
     Stmt *(clang::hipacc::ASTTranslate::*upperFun)
-      (HipaccAccessor *Acc, Expr *idx, Expr *upper, bool) = nullptr;
+      (HipaccAccessor *Acc, Expr *idx, Expr *upper, bool, bool) = nullptr;
     switch (Acc->getBoundaryMode()) {
       case Boundary::CLAMP:
         lowerFun = &clang::hipacc::ASTTranslate::addClampLower;
@@ -327,30 +516,37 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
     }
 
     if (upperFun) {
-      if (bh_variant.borders.right && local_offset_x) {
-        bhStmts.push_back((*this.*upperFun)(Acc, idx_x, upperX, true));
+      if (bh_variant.borders.right && check_right) {
+        bhStmts.push_back((*this.*upperFun)(Acc, idx_x, upperX, true,
+            bounded_x));
         bhCStmt.push_back(curCStmt);
       }
-      if (bh_variant.borders.bottom && local_offset_y) {
-        bhStmts.push_back((*this.*upperFun)(Acc, idx_y, upperY, false));
-        bhCStmt.push_back(curCStmt);
+      if (bh_variant.borders.bottom && border_y && check_bottom) {
+        addStmtY((*this.*upperFun)(Acc, idx_y, upperY, false,
+            bounded_y));
       }
     }
     if (lowerFun) {
-      if (bh_variant.borders.left && local_offset_x) {
-        bhStmts.push_back((*this.*lowerFun)(Acc, idx_x, lowerX, true));
+      if (bh_variant.borders.left && check_left) {
+        bhStmts.push_back((*this.*lowerFun)(Acc, idx_x, lowerX, true,
+            bounded_x));
         bhCStmt.push_back(curCStmt);
       }
-      if (bh_variant.borders.top && local_offset_y) {
-        bhStmts.push_back((*this.*lowerFun)(Acc, idx_y, lowerY, false));
-        bhCStmt.push_back(curCStmt);
+      if (bh_variant.borders.top && border_y && check_top) {
+        addStmtY((*this.*lowerFun)(Acc, idx_y, lowerY, false,
+            bounded_y));
       }
     }
 
     // get data
     switch (compilerOptions.getTargetLang()) {
       case Language::C99:
-          result = accessMem2DAt(LHS, idx_x, idx_y);
+          if (row_invariant) {
+            result = accessMemRowAt(getRowPointer(LHS, Acc, row_offset, idx_y,
+                  true), idx_x);
+          } else {
+            result = accessMem2DAt(LHS, idx_x, idx_y);
+          }
           break;
       case Language::CUDA:
         if (Kernel->useTextureMemory(Acc)!=Texture::None) {
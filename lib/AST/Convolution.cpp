@@ -31,6 +31,9 @@
 
 // includes for numeric_limits
 #include <limits>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include "hipacc/AST/ASTTranslate.h"
 
@@ -38,6 +41,10 @@ using namespace clang;
 using namespace hipacc;
 using namespace ASTNode;
 
+// maximal size in bytes of the state kept for all sliding windows of a
+// kernel, which is allocated on the stack of the kernel
+static const unsigned max_window_state = 64 << 10;
+
 
 // create expression for convolutions
 Stmt *ASTTranslate::getConvolutionStmt(Reduce mode, DeclRefExpr *tmp_var,
@@ -79,21 +86,194 @@ Stmt *ASTTranslate::getConvolutionStmt(Reduce mode, DeclRefExpr *tmp_var,
       result = createCompoundAssignOperator(Ctx, tmp_var, ret_val, BO_MulAssign,
           tmp_var->getType());
       break;
-    case Reduce::MEDIAN:
-      assert(0 && "Unsupported convolution mode.");
+    case Reduce::MEDIAN: {
+      assert(medianInfos.size() && "median selection not initialized");
+      MedianInfo &median = medianInfos.back();
+      if (median.histogram) {
+        // hist[val]++;
+        result = createUnaryOperator(Ctx, accessArray(median.values, ret_val),
+            UO_PostInc, median.values->getType()->getAsArrayTypeUnsafe()->
+            getElementType());
+      } else {
+        // vals[idx] = val;
+        result = createBinaryOperator(Ctx, accessArray(median.values,
+              createIntegerLiteral(Ctx, (int)median.idx)), ret_val, BO_Assign,
+            tmp_var->getType());
+      }
+      break; }
   }
 
   return result;
 }
 
 
+// array subscript: arr[idx]
+Expr *ASTTranslate::accessArray(DeclRefExpr *arr, Expr *idx) {
+  QualType QT = arr->getType()->getAsArrayTypeUnsafe()->getElementType();
+
+  return new (Ctx) ArraySubscriptExpr(createImplicitCastExpr(Ctx,
+        Ctx.getPointerType(QT), CK_ArrayToPointerDecay, arr, nullptr,
+        VK_RValue), idx, QT, VK_LValue, OK_Ordinary, SourceLocation());
+}
+
+
+// odd-even merge sort network (Batcher) for n elements; only comparators
+// required to place the element of rank n/2 are kept
+static std::vector<std::pair<unsigned, unsigned>> getMedianNetwork(unsigned n) {
+  std::vector<std::pair<unsigned, unsigned>> network, pruned;
+
+  unsigned size = 1;
+  while (size < n) size <<= 1;
+
+  for (unsigned p=1; p<size; p<<=1) {
+    for (unsigned k=p; k>=1; k>>=1) {
+      for (unsigned j=k%p; j+k<size; j+=2*k) {
+        for (unsigned i=0; i<k && i+j+k<size; ++i) {
+          if ((i+j)/(2*p) == (i+j+k)/(2*p)) {
+            // padded elements are +inf and never move
+            if (i+j+k < n) network.push_back(std::make_pair(i+j, i+j+k));
+          }
+        }
+      }
+    }
+  }
+
+  // walk backwards and keep only comparators the median depends on
+  std::vector<bool> needed(n, false);
+  needed[n/2] = true;
+  for (auto it=network.rbegin(); it!=network.rend(); ++it) {
+    if (needed[it->first] || needed[it->second]) {
+      pruned.push_back(*it);
+      needed[it->first] = needed[it->second] = true;
+    }
+  }
+  std::reverse(pruned.begin(), pruned.end());
+
+  return pruned;
+}
+
+
+// select the median from the values collected during unrolling
+Stmt *ASTTranslate::getMedianStmt(MedianInfo &median, DeclRefExpr *tmp_var) {
+  SmallVector<Stmt *, 16> stmts;
+  QualType QT = tmp_var->getType();
+  DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
+  std::string name(median.values->getNameInfo().getAsString());
+
+  if (median.histogram) {
+    // for (int _i=0; _i<256; ++_i) { _cnt += hist[_i]; _med += _cnt <= n/2; }
+    VarDecl *cnt_decl = createVarDecl(Ctx, kernelDecl, name + "_cnt", Ctx.IntTy,
+        createIntegerLiteral(Ctx, 0));
+    VarDecl *med_decl = createVarDecl(Ctx, kernelDecl, name + "_idx", Ctx.IntTy,
+        createIntegerLiteral(Ctx, 0));
+    VarDecl *idx_decl = createVarDecl(Ctx, kernelDecl, name + "_i", Ctx.IntTy,
+        createIntegerLiteral(Ctx, 0));
+    DC->addDecl(cnt_decl);
+    DC->addDecl(med_decl);
+    DC->addDecl(idx_decl);
+    DeclRefExpr *cnt = createDeclRefExpr(Ctx, cnt_decl);
+    DeclRefExpr *med = createDeclRefExpr(Ctx, med_decl);
+    DeclRefExpr *idx = createDeclRefExpr(Ctx, idx_decl);
+    stmts.push_back(createDeclStmt(Ctx, cnt_decl));
+    stmts.push_back(createDeclStmt(Ctx, med_decl));
+
+    SmallVector<Stmt *, 16> body;
+    body.push_back(createCompoundAssignOperator(Ctx, cnt,
+          createImplicitCastExpr(Ctx, Ctx.IntTy, CK_IntegralCast,
+            accessArray(median.values, idx), nullptr, VK_RValue),
+          BO_AddAssign, Ctx.IntTy));
+    body.push_back(createCompoundAssignOperator(Ctx, med,
+          createBinaryOperator(Ctx, cnt, createIntegerLiteral(Ctx,
+              (int)median.size/2), BO_LE, Ctx.IntTy), BO_AddAssign,
+          Ctx.IntTy));
+    stmts.push_back(createForStmt(Ctx, createDeclStmt(Ctx, idx_decl),
+          createBinaryOperator(Ctx, idx, createIntegerLiteral(Ctx, 256), BO_LT,
+            Ctx.BoolTy), createUnaryOperator(Ctx, idx, UO_PreInc, Ctx.IntTy),
+          createCompoundStmt(Ctx, body)));
+
+    // red = _med;
+    stmts.push_back(createBinaryOperator(Ctx, tmp_var,
+          createImplicitCastExpr(Ctx, QT, CK_IntegralCast, med, nullptr,
+            VK_RValue), BO_Assign, QT));
+  } else {
+    FunctionDecl *min_fun = lookup<FunctionDecl>(std::string("min"), QT,
+        hipaccMathNS);
+    FunctionDecl *max_fun = lookup<FunctionDecl>(std::string("max"), QT,
+        hipaccMathNS);
+    assert(min_fun && max_fun && "could not lookup 'min'/'max'");
+
+    auto network = getMedianNetwork(median.size);
+    // outputs of the comparators that are consumed later on
+    std::vector<bool> needed(median.size, false);
+    std::vector<std::pair<bool, bool>> used(network.size());
+    needed[median.size/2] = true;
+    for (size_t i=network.size(); i-->0; ) {
+      used[i] = std::make_pair(needed[network[i].first],
+                               needed[network[i].second]);
+      needed[network[i].first] = needed[network[i].second] = true;
+    }
+
+    VarDecl *swap_decl = nullptr;
+    for (size_t i=0; i<network.size(); ++i) {
+      auto getArgs = [&] () {
+        SmallVector<Expr *, 16> args;
+        args.push_back(createImplicitCastExpr(Ctx, QT, CK_LValueToRValue,
+              accessArray(median.values, createIntegerLiteral(Ctx,
+                  (int)network[i].first)), nullptr, VK_RValue));
+        args.push_back(createImplicitCastExpr(Ctx, QT, CK_LValueToRValue,
+              accessArray(median.values, createIntegerLiteral(Ctx,
+                  (int)network[i].second)), nullptr, VK_RValue));
+        return args;
+      };
+      Expr *lo = accessArray(median.values, createIntegerLiteral(Ctx,
+            (int)network[i].first));
+      Expr *hi = accessArray(median.values, createIntegerLiteral(Ctx,
+            (int)network[i].second));
+
+      if (used[i].first && used[i].second) {
+        // _swap = min(a, b); b = max(a, b); a = _swap;
+        if (!swap_decl) {
+          swap_decl = createVarDecl(Ctx, kernelDecl, name + "_swap", QT);
+          DC->addDecl(swap_decl);
+          stmts.push_back(createDeclStmt(Ctx, swap_decl));
+        }
+        DeclRefExpr *swap = createDeclRefExpr(Ctx, swap_decl);
+        stmts.push_back(createBinaryOperator(Ctx, swap, createFunctionCall(Ctx,
+                min_fun, getArgs()), BO_Assign, QT));
+        stmts.push_back(createBinaryOperator(Ctx, hi, createFunctionCall(Ctx,
+                max_fun, getArgs()), BO_Assign, QT));
+        stmts.push_back(createBinaryOperator(Ctx, lo,
+              createImplicitCastExpr(Ctx, QT, CK_LValueToRValue, swap, nullptr,
+                VK_RValue), BO_Assign, QT));
+      } else if (used[i].first) {
+        // a = min(a, b);
+        stmts.push_back(createBinaryOperator(Ctx, lo, createFunctionCall(Ctx,
+                min_fun, getArgs()), BO_Assign, QT));
+      } else {
+        // b = max(a, b);
+        stmts.push_back(createBinaryOperator(Ctx, hi, createFunctionCall(Ctx,
+                max_fun, getArgs()), BO_Assign, QT));
+      }
+    }
+
+    // red = vals[n/2];
+    stmts.push_back(createBinaryOperator(Ctx, tmp_var,
+          createImplicitCastExpr(Ctx, QT, CK_LValueToRValue,
+            accessArray(median.values, createIntegerLiteral(Ctx,
+                (int)median.size/2)), nullptr, VK_RValue), BO_Assign, QT));
+  }
+
+  return createCompoundStmt(Ctx, stmts);
+}
+
+
 template<typename T> T get_init(Reduce mode) {
   switch (mode) {
     case Reduce::SUM:    return 0;
     case Reduce::MIN:    return std::numeric_limits<T>::min();
     case Reduce::MAX:    return std::numeric_limits<T>::max();
     case Reduce::PROD:   return 1;
-    case Reduce::MEDIAN: assert(false && "median not yet supported");
+    case Reduce::MEDIAN: return 0;
   }
 }
 
@@ -224,6 +404,513 @@ Stmt *ASTTranslate::addDomainCheck(HipaccMask *Domain, DeclRefExpr *domain_var,
 }
 
 
+// get the term multiplied with the Mask coefficient if the lambda-function of
+// a convolution returns mask() * term or term * mask(); the term has to be
+// evaluated exactly when summed up before the multiplication
+static Expr *getConvolutionTerm(ASTContext &Ctx, LambdaExpr *LE,
+    FieldDecl *mask) {
+  auto body = dyn_cast<CompoundStmt>(LE->getBody());
+  if (!body || body->size() != 1 || !isa<ReturnStmt>(body->body_back()))
+    return nullptr;
+  Expr *ret_val = dyn_cast<ReturnStmt>(body->body_back())->getRetValue();
+  auto BO = ret_val ?
+    dyn_cast<BinaryOperator>(ret_val->IgnoreParenCasts()) : nullptr;
+  if (!BO || BO->getOpcode() != BO_Mul) return nullptr;
+
+  auto isMaskCall = [&] (Expr *E) {
+    auto call = dyn_cast<CXXOperatorCallExpr>(E->IgnoreParenCasts());
+    if (!call || call->getOperator() != OO_Call || call->getNumArgs() != 1)
+      return false;
+    auto ME = dyn_cast<MemberExpr>(call->getArg(0)->IgnoreImpCasts());
+    return ME && ME->getMemberDecl() == mask;
+  };
+
+  Expr *term = nullptr;
+  if (isMaskCall(BO->getLHS())) term = BO->getRHS();
+  else if (isMaskCall(BO->getRHS())) term = BO->getLHS();
+  if (!term) return nullptr;
+
+  // integer terms of floating point convolutions may overflow or wrap around
+  // when summed up in integer arithmetic
+  QualType QT = BO->getType();
+  QualType TT = term->IgnoreParenImpCasts()->getType();
+  if (QT->isVectorType()) QT = QT->getAs<VectorType>()->getElementType();
+  if (TT->isVectorType()) TT = TT->getAs<VectorType>()->getElementType();
+  if (QT->isRealFloatingType() && !TT->isRealFloatingType() &&
+      !Ctx.isPromotableIntegerType(TT))
+    return nullptr;
+
+  return term;
+}
+
+
+// get the Accessor read of a window sum, i.e. Input(mask) or Input(dom)
+static CXXOperatorCallExpr *getWindowAccess(Expr *E, FieldDecl *mask) {
+  auto call = dyn_cast<CXXOperatorCallExpr>(E->IgnoreParenImpCasts());
+  if (!call || call->getOperator() != OO_Call || call->getNumArgs() != 2)
+    return nullptr;
+  auto ME = dyn_cast<MemberExpr>(call->getArg(1)->IgnoreImpCasts());
+  if (!ME || ME->getMemberDecl() != mask) return nullptr;
+  return call;
+}
+
+
+// C/C++: search for convolutions and reductions over constant windows, which
+// are computed incrementally:
+// - sums with equal weights as running sums
+//   convolve(mask, Reduce::SUM, [&] () { return mask() * Input(mask); });
+//   reduce(dom, Reduce::SUM, [&] () { return Input(dom); });
+// - minimum/maximum over rectangular windows using van Herk/Gil-Werman
+//   reduce(dom, Reduce::MIN, [&] () { return Input(dom); });
+void ASTTranslate::findSlidingWindows(Stmt *S, SmallVector<Stmt *, 16>
+    &kernelBody) {
+  if (!S) return;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    findSlidingWindows(*it, kernelBody);
+
+  auto E = dyn_cast<CXXMemberCallExpr>(S);
+  if (!E || !E->getDirectCallee() || E->getNumArgs() != 3) return;
+  auto callee = dyn_cast<MemberExpr>(E->getCallee());
+  if (!callee || !isa<CXXThisExpr>(callee->getBase()->IgnoreImpCasts()))
+    return;
+  bool convolve = E->getDirectCallee()->getName().equals("convolve");
+  if (!convolve && !E->getDirectCallee()->getName().equals("reduce")) return;
+
+  auto ME = dyn_cast<MemberExpr>(E->getArg(0)->IgnoreImpCasts());
+  FieldDecl *FD = ME ? dyn_cast<FieldDecl>(ME->getMemberDecl()) : nullptr;
+  HipaccMask *Mask = FD ? Kernel->getMaskFromMapping(FD) : nullptr;
+  if (!Mask || !Mask->isConstant() || convolve == Mask->isDomain()) return;
+
+  // small windows are cheaper to unroll
+  if (Mask->getSizeX() * Mask->getSizeY() <= 9) return;
+
+  llvm::APSInt val;
+  if (!E->getArg(1)->EvaluateAsInt(val, Ctx)) return;
+  Reduce mode = static_cast<Reduce>(val.getZExtValue());
+  if (mode != Reduce::SUM && mode != Reduce::MIN && mode != Reduce::MAX)
+    return;
+
+  auto MTE = dyn_cast<MaterializeTemporaryExpr>(E->getArg(2));
+  LambdaExpr *LE = MTE ?
+    dyn_cast<LambdaExpr>(MTE->GetTemporaryExpr()->IgnoreImpCasts()) : nullptr;
+  if (!LE) return;
+
+  // the same term has to be reduced for all positions of the window
+  Expr *term = nullptr, *coeff = nullptr;
+  if (convolve && mode == Reduce::SUM) {
+    term = getConvolutionTerm(Ctx, LE, FD);
+    double first = 0;
+    if (!getConstantValue(Ctx, Mask->getInitExpr(0, 0), first) || first == 0)
+      term = nullptr;
+    for (size_t y=0; term && y<Mask->getSizeY(); ++y) {
+      for (size_t x=0; term && x<Mask->getSizeX(); ++x) {
+        double value;
+        if (!getConstantValue(Ctx, Mask->getInitExpr(x, y), value) ||
+            value != first)
+          term = nullptr;
+      }
+    }
+    if (first != 1) coeff = Mask->getInitExpr(0, 0);
+  } else {
+    auto body = dyn_cast<CompoundStmt>(LE->getBody());
+    if (body && body->size() == 1 && isa<ReturnStmt>(body->body_back()))
+      term = dyn_cast<ReturnStmt>(body->body_back())->getRetValue();
+    // non-rectangular Domains are unrolled
+    for (size_t y=0; term && Mask->isDomain() && y<Mask->getSizeY(); ++y)
+      for (size_t x=0; term && x<Mask->getSizeX(); ++x)
+        if (!Mask->isDomainDefined(x, y)) term = nullptr;
+  }
+  CXXOperatorCallExpr *access = term ? getWindowAccess(term, FD) : nullptr;
+  if (!access) return;
+
+  auto AME = dyn_cast<MemberExpr>(access->getArg(0)->IgnoreImpCasts());
+  FieldDecl *AFD = AME ? dyn_cast<FieldDecl>(AME->getMemberDecl()) : nullptr;
+  HipaccAccessor *Acc = AFD ? Kernel->getImgFromMapping(AFD) : nullptr;
+  if (!Acc || Acc->getInterpolationMode() != Interpolate::NO) return;
+
+  QualType QT;
+  if (mode == Reduce::SUM) {
+    // sum up integer pixels exactly
+    QT = access->getType().getUnqualifiedType();
+    if (!QT->isIntegerType()) return;
+    if (Ctx.isPromotableIntegerType(QT)) QT = Ctx.IntTy;
+  } else {
+    QT = LE->getCallOperator()->getReturnType().getUnqualifiedType();
+    if (!QT->isIntegerType() && !QT->isRealFloatingType()) return;
+    // types without min/max function, e.g. bool, are unrolled
+    if (!lookup<FunctionDecl>(std::string(mode == Reduce::MIN ? "min" :
+            "max"), QT, hipaccMathNS))
+      return;
+  }
+
+  // one column result per column of the iteration space and the window
+  // margins; column results are valid for row _rows[idx]-2
+  unsigned size_x = Mask->getSizeX(), size_y = Mask->getSizeY();
+  unsigned num_cols = Kernel->getIterationSpace()->getImage()->getStride() +
+    size_x;
+  // column results and rows, min/max keep in addition the position, prefix,
+  // and suffix results of the current block of each column
+  unsigned pixel_size = Ctx.getTypeSize(QT)/8;
+  unsigned state_size = num_cols * (pixel_size + 4);
+  if (mode != Reduce::SUM)
+    state_size += size_x*pixel_size + num_cols*(4 + (1 + size_y)*pixel_size);
+  unsigned total_size = state_size;
+  for (auto &window : slidingWindows) total_size += window.second.state_size;
+  if (total_size > max_window_state) return;
+
+  DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
+  std::string name((mode == Reduce::SUM ? "_sum" : mode == Reduce::MIN ?
+        "_min" : "_max") + std::to_string(slidingWindows.size()));
+  auto createDecl = [&] (std::string name, QualType QT, Expr *init) ->
+      DeclRefExpr * {
+    VarDecl *VD = createVarDecl(Ctx, kernelDecl, name, QT, init);
+    DC->addDecl(VD);
+    kernelBody.push_back(createDeclStmt(Ctx, VD));
+    return createDeclRefExpr(Ctx, VD);
+  };
+  auto getArrayType = [&] (QualType QT, unsigned size) -> QualType {
+    return Ctx.getConstantArrayType(QT, llvm::APInt(32, size),
+        ArrayType::Normal, 0);
+  };
+  SmallVector<Expr *, 16> initExprs;
+  initExprs.push_back(createIntegerLiteral(Ctx, 0));
+  QualType AT = getArrayType(Ctx.IntTy, num_cols);
+  Expr *init_list = new (Ctx) InitListExpr(Ctx, SourceLocation(), initExprs,
+      SourceLocation());
+  init_list->setType(AT);
+
+  // <type> _sumN_cols[width+size_x];
+  // int _sumN_rows[width+size_x] = { 0 }, _sumN_x = -2, _sumN_y = 0;
+  SlidingWindow info = {};
+  info.mode = mode;
+  info.term = access;
+  info.coeff = coeff;
+  info.border = Acc->getBoundaryMode() != Boundary::UNDEFINED;
+  info.state_size = state_size;
+  info.cols = createDecl(name + "_cols", getArrayType(QT, num_cols), nullptr);
+  info.rows = createDecl(name + "_rows", AT, init_list);
+  info.last_x = createDecl(name + "_x", Ctx.IntTy, createIntegerLiteral(Ctx,
+        -2));
+  info.last_y = createDecl(name + "_y", Ctx.IntTy, createIntegerLiteral(Ctx,
+        0));
+  if (mode == Reduce::SUM) {
+    // <type> _sumN = 0;
+    info.sum = createDecl(name, QT, createIntegerLiteral(Ctx, 0));
+  } else {
+    // int _minN_k = 0, _minN_col_k[width+size_x];
+    // <type> _minN_p, _minN_s[size_x];
+    // <type> _minN_col_p[width+size_x], _minN_col_s[width+size_x][size_y];
+    info.pos = createDecl(name + "_k", Ctx.IntTy, createIntegerLiteral(Ctx,
+          0));
+    info.prefix = createDecl(name + "_p", QT, nullptr);
+    info.suffix = createDecl(name + "_s", getArrayType(QT, size_x), nullptr);
+    info.col_pos = createDecl(name + "_col_k", getArrayType(Ctx.IntTy,
+          num_cols), nullptr);
+    info.col_prefix = createDecl(name + "_col_p", getArrayType(QT, num_cols),
+        nullptr);
+    info.col_suffix = createDecl(name + "_col_s", getArrayType(getArrayType(QT,
+            size_y), num_cols), nullptr);
+  }
+  slidingWindows[E] = info;
+}
+
+
+// read the term of a sliding window at the given position of the window;
+// statements required for border handling are added to stmts
+Expr *ASTTranslate::getWindowTerm(SlidingWindow &window, int x, int y,
+    SmallVector<Stmt *, 16> &stmts) {
+  CompoundStmt *outerCompountStmt = curCStmt;
+  size_t num_stmts = preStmts.size();
+  if (convMask) {
+    convIdxX = x;
+    convIdxY = y;
+  } else {
+    redIdxX.push_back(x);
+    redIdxY.push_back(y);
+  }
+  Expr *term = Clone(window.term);
+  if (!convMask) {
+    redIdxX.pop_back();
+    redIdxY.pop_back();
+  }
+  LambdaDeclMap.clear();
+  curCStmt = outerCompountStmt;
+
+  stmts.append(preStmts.begin() + num_stmts, preStmts.end());
+  preStmts.resize(num_stmts);
+  preCStmt.resize(num_stmts);
+  return term;
+}
+
+
+// C/C++: compute the window sum from the sum of the previous pixel in the row;
+// the sums of the window columns are in turn updated from the previous row
+//
+// if (_sumN_x == gid_x-1 && _sumN_y == gid_y) {
+//     _sumN -= _sumN_cols[gid_x];
+// } else {
+//     _sumN = 0;
+//     <update column 0>; _sumN += _sumN_cols[gid_x+1];
+//     ...
+// }
+// <update column size_x-1>; _sumN += _sumN_cols[gid_x+size_x];
+// _sumN_x = gid_x; _sumN_y = gid_y;
+// tmp = coeff * _sumN;
+Stmt *ASTTranslate::getRunningSumStmt(SlidingWindow &sum, HipaccMask *Mask,
+    DeclRefExpr *tmp_var) {
+  CompoundStmt *outerCompountStmt = curCStmt;
+  QualType QT = sum.sum->getType();
+  int size_x = Mask->getSizeX();
+  int size_y = Mask->getSizeY();
+
+  auto getColumn = [&] (int x) -> Expr * {
+    return createBinaryOperator(Ctx, tileVars.global_id_x,
+        createIntegerLiteral(Ctx, x+1), BO_Add, Ctx.IntTy);
+  };
+  auto getRow = [&] (int y) -> Expr * {
+    return createBinaryOperator(Ctx, gidYRef, createIntegerLiteral(Ctx, y),
+        BO_Add, Ctx.IntTy);
+  };
+
+  // update the sum of column x to the current row:
+  // if (_sumN_rows[idx] != gid_y+2) {
+  //     if (_sumN_rows[idx] == gid_y+1)
+  //         _sumN_cols[idx] += term(x, size_y-1) - term(x, -1);
+  //     else
+  //         _sumN_cols[idx] = term(x, 0) + ... + term(x, size_y-1);
+  //     _sumN_rows[idx] = gid_y+2;
+  // }
+  auto updateColumn = [&] (int x) -> Stmt * {
+    SmallVector<Stmt *, 16> slide, init;
+    Expr *add = getWindowTerm(sum, x, size_y-1, slide);
+    // the row leaving the window was read with border handling in case the
+    // previous row required it
+    border_variant variant = bh_variant;
+    if (sum.border) bh_variant.borders.top = 1;
+    Expr *sub = getWindowTerm(sum, x, -1, slide);
+    bh_variant = variant;
+    slide.push_back(createBinaryOperator(Ctx, accessArray(sum.cols,
+            getColumn(x)), createBinaryOperator(Ctx, add, sub, BO_Sub, QT),
+          BO_AddAssign, QT));
+
+    Expr *col = nullptr;
+    for (int y=0; y<size_y; ++y) {
+      Expr *term = getWindowTerm(sum, x, y, init);
+      col = col ? createBinaryOperator(Ctx, col, term, BO_Add, QT) : term;
+    }
+    init.push_back(createBinaryOperator(Ctx, accessArray(sum.cols,
+            getColumn(x)), col, BO_Assign, QT));
+
+    Stmt *update[] = {
+      createIfStmt(Ctx, createBinaryOperator(Ctx, accessArray(sum.rows,
+            getColumn(x)), getRow(1), BO_EQ, Ctx.BoolTy),
+        createCompoundStmt(Ctx, slide), createCompoundStmt(Ctx, init)),
+      createBinaryOperator(Ctx, accessArray(sum.rows, getColumn(x)),
+          getRow(2), BO_Assign, Ctx.IntTy) };
+    return createIfStmt(Ctx, createBinaryOperator(Ctx, accessArray(sum.rows,
+            getColumn(x)), getRow(2), BO_NE, Ctx.BoolTy),
+        createCompoundStmt(Ctx, update));
+  };
+  auto addColumn = [&] (int x) -> Stmt * {
+    return createBinaryOperator(Ctx, sum.sum, accessArray(sum.cols,
+          getColumn(x)), BO_AddAssign, QT);
+  };
+
+  SmallVector<Stmt *, 16> stmts, reset;
+  reset.push_back(createBinaryOperator(Ctx, sum.sum, createIntegerLiteral(Ctx,
+          0), BO_Assign, QT));
+  for (int x=0; x<size_x-1; ++x) {
+    reset.push_back(updateColumn(x));
+    reset.push_back(addColumn(x));
+  }
+  Expr *cond = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+        sum.last_x, createBinaryOperator(Ctx, tileVars.global_id_x,
+          createIntegerLiteral(Ctx, 1), BO_Sub, Ctx.IntTy), BO_EQ,
+        Ctx.BoolTy), createBinaryOperator(Ctx, sum.last_y, gidYRef, BO_EQ,
+          Ctx.BoolTy), BO_LAnd, Ctx.BoolTy);
+  stmts.push_back(createIfStmt(Ctx, cond, createBinaryOperator(Ctx, sum.sum,
+          accessArray(sum.cols, getColumn(-1)), BO_SubAssign, QT),
+        createCompoundStmt(Ctx, reset)));
+  stmts.push_back(updateColumn(size_x-1));
+  stmts.push_back(addColumn(size_x-1));
+  stmts.push_back(createBinaryOperator(Ctx, sum.last_x, tileVars.global_id_x,
+        BO_Assign, Ctx.IntTy));
+  stmts.push_back(createBinaryOperator(Ctx, sum.last_y, gidYRef, BO_Assign,
+        Ctx.IntTy));
+
+  Expr *result = sum.sum;
+  if (sum.coeff)
+    result = createBinaryOperator(Ctx, Clone(sum.coeff), result, BO_Mul,
+        tmp_var->getType());
+  stmts.push_back(createBinaryOperator(Ctx, tmp_var, result, BO_Assign,
+        tmp_var->getType()));
+  curCStmt = outerCompountStmt;
+
+  return createCompoundStmt(Ctx, stmts);
+}
+
+
+// C/C++: compute the minimum/maximum over a rectangular window using the van
+// Herk/Gil-Werman algorithm: the pixels of a row are partitioned into blocks
+// of size_x pixels, starting at the first pixel computed in the row. At the
+// start of a block, the window covers the whole block and the suffix results
+// of the block are stored; the window of the k-th pixel of a block consists of
+// suffix k of the block and prefix k-1 of the next block, which is extended by
+// one column per pixel:
+//
+// if (_minN_x == gid_x-1 && _minN_y == gid_y && ++_minN_k != size_x) {
+//     <update column size_x-1>
+//     _minN_p = _minN_k == 1 ? _minN_cols[gid_x+size_x-1] :
+//                              min(_minN_p, _minN_cols[gid_x+size_x-1]);
+//     tmp = min(_minN_s[_minN_k], _minN_p);
+// } else {
+//     _minN_k = 0;
+//     <update column size_x-1>
+//     _minN_s[size_x-1] = _minN_cols[gid_x+size_x-1];
+//     ...
+//     <update column 0>
+//     _minN_s[0] = min(_minN_cols[gid_x], _minN_s[1]);
+//     tmp = _minN_s[0];
+// }
+// _minN_x = gid_x; _minN_y = gid_y;
+//
+// The results of the window columns are computed the same way from the rows.
+Stmt *ASTTranslate::getMinMaxFilterStmt(SlidingWindow &window, HipaccMask
+    *Mask, DeclRefExpr *tmp_var) {
+  CompoundStmt *outerCompountStmt = curCStmt;
+  QualType QT = window.cols->getType()->getAsArrayTypeUnsafe()->
+    getElementType();
+  int size_x = Mask->getSizeX();
+  int size_y = Mask->getSizeY();
+
+  FunctionDecl *fun = lookup<FunctionDecl>(std::string(
+        window.mode == Reduce::MIN ? "min" : "max"), QT, hipaccMathNS);
+  assert(fun && "could not lookup 'min' or 'max'");
+  auto createMinMax = [&] (Expr *lhs, Expr *rhs) -> Expr * {
+    SmallVector<Expr *, 16> funArgs;
+    funArgs.push_back(lhs);
+    funArgs.push_back(rhs);
+    return createFunctionCall(Ctx, fun, funArgs);
+  };
+  auto createAssign = [&] (Expr *lhs, Expr *rhs) -> Expr * {
+    return createBinaryOperator(Ctx, lhs, rhs, BO_Assign, lhs->getType());
+  };
+  auto createLiteral = [&] (int val) -> Expr * {
+    return createIntegerLiteral(Ctx, val);
+  };
+  auto getColumn = [&] (int x) -> Expr * {
+    return createBinaryOperator(Ctx, tileVars.global_id_x, createLiteral(x),
+        BO_Add, Ctx.IntTy);
+  };
+  auto getRow = [&] (int y) -> Expr * {
+    return createBinaryOperator(Ctx, gidYRef, createLiteral(y), BO_Add,
+        Ctx.IntTy);
+  };
+  // _minN_col_s[idx][k]
+  auto getColSuffix = [&] (int x, Expr *k) -> Expr * {
+    Expr *col = accessArray(window.col_suffix, getColumn(x));
+    return new (Ctx) ArraySubscriptExpr(createImplicitCastExpr(Ctx,
+          Ctx.getPointerType(QT), CK_ArrayToPointerDecay, col, nullptr,
+          VK_RValue), k, QT, VK_LValue, OK_Ordinary, SourceLocation());
+  };
+
+  // extend the prefix of the next block by val and combine it with the stored
+  // suffix of the current block
+  auto slide = [&] (SmallVector<Stmt *, 16> &stmts, Expr *pos, Expr *prefix,
+      Expr *suffix, Expr *val) -> Expr * {
+    stmts.push_back(createAssign(prefix, createConditionalOperator(Ctx,
+            createBinaryOperator(Ctx, pos, createLiteral(1), BO_EQ,
+              Ctx.BoolTy), val, createMinMax(prefix, val), QT)));
+    return createMinMax(suffix, prefix);
+  };
+
+  // update the result of column x to the current row:
+  // if (_minN_rows[idx] != gid_y+2) {
+  //     if (_minN_rows[idx] == gid_y+1 && ++_minN_col_k[idx] != size_y) {
+  //         _minN_cols[idx] = term(x, size_y-1);
+  //         _minN_col_p[idx] = _minN_col_k[idx] == 1 ? _minN_cols[idx] :
+  //                            min(_minN_col_p[idx], _minN_cols[idx]);
+  //         _minN_cols[idx] = min(_minN_col_s[idx][_minN_col_k[idx]],
+  //                               _minN_col_p[idx]);
+  //     } else {
+  //         _minN_col_k[idx] = 0;
+  //         _minN_col_s[idx][size_y-1] = term(x, size_y-1);
+  //         ...
+  //         _minN_col_s[idx][0] = min(term(x, 0), _minN_col_s[idx][1]);
+  //         _minN_cols[idx] = _minN_col_s[idx][0];
+  //     }
+  //     _minN_rows[idx] = gid_y+2;
+  // }
+  auto updateColumn = [&] (int x) -> Stmt * {
+    Expr *col_pos = accessArray(window.col_pos, getColumn(x));
+    Expr *col = accessArray(window.cols, getColumn(x));
+
+    SmallVector<Stmt *, 16> next, start;
+    Expr *val = getWindowTerm(window, x, size_y-1, next);
+    next.push_back(createAssign(col, val));
+    val = slide(next, col_pos, accessArray(window.col_prefix, getColumn(x)),
+        getColSuffix(x, col_pos), col);
+    next.push_back(createAssign(col, val));
+
+    start.push_back(createAssign(col_pos, createLiteral(0)));
+    for (int y=size_y-1; y>=0; --y) {
+      val = getWindowTerm(window, x, y, start);
+      if (y < size_y-1)
+        val = createMinMax(val, getColSuffix(x, createLiteral(y+1)));
+      start.push_back(createAssign(getColSuffix(x, createLiteral(y)), val));
+    }
+    start.push_back(createAssign(col, getColSuffix(x, createLiteral(0))));
+
+    Expr *cond = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+          accessArray(window.rows, getColumn(x)), getRow(1), BO_EQ,
+          Ctx.BoolTy), createBinaryOperator(Ctx, createUnaryOperator(Ctx,
+            col_pos, UO_PreInc, Ctx.IntTy), createLiteral(size_y), BO_NE,
+          Ctx.BoolTy), BO_LAnd, Ctx.BoolTy);
+    Stmt *update[] = {
+      createIfStmt(Ctx, cond, createCompoundStmt(Ctx, next),
+          createCompoundStmt(Ctx, start)),
+      createAssign(accessArray(window.rows, getColumn(x)), getRow(2)) };
+    return createIfStmt(Ctx, createBinaryOperator(Ctx, accessArray(
+            window.rows, getColumn(x)), getRow(2), BO_NE, Ctx.BoolTy),
+        createCompoundStmt(Ctx, update));
+  };
+
+  SmallVector<Stmt *, 16> stmts, next, start;
+  next.push_back(updateColumn(size_x-1));
+  Expr *val = slide(next, window.pos, window.prefix, accessArray(window.suffix,
+        window.pos), accessArray(window.cols, getColumn(size_x-1)));
+  next.push_back(createAssign(tmp_var, val));
+
+  start.push_back(createAssign(window.pos, createLiteral(0)));
+  for (int x=size_x-1; x>=0; --x) {
+    start.push_back(updateColumn(x));
+    val = accessArray(window.cols, getColumn(x));
+    if (x < size_x-1)
+      val = createMinMax(val, accessArray(window.suffix, createLiteral(x+1)));
+    start.push_back(createAssign(accessArray(window.suffix, createLiteral(x)),
+          val));
+  }
+  start.push_back(createAssign(tmp_var, accessArray(window.suffix,
+          createLiteral(0))));
+
+  Expr *cond = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+        createBinaryOperator(Ctx, window.last_x, createBinaryOperator(Ctx,
+            tileVars.global_id_x, createLiteral(1), BO_Sub, Ctx.IntTy), BO_EQ,
+          Ctx.BoolTy), createBinaryOperator(Ctx, window.last_y, gidYRef,
+            BO_EQ, Ctx.BoolTy), BO_LAnd, Ctx.BoolTy), createBinaryOperator(Ctx,
+          createUnaryOperator(Ctx, window.pos, UO_PreInc, Ctx.IntTy),
+          createLiteral(size_x), BO_NE, Ctx.BoolTy), BO_LAnd, Ctx.BoolTy);
+  stmts.push_back(createIfStmt(Ctx, cond, createCompoundStmt(Ctx, next),
+        createCompoundStmt(Ctx, start)));
+  stmts.push_back(createAssign(window.last_x, tileVars.global_id_x));
+  stmts.push_back(createAssign(window.last_y, gidYRef));
+  curCStmt = outerCompountStmt;
+
+  return createCompoundStmt(Ctx, stmts);
+}
+
+
 // check if we have a convolve/reduce/iterate method and convert it
 Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
   enum class Method : uint8_t {
@@ -393,8 +1080,102 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
       break;
   }
 
+  // median: collect values in an array or in a histogram
+  bool median = (method==Method::Convolve && convMode==Reduce::MEDIAN) ||
+                (method==Method::Reduce && redModes.back()==Reduce::MEDIAN);
+  if (median) {
+    if (Mask->isDomain() && !Mask->isConstant()) {
+      unsigned DiagIDMedian = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+          "Median reduction requires a constant Domain.");
+      Diags.Report(E->getArg(0)->getExprLoc(), DiagIDMedian);
+      exit(EXIT_FAILURE);
+    }
+
+    unsigned num_values = 0;
+    for (size_t y=0; y<Mask->getSizeY(); ++y)
+      for (size_t x=0; x<Mask->getSizeX(); ++x)
+        if (!Mask->isDomain() || Mask->isDomainDefined(x, y)) ++num_values;
+
+    // use a histogram for 8-bit data and windows larger than 8x8
+    QualType QT = LE->getCallOperator()->getReturnType();
+    bool histogram = num_values > 64 && (QT->isSpecificBuiltinType(
+          BuiltinType::UChar) || QT->isSpecificBuiltinType(
+            BuiltinType::Char_U));
+    // the sorting network compares values using min/max
+    QualType UQT = QT.getUnqualifiedType();
+    if (!histogram && (!lookup<FunctionDecl>(std::string("min"), UQT,
+            hipaccMathNS) || !lookup<FunctionDecl>(std::string("max"), UQT,
+            hipaccMathNS))) {
+      unsigned DiagIDMedianType = Diags.getCustomDiagID(
+          DiagnosticsEngine::Error,
+          "Median reduction not supported for type %0.");
+      Diags.Report(E->getArg(0)->getExprLoc(), DiagIDMedianType) << QT;
+      exit(EXIT_FAILURE);
+    }
+
+    VarDecl *values_decl = nullptr;
+    if (histogram) {
+      // unsigned short _tmpN_hist[256] = { 0 };
+      SmallVector<Expr *, 16> initExprs;
+      initExprs.push_back(createIntegerLiteral(Ctx, 0));
+      QualType AT = Ctx.getConstantArrayType(Ctx.UnsignedShortTy,
+          llvm::APInt(32, 256), ArrayType::Normal, 0);
+      Expr *init_list = new (Ctx) InitListExpr(Ctx, SourceLocation(),
+          initExprs, SourceLocation());
+      init_list->setType(AT);
+      values_decl = createVarDecl(Ctx, kernelDecl, tmp_lit + "_hist", AT,
+          init_list);
+    } else {
+      // T _tmpN_vals[num_values];
+      QualType AT = Ctx.getConstantArrayType(QT, llvm::APInt(32, num_values),
+          ArrayType::Normal, 0);
+      values_decl = createVarDecl(Ctx, kernelDecl, tmp_lit + "_vals", AT);
+    }
+    DC->addDecl(values_decl);
+    preStmts.push_back(createDeclStmt(Ctx, values_decl));
+    preCStmt.push_back(outerCompountStmt);
+
+    MedianInfo info = { createDeclRefExpr(Ctx, values_decl), 0, num_values,
+                        histogram };
+    medianInfos.push_back(info);
+  }
+
+  // sliding windows replace the unrolled window
+  auto window = slidingWindows.find(E);
+  bool unroll = window == slidingWindows.end();
+  if (!unroll) {
+    if (window->second.mode == Reduce::SUM)
+      preStmts.push_back(getRunningSumStmt(window->second, Mask, tmp_dre));
+    else
+      preStmts.push_back(getMinMaxFilterStmt(window->second, Mask, tmp_dre));
+    preCStmt.push_back(outerCompountStmt);
+  }
+
+  // sums over constant Masks are folded at compile time: zero coefficients
+  // are skipped and terms with coefficients of the same magnitude are summed
+  // up before a single multiplication, which is omitted for +-1, e.g.
+  //    tmp += 2 * (p1 - p7); tmp += p0 + p2 - p6 - p8;
+  struct CoefficientGroup {
+    double magnitude;
+    Expr *pos_coeff, *neg_coeff;
+    SmallVector<Expr *, 16> pos_terms, neg_terms;
+  };
+  SmallVector<CoefficientGroup, 16> coeffGroups;
+  Expr *convTerm = nullptr;
+  if (unroll && method==Method::Convolve && convMode==Reduce::SUM &&
+      Mask->isConstant()) {
+    convTerm = getConvolutionTerm(Ctx, LE, FD);
+    for (size_t y=0; convTerm && y<Mask->getSizeY(); ++y) {
+      for (size_t x=0; convTerm && x<Mask->getSizeX(); ++x) {
+        double value;
+        if (!getConstantValue(Ctx, Mask->getInitExpr(x, y), value))
+          convTerm = nullptr;
+      }
+    }
+  }
+
   // unroll Mask/Domain
-  for (size_t y=0; y<Mask->getSizeY(); ++y) {
+  for (size_t y=0; unroll && y<Mask->getSizeY(); ++y) {
     for (size_t x=0; x<Mask->getSizeX(); ++x) {
       bool doIterate = true;
 
@@ -403,6 +1184,36 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
         doIterate = false;
       }
 
+      if (doIterate && convTerm) {
+        double value;
+        getConstantValue(Ctx, Mask->getInitExpr(x, y), value);
+        if (value == 0) continue;
+
+        CoefficientGroup *group = nullptr;
+        for (auto &coeffGroup : coeffGroups)
+          if (coeffGroup.magnitude == std::abs(value)) group = &coeffGroup;
+        if (!group) {
+          CoefficientGroup coeffGroup = { std::abs(value), nullptr, nullptr,
+                                          {}, {} };
+          coeffGroups.push_back(coeffGroup);
+          group = &coeffGroups.back();
+        }
+
+        convIdxX = x;
+        convIdxY = y;
+        curCStmt = outerCompountStmt;
+        Expr *term = Clone(convTerm);
+        if (value > 0) {
+          if (!group->pos_coeff) group->pos_coeff = Mask->getInitExpr(x, y);
+          group->pos_terms.push_back(term);
+        } else {
+          if (!group->neg_coeff) group->neg_coeff = Mask->getInitExpr(x, y);
+          group->neg_terms.push_back(term);
+        }
+        LambdaDeclMap.clear();
+        continue;
+      }
+
       if (doIterate) {
         Stmt *iteration = nullptr;
         switch (method) {
@@ -434,10 +1245,53 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
         preCStmt.push_back(outerCompountStmt);
         // clear decls added while cloning last iteration
         LambdaDeclMap.clear();
+        if (median) medianInfos.back().idx++;
       }
     }
   }
 
+  // emit one accumulation per coefficient magnitude
+  for (auto &group : coeffGroups) {
+    QualType QT = convTerm->getType();
+    auto sumTerms = [&] (ArrayRef<Expr *> terms) -> Expr * {
+      Expr *sum = nullptr;
+      for (auto term : terms)
+        sum = sum ? createBinaryOperator(Ctx, sum, term, BO_Add, QT) : term;
+      return sum;
+    };
+    Expr *pos_sum = sumTerms(group.pos_terms);
+    Expr *neg_sum = sumTerms(group.neg_terms);
+
+    Expr *sum = pos_sum;
+    BinaryOperator::Opcode opcode = BO_AddAssign;
+    if (pos_sum && neg_sum) {
+      if (group.neg_terms.size() > 1) neg_sum = createParenExpr(Ctx, neg_sum);
+      sum = createBinaryOperator(Ctx, pos_sum, neg_sum, BO_Sub, QT);
+    } else if (neg_sum) {
+      sum = neg_sum;
+    }
+
+    if (group.magnitude == 1) {
+      if (!pos_sum) opcode = BO_SubAssign;
+    } else {
+      Expr *coeff = Clone(pos_sum ? group.pos_coeff : group.neg_coeff);
+      if (group.pos_terms.size() + group.neg_terms.size() > 1)
+        sum = createParenExpr(Ctx, sum);
+      sum = createBinaryOperator(Ctx, coeff, sum, BO_Mul, tmp_dre->getType());
+    }
+
+    preStmts.push_back(createCompoundAssignOperator(Ctx, tmp_dre, sum, opcode,
+          tmp_dre->getType()));
+    preCStmt.push_back(outerCompountStmt);
+  }
+
+  // select median from collected values
+  if (median) {
+    preStmts.push_back(getMedianStmt(medianInfos.back(), tmp_dre));
+    preCStmt.push_back(outerCompountStmt);
+    medianInfos.pop_back();
+  }
+
   // reset global variables
   switch (method) {
     case Method::Convolve:
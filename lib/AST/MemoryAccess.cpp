@@ -98,6 +98,19 @@ Expr *ASTTranslate::accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc,
   Expr *idx_x = tileVars.global_id_x;
   Expr *idx_y = gidYRef;
 
+  // streaming execution: record the rows read around the current pixel;
+  // unknown offsets are bounded by the window of the Accessor, if any
+  if (compilerOptions.emitC99() && compilerOptions.streamExecution() &&
+      Acc!=Kernel->getIterationSpace() && local_offset_y) {
+    int lo, hi;
+    if (getOffsetRange(local_offset_y, lo, hi))
+      Kernel->addStreamOffsetY(std::max(-lo, hi));
+    else if (Acc->getSizeY() > 1)
+      Kernel->addStreamOffsetY(Acc->getSizeY()/2);
+    else
+      Kernel->setStreamOffsetYUnknown();
+  }
+
   // step 0: add local offset: gid_[x|y] + local_offset_[x|y]
   idx_x = addLocalOffset(idx_x, local_offset_x);
   idx_y = addLocalOffset(idx_y, local_offset_y);
@@ -160,8 +173,14 @@ Expr *ASTTranslate::accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc,
       }
     case READ_ONLY:
       switch (compilerOptions.getTargetLang()) {
-        case Language::C99:
+        case Language::C99: {
+          int offset;
+          if (Acc->getInterpolationMode() == Interpolate::NO &&
+              getRowOffset(local_offset_y, offset))
+            return accessMemRowAt(getRowPointer(LHS, Acc, offset, idx_y,
+                  false), idx_x);
           return accessMem2DAt(LHS, idx_x, idx_y);
+        }
         case Language::CUDA:
           if (Kernel->useTextureMemory(Acc)!=Texture::None) {
             return accessMemTexAt(LHS, Acc, memAcc, idx_x, idx_y);
@@ -239,6 +258,86 @@ Expr *ASTTranslate::accessMem2DAt(DeclRefExpr *LHS, Expr *idx_x, Expr *idx_y) {
 }
 
 
+// check if the expression refers to local variables, which are not declared
+// yet at the beginning of the kernel
+static bool referencesLocalVar(Stmt *S) {
+  if (!S) return false;
+
+  if (auto DRE = dyn_cast<DeclRefExpr>(S))
+    if (auto VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      if (VD->hasLocalStorage()) return true;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    if (referencesLocalVar(*it)) return true;
+
+  return false;
+}
+
+
+// C/C++: check if the offset in y-direction is constant, so that the row
+// accessed depends only on gid_y; the offset must consist of literals and
+// specialized constants only, since the row pointer is declared before any
+// statement of the kernel
+bool ASTTranslate::getRowOffset(Expr *local_offset_y, int &offset) {
+  if (!hoistRows) return false;
+
+  offset = rowOffsetY;
+  if (local_offset_y) {
+    llvm::APSInt val;
+    if (referencesLocalVar(local_offset_y) ||
+        !local_offset_y->EvaluateAsInt(val, Ctx))
+      return false;
+    offset += val.getSExtValue();
+  }
+
+  return true;
+}
+
+
+// C/C++: get pointer to the row accessed at idx_y, which is declared once per
+// row before the loop over gid_x: <type> *_row<name><n> = <name>[idx_y];
+DeclRefExpr *ASTTranslate::getRowPointer(DeclRefExpr *LHS, HipaccAccessor
+    *Acc, int offset, Expr *idx_y, bool border) {
+  auto key = std::make_tuple(Acc, offset, border);
+  auto iter = rowPointers.find(key);
+  if (iter != rowPointers.end()) return iter->second;
+
+  QualType QT = LHS->getType();
+  QualType QT2 = QT->getPointeeType()->getAsArrayTypeUnsafe()->getElementType();
+
+  // mark image as being used within the kernel
+  Kernel->setUsed(LHS->getNameInfo().getAsString());
+
+  Expr *row = new (Ctx) ArraySubscriptExpr(createImplicitCastExpr(Ctx, QT,
+        CK_LValueToRValue, LHS, nullptr, VK_RValue), idx_y,
+      QT->getPointeeType(), VK_LValue, OK_Ordinary, SourceLocation());
+  row = createImplicitCastExpr(Ctx, Ctx.getPointerType(QT2),
+      CK_ArrayToPointerDecay, row, nullptr, VK_RValue);
+
+  VarDecl *row_decl = createVarDecl(Ctx, kernelDecl, "_row" +
+      LHS->getNameInfo().getAsString() + std::to_string(rowPointers.size()),
+      Ctx.getPointerType(QT2), row);
+  DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
+  DC->addDecl(row_decl);
+  rowStmts.push_back(createDeclStmt(Ctx, row_decl));
+
+  DeclRefExpr *result = createDeclRefExpr(Ctx, row_decl);
+  rowPointers[key] = result;
+
+  return result;
+}
+
+
+// C/C++: access row pointer at given index
+Expr *ASTTranslate::accessMemRowAt(DeclRefExpr *row, Expr *idx_x) {
+  QualType QT = row->getType();
+
+  return new (Ctx) ArraySubscriptExpr(createImplicitCastExpr(Ctx, QT,
+        CK_LValueToRValue, row, nullptr, VK_RValue), idx_x,
+      QT->getPointeeType(), VK_LValue, OK_Ordinary, SourceLocation());
+}
+
+
 // get tex1Dfetch function for given Accessor
 FunctionDecl *ASTTranslate::getTextureFunction(HipaccAccessor *Acc, MemoryAccess
     memAcc) {
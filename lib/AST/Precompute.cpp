@@ -0,0 +1,359 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+//===--- Precompute.cpp - Precompute Loop-Invariant Expressions -----------===//
+//
+// This file implements the precomputation of expressions that depend only on
+// counters of loops with constant bounds, e.g. the spatial weights
+// expf(-c_d*xf*xf) of the bilateral filter. The values are computed at compile
+// time and stored in constant tables, which are indexed by the loop counters.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cmath>
+
+#include "hipacc/AST/ASTTranslate.h"
+
+using namespace clang;
+using namespace hipacc;
+using namespace ASTNode;
+
+// maximal number of table entries, tables are stored in constant memory
+static const int max_table_size = 1024;
+
+
+// evaluate math function with constant arguments
+static bool evaluateMathFunction(StringRef name, ArrayRef<double> args,
+    double &value) {
+  // single precision variants are evaluated in double precision
+  if (name.size() > 1 && name.back() == 'f') name = name.drop_back();
+
+  if (args.size() == 1) {
+    double arg = args[0];
+    if      (name == "exp")   value = std::exp(arg);
+    else if (name == "exp2")  value = std::exp2(arg);
+    else if (name == "log")   value = std::log(arg);
+    else if (name == "log2")  value = std::log2(arg);
+    else if (name == "log10") value = std::log10(arg);
+    else if (name == "sqrt")  value = std::sqrt(arg);
+    else if (name == "cbrt")  value = std::cbrt(arg);
+    else if (name == "sin")   value = std::sin(arg);
+    else if (name == "cos")   value = std::cos(arg);
+    else if (name == "tan")   value = std::tan(arg);
+    else if (name == "atan")  value = std::atan(arg);
+    else if (name == "tanh")  value = std::tanh(arg);
+    else if (name == "fabs")  value = std::fabs(arg);
+    else return false;
+    return true;
+  }
+
+  if (args.size() == 2) {
+    if      (name == "pow")   value = std::pow(args[0], args[1]);
+    else if (name == "atan2") value = std::atan2(args[0], args[1]);
+    else if (name == "hypot") value = std::hypot(args[0], args[1]);
+    else return false;
+    return true;
+  }
+
+  return false;
+}
+
+
+// variables declared within the kernel function; variables of lambda-functions
+// are not covered by the write analysis of fused kernels
+bool ASTTranslate::isKernelLocal(VarDecl *VD) {
+  if (isa<ParmVarDecl>(VD) || !VD->hasLocalStorage()) return false;
+
+  auto FD = VD->getParentFunctionOrMethod();
+  if (FD == KernelClass->getKernelFunction()) return true;
+  if (KernelClass->getProducer() &&
+      FD == KernelClass->getProducer()->getKernelFunction()) return true;
+
+  return false;
+}
+
+
+// evaluate expression consisting of literals, loop counters, variables that
+// are not written after their initialization, and scalar kernel members
+// specialized to constants; the loop counters used are added to counters
+bool ASTTranslate::evaluateInvariant(Expr *E, llvm::DenseMap<VarDecl *, double>
+    &values, double &value, SmallPtrSetImpl<VarDecl *> *counters) {
+  E = E->IgnoreParens();
+  QualType QT = E->getType();
+  bool valid = false;
+
+  if (auto IL = dyn_cast<IntegerLiteral>(E)) {
+    value = IL->getValue().getSExtValue();
+    valid = true;
+  } else if (auto FL = dyn_cast<FloatingLiteral>(E)) {
+    value = FL->getValueAsApproximateDouble();
+    valid = true;
+  } else if (auto CE = dyn_cast<CastExpr>(E)) {
+    switch (CE->getCastKind()) {
+      default: break;
+      case CK_LValueToRValue:
+      case CK_NoOp:
+      case CK_IntegralCast:
+      case CK_IntegralToFloating:
+      case CK_FloatingToIntegral:
+      case CK_FloatingCast:
+        valid = evaluateInvariant(CE->getSubExpr(), values, value, counters);
+        break;
+    }
+  } else if (auto UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() == UO_Minus || UO->getOpcode() == UO_Plus) {
+      valid = evaluateInvariant(UO->getSubExpr(), values, value, counters);
+      if (UO->getOpcode() == UO_Minus) value = -value;
+    }
+  } else if (auto BO = dyn_cast<BinaryOperator>(E)) {
+    double lhs, rhs;
+    if (evaluateInvariant(BO->getLHS(), values, lhs, counters) &&
+        evaluateInvariant(BO->getRHS(), values, rhs, counters)) {
+      valid = true;
+      switch (BO->getOpcode()) {
+        default: valid = false; break;
+        case BO_Add: value = lhs + rhs; break;
+        case BO_Sub: value = lhs - rhs; break;
+        case BO_Mul: value = lhs * rhs; break;
+        case BO_Div:
+          if (rhs == 0) valid = false;
+          else value = lhs / rhs;
+          break;
+      }
+    }
+  } else if (auto DRE = dyn_cast<DeclRefExpr>(E)) {
+    if (auto VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+      auto iter = values.find(VD);
+      if (iter != values.end()) {
+        value = iter->second;
+        if (counters) counters->insert(VD);
+        valid = true;
+      } else if (VD->hasInit() && isKernelLocal(VD) &&
+          !VD->getType()->isReferenceType() &&
+          !KernelClass->getNumWrites(VD)) {
+        valid = evaluateInvariant(VD->getInit(), values, value, counters);
+      }
+    }
+  } else if (auto ME = dyn_cast<MemberExpr>(E)) {
+    if (auto FD = dyn_cast<FieldDecl>(ME->getMemberDecl()))
+      if (Expr *constArg = Kernel->getConstantArg(FD))
+        valid = evaluateInvariant(constArg, values, value, counters);
+  } else if (auto CE = dyn_cast<CallExpr>(E)) {
+    FunctionDecl *FD = CE->getDirectCallee();
+    if (FD && FD->getIdentifier() && !isa<CXXMethodDecl>(FD)) {
+      SmallVector<double, 2> args;
+      for (auto arg : CE->arguments()) {
+        double val;
+        if (!evaluateInvariant(arg, values, val, counters)) return false;
+        args.push_back(val);
+      }
+      valid = evaluateMathFunction(FD->getName(), args, value);
+    }
+  }
+
+  if (!valid || !std::isfinite(value)) return false;
+
+  // round to the precision of the expression
+  if (QT->isIntegerType()) {
+    value = std::trunc(value);
+  } else if (QT->isSpecificBuiltinType(BuiltinType::Float)) {
+    value = static_cast<float>(value);
+  } else if (!QT->isRealFloatingType()) {
+    return false;
+  }
+
+  return true;
+}
+
+
+// get counter and constant bounds of loops like
+//    for (int xf = lower; xf <= upper; xf++)
+bool ASTTranslate::getLoopCounter(ForStmt *S, LoopCounter &counter) {
+  auto DS = dyn_cast_or_null<DeclStmt>(S->getInit());
+  if (!DS || !DS->isSingleDecl()) return false;
+  auto VD = dyn_cast<VarDecl>(DS->getSingleDecl());
+  if (!VD || !VD->hasInit() || !VD->getType()->isIntegerType() ||
+      !isKernelLocal(VD) || KernelClass->getNumWrites(VD) != 1)
+    return false;
+
+  // the counter is incremented by one and written only by the increment
+  auto inc = dyn_cast_or_null<UnaryOperator>(S->getInc());
+  auto inc_ref = inc ?
+    dyn_cast<DeclRefExpr>(inc->getSubExpr()->IgnoreParens()) : nullptr;
+  if (!inc || !inc->isIncrementOp() || !inc_ref || inc_ref->getDecl() != VD)
+    return false;
+
+  auto cond = dyn_cast_or_null<BinaryOperator>(S->getCond());
+  if (!cond || (cond->getOpcode() != BO_LT && cond->getOpcode() != BO_LE))
+    return false;
+  auto cond_ref = dyn_cast<DeclRefExpr>(cond->getLHS()->IgnoreParenImpCasts());
+  if (!cond_ref || cond_ref->getDecl() != VD) return false;
+
+  // bounds must not depend on other loop counters
+  llvm::DenseMap<VarDecl *, double> values;
+  double lower, upper;
+  if (!evaluateInvariant(VD->getInit(), values, lower) ||
+      !evaluateInvariant(cond->getRHS(), values, upper))
+    return false;
+  if (cond->getOpcode() == BO_LT) upper -= 1;
+  if (upper < lower || upper - lower >= max_table_size) return false;
+
+  counter.var = VD;
+  counter.lower = static_cast<int>(lower);
+  counter.upper = static_cast<int>(upper);
+
+  return true;
+}
+
+
+// store the values of a math function call depending only on one or two loop
+// counters to a constant table
+bool ASTTranslate::precomputeExpr(CallExpr *E, ArrayRef<LoopCounter> loops) {
+  QualType QT = E->getType().getUnqualifiedType();
+  if (!QT->isRealFloatingType()) return false;
+
+  llvm::DenseMap<VarDecl *, double> values;
+  for (auto loop : loops)
+    values[loop.var] = loop.lower;
+
+  SmallPtrSet<VarDecl *, 4> counters;
+  double value;
+  if (!evaluateInvariant(E, values, value, &counters) || counters.empty() ||
+      counters.size() > 2)
+    return false;
+
+  // the innermost loop counter selects the column of the table
+  PrecomputedExpr info;
+  info.counter_x.var = info.counter_y.var = nullptr;
+  info.counter_y.lower = info.counter_y.upper = 0;
+  for (auto it=loops.rbegin(), ie=loops.rend(); it!=ie; ++it) {
+    if (!counters.count(it->var)) continue;
+    if (info.counter_x.var) info.counter_y = *it;
+    else info.counter_x = *it;
+  }
+
+  int size_x = info.counter_x.upper - info.counter_x.lower + 1;
+  int size_y = info.counter_y.upper - info.counter_y.lower + 1;
+  if (size_x * size_y > max_table_size) return false;
+
+  SmallVector<Expr *, 16> rows;
+  for (int y=0; y<size_y; ++y) {
+    if (info.counter_y.var)
+      values[info.counter_y.var] = info.counter_y.lower + y;
+
+    SmallVector<Expr *, 16> cols;
+    for (int x=0; x<size_x; ++x) {
+      values[info.counter_x.var] = info.counter_x.lower + x;
+      if (!evaluateInvariant(E, values, value)) return false;
+
+      llvm::APFloat fval(value);
+      bool loses_info;
+      fval.convert(Ctx.getFloatTypeSemantics(QT),
+          llvm::APFloat::rmNearestTiesToEven, &loses_info);
+      cols.push_back(FloatingLiteral::Create(Ctx, fval, false, QT,
+            SourceLocation()));
+    }
+    rows.push_back(new (Ctx) InitListExpr(Ctx, SourceLocation(), cols,
+          SourceLocation()));
+  }
+
+  VarDecl *tableVD = createVarDecl(Ctx, Ctx.getTranslationUnitDecl(), "Tab" +
+      std::to_string(Kernel->getTables().size()), QT);
+  info.table = new HipaccMask(tableVD, QT, HipaccMask::MaskType::Mask);
+  info.table->setSizeX(size_x);
+  info.table->setSizeY(size_y);
+  info.table->setIsConstant(true);
+  info.table->setInitList(new (Ctx) InitListExpr(Ctx, SourceLocation(), rows,
+        SourceLocation()));
+  Kernel->addTable(info.table);
+  precomputedExprs[E] = info;
+
+  return true;
+}
+
+
+// search for math function calls within loops with constant bounds, which can
+// be precomputed
+void ASTTranslate::findPrecomputableExprs(Stmt *S,
+    SmallVectorImpl<LoopCounter> &loops) {
+  if (!S) return;
+
+  if (auto FS = dyn_cast<ForStmt>(S)) {
+    LoopCounter counter;
+    if (getLoopCounter(FS, counter)) {
+      loops.push_back(counter);
+      findPrecomputableExprs(FS->getBody(), loops);
+      loops.pop_back();
+      return;
+    }
+  }
+
+  if (auto CE = dyn_cast<CallExpr>(S))
+    if (!loops.empty() && precomputeExpr(CE, loops)) return;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    findPrecomputableExprs(*it, loops);
+}
+
+
+// read precomputed expression from constant table: Tab[yf-lower][xf-lower]
+Expr *ASTTranslate::accessPrecomputedExpr(Expr *E) {
+  auto iter = precomputedExprs.find(E);
+  if (iter == precomputedExprs.end()) return nullptr;
+
+  PrecomputedExpr &info = iter->second;
+  HipaccMask *table = info.table;
+  QualType QT = Ctx.getPointerType(Ctx.getConstantArrayType(table->getType(),
+        llvm::APInt(32, table->getSizeX()), ArrayType::Normal, false));
+
+  VarDecl *tableVar = lookup<VarDecl>(table->getName() + Kernel->getName(),
+      QT);
+  if (!tableVar) {
+    tableVar = createVarDecl(Ctx, Ctx.getTranslationUnitDecl(),
+        table->getName() + Kernel->getName(), QT);
+
+    DeclContext *DC =
+      TranslationUnitDecl::castToDeclContext(Ctx.getTranslationUnitDecl());
+    DC->addDecl(tableVar);
+  }
+
+  auto getIndex = [&] (LoopCounter &counter) -> Expr * {
+    if (!counter.var) return createIntegerLiteral(Ctx, 0);
+
+    Expr *idx = Clone(createDeclRefExpr(Ctx, counter.var));
+    if (counter.lower < 0)
+      idx = createBinaryOperator(Ctx, idx, createIntegerLiteral(Ctx,
+            -counter.lower), BO_Add, Ctx.IntTy);
+    else if (counter.lower > 0)
+      idx = createBinaryOperator(Ctx, idx, createIntegerLiteral(Ctx,
+            counter.lower), BO_Sub, Ctx.IntTy);
+    return idx;
+  };
+
+  return accessMem2DAt(createDeclRefExpr(Ctx, tableVar),
+      getIndex(info.counter_x), getIndex(info.counter_y));
+}
+
+// vim: set ts=2 sw=2 sts=2 et ai:
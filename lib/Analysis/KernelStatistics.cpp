@@ -57,6 +57,7 @@ class KernelStatsImpl {
     llvm::DenseMap<const FieldDecl *, MemoryAccess> imagesToAccess;
     llvm::DenseMap<const FieldDecl *, MemoryAccessDetail> imagesToAccessDetail;
     llvm::DenseMap<const VarDecl *, VectorInfo> declsToVector;
+    llvm::DenseMap<const VarDecl *, unsigned> declsToWrites;
     MemoryAccessDetail outputAccessDetail;
     KernelType kernelType;
 
@@ -75,6 +76,7 @@ class KernelStatsImpl {
 
     void runOnBlock(const CFGBlock *block);
     void runOnAllBlocks();
+    void countWrites(Stmt *S);
 
 
     KernelStatsImpl(AnalysisDeclContext &ac, StringRef name,
@@ -230,7 +232,29 @@ void KernelStatsImpl::runOnBlock(const CFGBlock *block) {
 }
 
 
+// conservatively count writes to variables: each reference to a variable
+// that does not just load its value is considered to be a write, e.g.
+// assignments, increments, taking its address, or binding it to a reference
+void KernelStatsImpl::countWrites(Stmt *S) {
+  if (!S) return;
+
+  if (auto ICE = dyn_cast<ImplicitCastExpr>(S))
+    if (ICE->getCastKind() == CK_LValueToRValue &&
+        isa<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens()))
+      return;
+
+  if (auto DRE = dyn_cast<DeclRefExpr>(S))
+    if (auto VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      declsToWrites[VD]++;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    countWrites(*it);
+}
+
+
 void KernelStatsImpl::runOnAllBlocks() {
+  countWrites(analysisContext.getBody());
+
   auto POV = analysisContext.getAnalysis<PostOrderCFGView>();
   for (auto block : *POV)
     runOnBlock(block);
@@ -308,6 +332,11 @@ VectorInfo KernelStatistics::getVectorizeInfo(const VarDecl *VD) {
 }
 
 
+unsigned KernelStatistics::getNumWrites(const VarDecl *VD) {
+  return getImpl(impl).declsToWrites.lookup(VD);
+}
+
+
 KernelType KernelStatistics::getKernelType() {
   return getImpl(impl).kernelType;
 }
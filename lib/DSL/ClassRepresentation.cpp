@@ -244,6 +244,54 @@ void HipaccKernel::calcSizes() {
 }
 
 
+// Get the size of the blocks the iteration space of C/C++ local operators is
+// tiled into: the input windows of all Accessors required for a block and the
+// output block have to fit into half of the L2 cache, so that each input row
+// is loaded only once from memory. Returns false if blocking is not required.
+bool HipaccKernel::getCPUTileSize(unsigned &tile_x, unsigned &tile_y) {
+  if (!options.emitC99() || !options.cpuTiling() || !iterationSpace ||
+      max_size_y_undef <= 1)
+    return false;
+
+  if (options.getCPUTileX() > 0 && options.getCPUTileY() > 0) {
+    tile_x = options.getCPUTileX();
+    tile_y = options.getCPUTileY();
+    return true;
+  }
+
+  // bytes of a block of bx x by pixels including the halo of the Accessors
+  auto footprint = [&] (unsigned bx, unsigned by) -> uint64_t {
+    uint64_t bytes = (uint64_t)bx * by *
+      iterationSpace->getImage()->getPixelSize();
+    for (auto map : imgMap) {
+      HipaccAccessor *Acc = map.second;
+      bytes += (uint64_t)(bx + std::max(Acc->getSizeX(), 1u) - 1) *
+        (by + std::max(Acc->getSizeY(), 1u) - 1) *
+        Acc->getImage()->getPixelSize();
+    }
+    return bytes;
+  };
+
+  uint64_t budget = (l2_cache_size ? l2_cache_size : 262144) / 2;
+  unsigned width = iterationSpace->getROIWidth() ?
+    iterationSpace->getROIWidth() : iterationSpace->getImage()->getSizeX();
+
+  // the block should be at least as high as the largest window, use multiples
+  // of 32 pixels for the width to keep the x-loops vectorizable
+  unsigned bx = 1024;
+  while (bx > 32 && footprint(bx, max_size_y_undef) > budget) bx /= 2;
+  // complete rows of the window fit into the cache
+  if (width && bx >= width) return false;
+
+  uint64_t halo = footprint(bx, 0), row = footprint(bx, 1) - halo;
+  unsigned by = halo < budget ? (budget - halo) / row : 1;
+
+  tile_x = bx;
+  tile_y = std::max(by, 1u);
+  return true;
+}
+
+
 struct sortOccMap {
   bool operator()(const std::pair<unsigned, float> &left, const std::pair<unsigned, float> &right) {
     if (left.second < right.second) return false;
@@ -509,13 +557,13 @@ void HipaccKernel::createArgInfo() {
             !(useTextureMemory(getImgFromMapping(arg.field)) == Texture::Ldg)) {
           addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
               Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
-                    getImgFromMapping(arg.field)->getImage()->getSizeX()),
+                    getImgFromMapping(arg.field)->getImage()->getStride()),
                   ArrayType::Normal, false)), QT.getAsString(), "cl_mem",
               arg.name, arg.field);
         } else {
           addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
               Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
-                    getImgFromMapping(arg.field)->getImage()->getSizeX()),
+                    getImgFromMapping(arg.field)->getImage()->getStride()),
                   ArrayType::Normal, false)),
               Ctx.getPointerType(QT).getAsString(), "cl_mem", arg.name,
               arg.field);
@@ -576,6 +624,55 @@ void HipaccKernel::createArgInfo() {
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     addParam(Ctx.getConstType(Ctx.IntTy), "bh_fall_back", nullptr);
   }
+  // row_start, row_end: range of iteration space rows processed by one call
+  if (options.emitC99()) {
+    addParam(Ctx.getConstType(Ctx.IntTy), "row_start", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), "row_end", nullptr);
+  }
+}
+
+
+void HipaccKernel::specializeArgs(ArrayRef<Expr *> hostArgs) {
+  size_t i = 0;
+  for (auto arg : KC->getMembers()) {
+    Expr *hostArg = hostArgs[i++];
+    QualType QT = arg.type.getUnqualifiedType();
+
+    if (arg.kind != HipaccKernelClass::FieldKind::Normal ||
+        !QT->isBuiltinType())
+      continue;
+
+    Expr::EvalResult val;
+    if (!hostArg->EvaluateAsRValue(val, Ctx) || val.HasSideEffects)
+      continue;
+
+    Expr *literal = nullptr;
+    bool negative = false;
+    if (QT->isIntegerType() && val.Val.isInt()) {
+      // literals of types smaller than int are converted from int
+      QualType LT = Ctx.isPromotableIntegerType(QT) ? Ctx.IntTy : QT;
+      llvm::APSInt ival = val.Val.getInt().extOrTrunc(Ctx.getIntWidth(LT));
+      ival.setIsSigned(LT->isSignedIntegerType());
+      negative = ival.isNegative();
+      literal = new (Ctx) IntegerLiteral(Ctx, ival, LT, SourceLocation());
+      if (LT != QT)
+        literal = ImplicitCastExpr::Create(Ctx, QT, CK_IntegralCast, literal,
+            nullptr, VK_RValue);
+    } else if (QT->isRealFloatingType() && val.Val.isFloat()) {
+      llvm::APFloat fval(val.Val.getFloat());
+      bool loses_info;
+      fval.convert(Ctx.getFloatTypeSemantics(QT),
+          llvm::APFloat::rmNearestTiesToEven, &loses_info);
+      negative = fval.isNegative();
+      literal = FloatingLiteral::Create(Ctx, fval, false, QT, SourceLocation());
+    }
+    if (!literal) continue;
+
+    if (negative)
+      literal = new (Ctx) ParenExpr(SourceLocation(), SourceLocation(),
+          literal);
+    constArgs[arg.field] = literal;
+  }
 }
 
 
@@ -658,6 +755,17 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     hostArgNames.push_back(getInfoStr() + ".bh_fall_back");
   }
+  // row_start, row_end: provided by the thread pool in case of multi-threading
+  // and by the strip loop in case of streaming execution
+  if (options.emitC99()) {
+    if (options.multiThreading() || options.streamExecution()) {
+      hostArgNames.push_back("row_start");
+      hostArgNames.push_back("row_end");
+    } else {
+      hostArgNames.push_back("0");
+      hostArgNames.push_back(iterationSpace->getName() + ".height");
+    }
+  }
 }
 
 // vim: set ts=2 sw=2 sts=2 et ai:
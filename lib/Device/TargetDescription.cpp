@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+//===--- TargetDescription.cpp - Target hardware feature description -----===//
+//
+// This file implements the detection of host CPU features.
+//
+//===----------------------------------------------------------------------===//
+
+#include "hipacc/Device/TargetDescription.h"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/Support/Host.h>
+
+#include <thread>
+#include <unistd.h>
+
+using namespace clang;
+using namespace hipacc;
+
+
+void HipaccDeviceOptions::detectHostCPU() {
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    simd_width = 16;
+    if (features.lookup("avx2")) simd_width = 32;
+    if (features.lookup("avx512f")) simd_width = 64;
+  } else {
+    simd_width = llvm::StringSwitch<unsigned>(llvm::sys::getHostCPUName())
+      .Cases("knl", "skx", "skylake-avx512", "cannonlake", 64)
+      .Cases("haswell", "broadwell", "skylake", "znver1", 32)
+      .Default(16);
+  }
+
+  l1_cache_size = 32768;
+  l2_cache_size = 262144;
+  #if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+  long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (l1 > 0) l1_cache_size = l1;
+  if (l2 > 0) l2_cache_size = l2;
+  #endif
+
+  num_cores = std::thread::hardware_concurrency();
+  if (!num_cores) num_cores = 1;
+}
+
+
+std::string HipaccDeviceOptions::getHostCPUName() {
+  return "x86_64 CPU: " + llvm::sys::getHostCPUName().str() + " (" +
+    std::to_string(num_cores) + " cores, " +
+    std::to_string(simd_width*8) + " bit SIMD)";
+}
+
+// vim: set ts=2 sw=2 sts=2 et ai:
+
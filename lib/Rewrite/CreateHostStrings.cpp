@@ -128,6 +128,22 @@ void CreateHostStrings::writeKernelCompilation(HipaccKernel *K,
         writeCLCompilation(K->getFileName(), K->getReduceName(),
             device.getCLIncludes(), resultStr, "1D");
       }
+      if (K->getKernelClass()->getScanFunction()) {
+        resultStr += indent;
+        writeCLCompilation(K->getFileName(), K->getScanName(),
+            device.getCLIncludes(), resultStr, "Row");
+        resultStr += indent;
+        writeCLCompilation(K->getFileName(), K->getScanName(),
+            device.getCLIncludes(), resultStr, "Column");
+      }
+      if (K->getKernelClass()->getBinningFunction()) {
+        resultStr += indent;
+        writeCLCompilation(K->getFileName(), K->getBinningName(),
+            device.getCLIncludes(), resultStr, "2D");
+        resultStr += indent;
+        writeCLCompilation(K->getFileName(), K->getBinningName(),
+            device.getCLIncludes(), resultStr, "1D");
+      }
       break;
   }
 }
@@ -194,6 +210,25 @@ void CreateHostStrings::writeReductionDeclaration(HipaccKernel *K, std::string
 void CreateHostStrings::writeMemoryAllocation(HipaccImage *Img, std::string
     width, std::string height, std::string host, std::string &resultStr) {
   resultStr += "HipaccImage " + Img->getName() + " = ";
+  if (options.emitC99() && Img->hasHalo()) {
+    // physical halo replaces border handling, padding is not supported
+    std::string mode;
+    switch (Img->getHaloMode()) {
+      case Boundary::UNDEFINED:
+      case Boundary::CLAMP:    mode = "HaloClamp";    break;
+      case Boundary::REPEAT:   mode = "HaloRepeat";   break;
+      case Boundary::MIRROR:   mode = "HaloMirror";   break;
+      case Boundary::CONSTANT: mode = "HaloConstant"; break;
+    }
+    resultStr += "hipaccCreateMemoryHalo<" + Img->getTypeStr() + ">(";
+    resultStr += host + ", " + width + ", " + height + ", ";
+    resultStr += std::to_string(Img->getHaloX()) + ", ";
+    resultStr += std::to_string(Img->getHaloY()) + ", " + mode;
+    if (Img->getHaloMode() == Boundary::CONSTANT)
+      resultStr += ", (" + Img->getTypeStr() + ")(" + Img->getHaloConst() + ")";
+    resultStr += ");";
+    return;
+  }
   switch (options.getTargetLang()) {
     case Language::C99:
       resultStr += "hipaccCreateMemory<" + Img->getTypeStr() + ">(";
@@ -234,6 +269,15 @@ void CreateHostStrings::writeMemoryAllocation(HipaccImage *Img, std::string
 }
 
 
+void CreateHostStrings::writeMemoryAllocationStreamed(HipaccImage *Img,
+    std::string width, std::string height, std::string read, std::string
+    write, std::string &resultStr) {
+  resultStr += "HipaccImage " + Img->getName() + " = ";
+  resultStr += "hipaccCreateStreamedMemory<" + Img->getTypeStr() + ">(";
+  resultStr += width + ", " + height + ", " + read + ", " + write + ");";
+}
+
+
 void CreateHostStrings::writeMemoryAllocationConstant(HipaccMask *Buf,
     std::string &resultStr) {
   resultStr += "HipaccImage " + Buf->getName() + " = ";
@@ -466,25 +510,45 @@ void CreateHostStrings::writeKernelCall(std::string kernelName,
     resultStr += indent;
   }
 
-  if (options.getTargetLang() != Language::C99) {
-    // hipacc_launch_info
-    resultStr += "hipacc_launch_info " + infoStr + "(";
-    resultStr += std::to_string(K->getMaxSizeX()) + ", ";
-    resultStr += std::to_string(K->getMaxSizeY()) + ", ";
-    resultStr += K->getIterationSpace()->getName() + ", ";
-    resultStr += std::to_string(K->getPixelsPerThread()) + ", ";
-    if (K->vectorize()) {
-      // TODO set and calculate per kernel simd width ...
-      resultStr += "4);\n";
-    } else {
-      resultStr += "1);\n";
-    }
-    resultStr += indent;
+  // hipacc_launch_info
+  resultStr += "hipacc_launch_info " + infoStr + "(";
+  resultStr += std::to_string(K->getMaxSizeX()) + ", ";
+  resultStr += std::to_string(K->getMaxSizeY()) + ", ";
+  resultStr += K->getIterationSpace()->getName() + ", ";
+  resultStr += std::to_string(K->getPixelsPerThread()) + ", ";
+  if (K->vectorize() && !options.emitC99()) {
+    resultStr += std::to_string(K->getVectorWidth()) + ");\n";
+  } else {
+    resultStr += "1);\n";
   }
+  resultStr += indent;
 
   if (!options.exploreConfig()) {
     switch (options.getTargetLang()) {
-      case Language::C99: break;
+      case Language::C99: {
+          // pass the window of Accessors with border handling: border strips
+          // are shrunk at run time for Accessors exceeding the iteration space
+          std::string accStr;
+          bool interpolate = false;
+          for (auto img : KC->getImgFields()) {
+            HipaccAccessor *Acc = K->getImgFromMapping(img);
+            if (Acc->getBoundaryMode() == Boundary::UNDEFINED) continue;
+            if (Acc->getInterpolationMode() != Interpolate::NO)
+              interpolate = true;
+            if (!accStr.empty()) accStr += ", ";
+            accStr += "{ " + Acc->getName() + ", ";
+            accStr += std::to_string(Acc->getSizeX()/2) + ", ";
+            accStr += std::to_string(Acc->getSizeY()/2) + " }";
+          }
+
+          // hipaccPrepareKernelLaunch
+          resultStr += "hipaccPrepareKernelLaunch(" + infoStr;
+          if ((K->getMaxSizeX() || K->getMaxSizeY()) && !interpolate)
+            resultStr += ", { " + accStr + " }";
+          resultStr += ");\n";
+          resultStr += indent;
+        }
+        break;
       case Language::CUDA:
         // dim3 block
         resultStr += "dim3 " + blockStr + "(" + threads_x + ", " + threads_y + ");\n";
@@ -753,13 +817,56 @@ void CreateHostStrings::writeKernelCall(std::string kernelName,
           if (i==0) {
             resultStr += "hipaccStartTiming();\n";
             resultStr += indent;
+            if (options.streamExecution()) {
+              // process the iteration space in strips, streamed images are
+              // backed by rolling buffers
+              resultStr += "hipaccLaunchKernelStreamed(";
+              resultStr += options.multiThreading() ?
+                std::to_string(K->getCPUThreads()) : "1";
+              resultStr += ", " + std::to_string(options.getStreamRows());
+              // rows read around the current pixel: window of the Accessors
+              // or offsets of the accesses; repeat border handling wraps
+              // around: keep whole image
+              std::string halo(std::to_string(std::max((int)
+                      K->getMaxSizeYUndef(), K->getStreamOffsetY())));
+              for (auto img : KC->getImgFields()) {
+                HipaccAccessor *Acc = K->getImgFromMapping(img);
+                if (Acc && Acc->getBoundaryMode()==Boundary::REPEAT)
+                  halo = "(int)" + Acc->getName() + ".img.height";
+              }
+              resultStr += ", " + halo + ", ";
+              resultStr += K->getIterationSpace()->getName() + ", {";
+              size_t num_img = 0, num_field = 0;
+              for (auto field : K->getDeviceArgFields()) {
+                size_t j = num_field++;
+                if (!K->getUsed(K->getDeviceArgNames()[j]) ||
+                    !K->getImgFromMapping(field)) continue;
+                if (num_img++) resultStr += ", ";
+                resultStr += "&" + hostArgNames[j];
+              }
+              resultStr += "}, [&] (int row_start, int row_end) {\n";
+              resultStr += indent + "    ";
+            } else if (options.multiThreading()) {
+              // distribute rows of the iteration space among the thread pool
+              resultStr += "hipaccLaunchKernel(";
+              resultStr += std::to_string(K->getCPUThreads()) + ", ";
+              resultStr += K->getIterationSpace()->getName() + ".height, ";
+              resultStr += "[&] (int row_start, int row_end) {\n";
+              resultStr += indent + "    ";
+            }
             resultStr += kernelName + "(";
           } else {
             resultStr += ", ";
           }
+          if (Acc && options.streamExecution()) {
+            // images are addressed through row tables
+            resultStr += "(" + Acc->getImage()->getTypeStr() + " **)";
+            resultStr += "hipaccGetRows(" + hostArgNames[i] + ")";
+            break;
+          }
           if (Acc) {
             resultStr += "(" + Acc->getImage()->getTypeStr();
-            resultStr += "(*)[" + Acc->getImage()->getSizeXStr() + "])";
+            resultStr += "(*)[" + Acc->getImage()->getStrideStr() + "])";
           }
           if (Mask) {
             resultStr += "(" + argTypeNames[i] + ")";
@@ -806,8 +913,18 @@ void CreateHostStrings::writeKernelCall(std::string kernelName,
     // close parenthesis for function call
     resultStr += ");\n";
     resultStr += indent;
+    if (options.multiThreading() || options.streamExecution()) {
+      resultStr += "});\n";
+      resultStr += indent;
+    }
     resultStr += "hipaccStopTiming();\n";
     resultStr += indent;
+    // update the halo of the output image for subsequent kernels
+    if (K->getIterationSpace()->getImage()->hasHalo()) {
+      resultStr += "hipaccFillHalo(";
+      resultStr += K->getIterationSpace()->getImage()->getName() + ");\n";
+      resultStr += indent;
+    }
   }
   resultStr += "\n" + indent;
 
@@ -911,6 +1028,92 @@ void CreateHostStrings::writeKernelCall(std::string kernelName,
 }
 
 
+void CreateHostStrings::writeScanCall(HipaccKernel *K, std::string
+    &resultStr) {
+  // print runtime function name plus name of scan functions
+  switch (options.getTargetLang()) {
+    case Language::C99:
+      // rows and columns are distributed over the kernel thread pool
+      resultStr += K->getScanName() + "2D(";
+      resultStr += K->getIterationSpace()->getName() + ", ";
+      if (options.multiThreading()) {
+        resultStr += std::to_string(K->getCPUThreads());
+      } else {
+        resultStr += "1";
+      }
+      resultStr += ");";
+      return;
+    case Language::CUDA:
+      resultStr += "hipaccApplyScan(";
+      resultStr += "(const void *)&" + K->getScanName() + "Row, ";
+      resultStr += "\"" + K->getScanName() + "Row\", ";
+      resultStr += "(const void *)&" + K->getScanName() + "Column, ";
+      resultStr += "\"" + K->getScanName() + "Column\", ";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      // not supported, reported when parsing the kernel class
+      return;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      resultStr += "hipaccApplyScan(";
+      resultStr += K->getScanName() + "Row, ";
+      resultStr += K->getScanName() + "Column, ";
+      break;
+  }
+
+  // print image name and work-group size
+  resultStr += K->getIterationSpace()->getName() + ", ";
+  resultStr += std::to_string(K->getNumThreadsReduce());
+  resultStr += ");";
+}
+
+
+// Write the call computing the histogram of the iteration space of a kernel,
+// leaving the argument list open for the number of bins passed by the user.
+void CreateHostStrings::writeBinningCall(HipaccKernel *K, std::string
+    &resultStr) {
+  // print runtime function name plus name of binning functions
+  switch (options.getTargetLang()) {
+    case Language::C99:
+      // private bins are accumulated by the threads of the kernel thread pool
+      resultStr += K->getBinningName() + "2D(";
+      resultStr += K->getIterationSpace()->getName() + ", ";
+      if (options.multiThreading()) {
+        resultStr += std::to_string(K->getCPUThreads());
+      } else {
+        resultStr += "1";
+      }
+      resultStr += ", ";
+      return;
+    case Language::CUDA:
+      resultStr += "hipaccApplyBinning(";
+      resultStr += "(const void *)&" + K->getBinningName() + "2D, ";
+      resultStr += "\"" + K->getBinningName() + "2D\", ";
+      resultStr += "(const void *)&" + K->getBinningName() + "1D, ";
+      resultStr += "\"" + K->getBinningName() + "1D\", ";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      // not supported, reported when parsing the kernel class
+      return;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      resultStr += "hipaccApplyBinning(";
+      resultStr += K->getBinningName() + "2D, ";
+      resultStr += K->getBinningName() + "1D, ";
+      break;
+  }
+
+  // print image name, work-group size, and pixels per thread
+  resultStr += K->getIterationSpace()->getName() + ", ";
+  resultStr += std::to_string(K->getNumThreadsReduce()) + ", ";
+  resultStr += std::to_string(K->getPixelsPerThreadReduce()) + ", ";
+}
+
+
 void CreateHostStrings::writeReduceCall(HipaccKernelClass *KC, HipaccKernel *K,
     std::string &resultStr) {
   std::string typeStr(K->getIterationSpace()->getImage()->getTypeStr());
@@ -918,7 +1121,18 @@ void CreateHostStrings::writeReduceCall(HipaccKernelClass *KC, HipaccKernel *K,
 
   // print runtime function name plus name of reduction function
   switch (options.getTargetLang()) {
-    case Language::C99: break;
+    case Language::C99:
+      // partial results are computed by the threads of the kernel thread pool
+      resultStr += red_decl;
+      resultStr += K->getReduceName() + "2D(";
+      resultStr += K->getIterationSpace()->getName() + ", ";
+      if (options.multiThreading()) {
+        resultStr += std::to_string(K->getCPUThreads());
+      } else {
+        resultStr += "1";
+      }
+      resultStr += ");";
+      return;
     case Language::CUDA:
       if (!options.exploreConfig()) {
         // first get texture reference
@@ -53,6 +53,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace clang;
 using namespace hipacc;
 using namespace ASTNode;
@@ -89,6 +92,42 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
     llvm::DenseMap<ValueDecl *, HipaccKernel *> KernelDeclMap;
     llvm::DenseMap<ValueDecl *, HipaccMask *> MaskDeclMap;
 
+    // producer/consumer kernels communicating via an intermediate image that
+    // are fused into a single kernel
+    struct KernelFusion {
+      VarDecl *producer, *consumer;
+      // intermediate Image, IterationSpace of the producer, and Accessor of
+      // the consumer
+      VarDecl *image, *iterationSpace, *accessor;
+      // constructor argument positions of the IterationSpace and Accessor
+      size_t iterationSpaceArg, accessorArg;
+      // host arguments of the fused kernel
+      SmallVector<Expr *, 16> hostArgs;
+    };
+    SmallVector<KernelFusion, 4> KernelFusions;
+    llvm::DenseMap<ValueDecl *, HipaccKernel *> FusedProducerMap;
+    llvm::SmallPtrSet<ValueDecl *, 16> FusedDecls;
+
+    // kernels convolving with a constant rank-1 Mask that are split into a
+    // row kernel writing an intermediate image and a column kernel
+    struct KernelSeparation {
+      VarDecl *kernel;
+      HipaccKernel *rowKernel;
+      // host arguments of the row kernel
+      SmallVector<Expr *, 16> hostArgs;
+    };
+    SmallVector<KernelSeparation, 4> KernelSeparations;
+
+    // images allocated with a physical halo filled according to the boundary
+    // mode of all BoundaryConditions defined on the image
+    struct ImageHalo {
+      Boundary mode;
+      unsigned size_x, size_y;
+      Expr *const_val;
+      bool valid;
+    };
+    llvm::DenseMap<ValueDecl *, ImageHalo> ImageHalos;
+
     // store interpolation methods required for CUDA
     SmallVector<std::string, 16> InterpolationDefinitionsGlobal;
 
@@ -137,8 +176,26 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
     }
 
     void setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K);
+    VarDecl *getImageDecl(VarDecl *VD);
+    void setROISize(HipaccAccessor *Acc, HipaccImage *Img, ArrayRef<Expr *>
+        roi_args);
+    void findKernelFusions(CompoundStmt *S);
+    void findImageHalos(CompoundStmt *S);
+    bool isCoveredByHalo(HipaccBoundaryCondition *BC);
+    KernelFusion *getKernelFusion(ValueDecl *consumer);
+    bool isFusedProducer(ValueDecl *producer);
+    HipaccKernel *createFusedKernel(KernelFusion &fusion, HipaccKernel *K);
+    HipaccKernel *createSeparatedKernels(HipaccKernel *K, std::string &hostStr);
+    KernelSeparation *getKernelSeparation(ValueDecl *kernel);
+    void translateKernel(HipaccKernelClass *KC, HipaccKernel *K);
+    void printOperatorFunction(FunctionDecl *fun, std::string name,
+        PrintingPolicy Policy, llvm::raw_ostream *OS);
     void printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
         PrintingPolicy Policy, llvm::raw_ostream *OS);
+    void printScanFunction(HipaccKernelClass *KC, HipaccKernel *K,
+        PrintingPolicy Policy, llvm::raw_ostream *OS);
+    void printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
+        PrintingPolicy Policy, llvm::raw_ostream *OS);
     void printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
         HipaccKernel *K, std::string file, bool emitHints);
 };
@@ -375,6 +432,9 @@ void Rewrite::HandleTranslationUnit(ASTContext &Context) {
     auto img = map.second;
     std::string releaseStr;
 
+    // intermediate images of fused kernels are not allocated
+    if (FusedDecls.count(map.first)) continue;
+
     stringCreator.writeMemoryRelease(img, releaseStr);
     TextRewriter.InsertTextBefore(S->getLocStart(), releaseStr);
   }
@@ -611,6 +671,33 @@ bool Rewrite::VisitCXXRecordDecl(CXXRecordDecl *D) {
 
         continue;
       }
+
+      // scan and bin functions
+      if (method->getNameAsString() == "scan" ||
+          method->getNameAsString() == "bin") {
+        unsigned DiagIDOperator =
+          Diags.getCustomDiagID(DiagnosticsEngine::Error,
+              "%0 functions are not supported %1.");
+        std::string op(method->getNameAsString() == "scan" ? "Scan" : "Bin");
+        if (compilerOptions.emitRenderscript() ||
+            compilerOptions.emitFilterscript()) {
+          Diags.Report(method->getLocation(), DiagIDOperator)
+            << op << "for Renderscript and Filterscript";
+        } else if (!compilerOptions.emitC99() &&
+            compilerOptions.exploreConfig()) {
+          Diags.Report(method->getLocation(), DiagIDOperator)
+            << op << "when exploring the kernel configuration";
+        } else if (compilerOptions.useTextureMemory() &&
+            compilerOptions.getTextureType()==Texture::Array2D) {
+          Diags.Report(method->getLocation(), DiagIDOperator)
+            << op << "for Array2D textures";
+        }
+        // set scan or bin method
+        if (op == "Scan") KC->setScanFunction(method);
+        else KC->setBinningFunction(method);
+
+        continue;
+      }
     }
   }
 
@@ -618,6 +705,13 @@ bool Rewrite::VisitCXXRecordDecl(CXXRecordDecl *D) {
 }
 
 
+// check if an image is declared with read and write callbacks
+static bool isStreamedImage(VarDecl *VD) {
+  auto CCE = dyn_cast_or_null<CXXConstructExpr>(VD->getInit());
+  return CCE && CCE->getNumArgs() == 4;
+}
+
+
 bool Rewrite::VisitDeclStmt(DeclStmt *D) {
   if (!compilerClasses.HipaccEoP) return true;
 
@@ -656,8 +750,8 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
       if (compilerClasses.isTypeOfTemplateClass(VD->getType(),
             compilerClasses.Image)) {
         CXXConstructExpr *CCE = dyn_cast<CXXConstructExpr>(VD->getInit());
-        assert((CCE->getNumArgs() == 2 || CCE->getNumArgs() == 3) &&
-               "Image definition requires two or three arguments!");
+        assert((CCE->getNumArgs() >= 2 && CCE->getNumArgs() <= 4) &&
+               "Image definition requires two to four arguments!");
 
         HipaccImage *Img = new HipaccImage(Context, VD,
             compilerClasses.getFirstTemplateType(VD->getType()));
@@ -682,17 +776,57 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
           Img->setSizeY(CCE->getArg(1)->EvaluateKnownConstInt(Context).getSExtValue());
         }
 
+        // streamed image: rows are read and written using callbacks
+        if (isStreamedImage(VD)) {
+          if (!compilerOptions.emitC99() ||
+              !compilerOptions.streamExecution()) {
+            unsigned DiagIDStreamed = Diags.getCustomDiagID(
+                DiagnosticsEngine::Error, "Streamed Image %0 requires C/C++ "
+                "code generation with streaming execution (-stream-rows).");
+            Diags.Report(VD->getLocation(), DiagIDStreamed) << Img->getName();
+          }
+          Img->setStreamed();
+
+          std::string read_str = TextRewriter.ConvertToString(CCE->getArg(2));
+          std::string write_str = "hipacc_row_fn()";
+          if (!isa<CXXDefaultArgExpr>(CCE->getArg(3)))
+            write_str = TextRewriter.ConvertToString(CCE->getArg(3));
+
+          std::string newStr;
+          stringCreator.writeMemoryAllocationStreamed(Img, width_str,
+              height_str, read_str, write_str, newStr);
+
+          // callbacks may contain semicolons: replace the whole statement
+          TextRewriter.ReplaceText(SourceRange(D->getLocStart(),
+                D->getLocEnd()), newStr);
+
+          ImgDeclMap[VD] = Img;
+          break;
+        }
+
         // host memory
         std::string init_str = "NULL";
         if (CCE->getNumArgs() == 3) {
           init_str = TextRewriter.ConvertToString(CCE->getArg(2));
         }
 
+        // allocate the image with a halo replacing border handling
+        if (ImageHalos.count(VD) && !FusedDecls.count(VD)) {
+          ImageHalo &halo = ImageHalos[VD];
+          if (halo.valid && (halo.size_x > 1 || halo.size_y > 1))
+            Img->setHalo(halo.size_x/2, halo.size_y/2, halo.mode,
+                halo.const_val ? TextRewriter.ConvertToString(halo.const_val)
+                               : "");
+        }
+
         // create memory allocation string
         std::string newStr;
         stringCreator.writeMemoryAllocation(Img, width_str, height_str,
             init_str, newStr);
 
+        // intermediate images of fused kernels are not allocated
+        if (FusedDecls.count(VD)) newStr.clear();
+
         // rewrite Image definition
         // get the start location and compute the semi location.
         SourceLocation startLoc = D->getLocStart();
@@ -874,7 +1008,7 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         HipaccPyramid *Pyr = nullptr;
         Interpolate mode = Interpolate::NO;
         std::string Parms;
-        size_t roi_args = 0;
+        SmallVector<Expr *, 4> roi_args;
 
         for (size_t i=0, e=CCE->getNumArgs(); i!=e; ++i) {
           auto arg = CCE->getArg(i)->IgnoreParenCasts();
@@ -946,16 +1080,34 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
           // img|bc|pyramid-call
           // img|bc|pyramid-call, width, height, xf, yf
           Parms += ", " + TextRewriter.ConvertToString(arg);
-          roi_args++;
+          roi_args.push_back(arg);
         }
 
         assert(BC && "Expected BoundaryCondition, Image or Pyramid call as "
                      "first argument to Accessor.");
 
-        Acc = new HipaccAccessor(VD, BC, mode, roi_args == 4);
+        // the halo of the image provides the pixels outside the image, if the
+        // Accessor covers the whole image and the halo is large enough and
+        // filled according to the boundary mode of the BoundaryCondition
+        if (!Pyr && !BC->isPyramid() && BC->getImage()->hasHalo() &&
+            BC->getBoundaryMode() != Boundary::UNDEFINED &&
+            mode == Interpolate::NO && roi_args.empty() &&
+            isCoveredByHalo(BC)) {
+          HipaccBoundaryCondition *Halo = new HipaccBoundaryCondition(VD,
+              BC->getImage());
+          Halo->setSizeX(BC->getSizeX());
+          Halo->setSizeY(BC->getSizeY());
+          Halo->setBoundaryMode(Boundary::UNDEFINED);
+          BC = Halo;
+        }
+
+        Acc = new HipaccAccessor(VD, BC, mode, roi_args.size() == 4);
+        setROISize(Acc, Pyr || BC->isPyramid() ? nullptr : BC->getImage(),
+            roi_args);
 
         std::string newStr;
-        newStr = "HipaccAccessor " + Acc->getName() + "(" + Parms + ");";
+        if (!FusedDecls.count(VD))
+          newStr = "HipaccAccessor " + Acc->getName() + "(" + Parms + ");";
 
         // replace Accessor decl by variables for width/height and offsets
         // get the start location and compute the semi location.
@@ -981,7 +1133,7 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         HipaccImage *Img = nullptr;
         HipaccPyramid *Pyr = nullptr;
         std::string Parms;
-        size_t roi_args = 0;
+        SmallVector<Expr *, 4> roi_args;
 
         for (size_t i=0, e=CCE->getNumArgs(); i!=e; ++i) {
           auto arg = CCE->getArg(i)->IgnoreParenCasts();
@@ -1012,17 +1164,20 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
           // get text string for arguments, argument order is:
           // img[, is_width, is_height[, offset_x, offset_y]]
           Parms += ", " + TextRewriter.ConvertToString(arg);
-          roi_args++;
+          roi_args.push_back(arg);
         }
 
         assert((Img || Pyr) && "Expected first argument of IterationSpace to "
                                "be Image or Pyramid call.");
 
-        IS = new HipaccIterationSpace(VD, Img ? Img : Pyr, roi_args == 4);
+        IS = new HipaccIterationSpace(VD, Img ? Img : Pyr,
+            roi_args.size() == 4);
+        setROISize(IS, Img, roi_args);
         ISDeclMap[VD] = IS; // store IterationSpace
 
         std::string newStr;
-        newStr = "HipaccAccessor " + IS->getName() + "(" + Parms + ");";
+        if (!FusedDecls.count(VD))
+          newStr = "HipaccAccessor " + IS->getName() + "(" + Parms + ");";
 
         // replace iteration space decl by variables for width/height, and
         // offset
@@ -1289,36 +1444,49 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
             }
           }
 
-          // set kernel configuration
-          setKernelConfiguration(KC, K);
-
-          // kernel declaration
-          FunctionDecl *kernelDecl = createFunctionDecl(Context,
-              Context.getTranslationUnitDecl(), K->getKernelName(),
-              Context.VoidTy, K->getArgTypes(), K->getDeviceArgNames());
-
-          // write CUDA/OpenCL kernel function to file clone old body,
-          // replacing member variables
-          ASTTranslate *Hipacc = new ASTTranslate(Context, kernelDecl, K, KC,
-              builtins, compilerOptions);
-          Stmt *kernelStmts =
-            Hipacc->Hipacc(KC->getKernelFunction()->getBody());
-          kernelDecl->setBody(kernelStmts);
-          K->printStats();
-
-          #ifdef USE_POLLY
-          if (!compilerOptions.exploreConfig() && compilerOptions.emitC99()) {
-            llvm::errs() << "\nPassing the following function to Polly:\n";
-            kernelDecl->print(llvm::errs(), Context.getPrintingPolicy());
-            llvm::errs() << "\n";
-
-            Polly *polly_analysis = new Polly(Context, CI, kernelDecl);
-            polly_analysis->analyzeKernel();
+          // producers of fused kernels are computed within their consumer
+          if (isFusedProducer(VD)) {
+            KernelDeclMap.erase(VD);
+            FusedProducerMap[VD] = K;
+
+            break;
+          }
+
+          // fuse the producer of an intermediate image into this kernel
+          if (KernelFusion *fusion = getKernelFusion(VD)) {
+            K = createFusedKernel(*fusion, K);
+            KC = K->getKernelClass();
+            KernelDeclMap[VD] = K;
+          }
+
+          // split convolutions with a rank-1 Mask into a row and a column
+          // kernel; the intermediate image is allocated at the declaration
+          CompoundStmt *CS = mainFD ?
+            dyn_cast<CompoundStmt>(mainFD->getBody()) : nullptr;
+          if (compilerOptions.separateKernels() && !getKernelFusion(VD) && CS &&
+              std::find(CS->body_begin(), CS->body_end(), D) != CS->body_end()) {
+            std::string newStr;
+            if (HipaccKernel *KS = createSeparatedKernels(K, newStr)) {
+              HipaccKernel *KR = getKernelSeparation(VD)->rowKernel;
+              translateKernel(KR->getKernelClass(), KR);
+              TextRewriter.InsertTextBefore(D->getLocStart(), newStr);
+
+              K = KS;
+              KC = K->getKernelClass();
+              KernelDeclMap[VD] = K;
+            }
+          }
+
+          // replace scalar arguments initialized with compile-time constants
+          if (compilerOptions.specializeKernels()) {
+            ArrayRef<Expr *> hostArgs(CCE->getArgs(), CCE->getNumArgs());
+            if (KernelFusion *fusion = getKernelFusion(VD))
+              hostArgs = fusion->hostArgs;
+            if (hostArgs.size() == KC->getMembers().size())
+              K->specializeArgs(hostArgs);
           }
-          #endif
 
-          // write kernel to file
-          printKernelFunction(kernelDecl, KC, K, K->getFileName(), true);
+          translateKernel(KC, K);
 
           break;
         }
@@ -1330,17 +1498,949 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
 }
 
 
+// Translate the kernel body and write the kernel function to file
+void Rewrite::translateKernel(HipaccKernelClass *KC, HipaccKernel *K) {
+  // set kernel configuration
+  setKernelConfiguration(KC, K);
+
+  // kernel declaration
+  FunctionDecl *kernelDecl = createFunctionDecl(Context,
+      Context.getTranslationUnitDecl(), K->getKernelName(),
+      Context.VoidTy, K->getArgTypes(), K->getDeviceArgNames());
+
+  // write CUDA/OpenCL kernel function to file clone old body,
+  // replacing member variables
+  ASTTranslate *Hipacc = new ASTTranslate(Context, kernelDecl, K, KC,
+      builtins, compilerOptions);
+  Stmt *kernelStmts =
+    Hipacc->Hipacc(KC->getKernelBody());
+  kernelDecl->setBody(kernelStmts);
+  K->printStats();
+
+  #ifdef USE_POLLY
+  if (!compilerOptions.exploreConfig() && compilerOptions.emitC99()) {
+    llvm::errs() << "\nPassing the following function to Polly:\n";
+    kernelDecl->print(llvm::errs(), Context.getPrintingPolicy());
+    llvm::errs() << "\n";
+
+    Polly *polly_analysis = new Polly(Context, CI, kernelDecl);
+    polly_analysis->analyzeKernel();
+  }
+  #endif
+
+  // write kernel to file
+  printKernelFunction(kernelDecl, KC, K, K->getFileName(), true);
+}
+
+
 bool Rewrite::VisitFunctionDecl(FunctionDecl *D) {
   if (D->isMain()) {
     assert(D->getBody() && "main function has no body.");
     assert(isa<CompoundStmt>(D->getBody()) && "CompoundStmt for main body expected.");
     mainFD = D;
+
+    // search for producer/consumer kernels that can be fused
+    if (compilerOptions.fuseKernels())
+      findKernelFusions(dyn_cast<CompoundStmt>(D->getBody()));
+
+    // search for images that can be allocated with a halo
+    if (compilerOptions.padHalo())
+      findImageHalos(dyn_cast<CompoundStmt>(D->getBody()));
+  }
+
+  return true;
+}
+
+
+static bool containsReturnStmt(Stmt *S) {
+  if (!S) return false;
+
+  if (isa<ReturnStmt>(S)) return true;
+  // return statements within lambda-functions don't leave the kernel
+  if (isa<LambdaExpr>(S)) return false;
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    if (containsReturnStmt(*it)) return true;
+
+  return false;
+}
+
+
+static void findMemberCalls(Stmt *S, StringRef name,
+    SmallVectorImpl<CXXMemberCallExpr *> &calls) {
+  if (!S) return;
+
+  if (auto E = dyn_cast<CXXMemberCallExpr>(S))
+    if (E->getDirectCallee() && E->getDirectCallee()->getName() == name)
+      calls.push_back(E);
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    findMemberCalls(*it, name, calls);
+}
+
+
+// check if the statement is a plain assignment to output(), or a compound
+// statement executing one unconditionally
+static bool isOutputAssignment(Stmt *S, CXXMemberCallExpr *output) {
+  if (auto CS = dyn_cast<CompoundStmt>(S)) {
+    for (auto stmt : CS->body())
+      if (isOutputAssignment(stmt, output)) return true;
+    return false;
+  }
+
+  Expr *LHS = nullptr;
+  if (auto E = dyn_cast<ExprWithCleanups>(S)) S = E->getSubExpr();
+  if (auto BO = dyn_cast<BinaryOperator>(S)) {
+    if (BO->getOpcode() == BO_Assign) LHS = BO->getLHS();
+  } else if (auto OCE = dyn_cast<CXXOperatorCallExpr>(S)) {
+    if (OCE->getOperator() == OO_Equal) LHS = OCE->getArg(0);
+  }
+
+  return LHS && LHS->IgnoreParenImpCasts() == output;
+}
+
+
+// check if the kernel body assigns output() exactly once on every path: the
+// only use of output() is a plain assignment outside of control flow
+static bool assignsOutputOnce(Stmt *body) {
+  SmallVector<CXXMemberCallExpr *, 4> outputs;
+  findMemberCalls(body, "output", outputs);
+  if (outputs.size() != 1) return false;
+
+  return isOutputAssignment(body, outputs[0]);
+}
+
+
+// check if two images are declared with the same width and height
+static bool haveSameSize(ASTContext &Ctx, VarDecl *A, VarDecl *B) {
+  auto CCEA = dyn_cast_or_null<CXXConstructExpr>(A->getInit());
+  auto CCEB = dyn_cast_or_null<CXXConstructExpr>(B->getInit());
+  if (!CCEA || !CCEB || CCEA->getNumArgs() < 2 || CCEB->getNumArgs() < 2)
+    return false;
+
+  for (size_t i=0; i<2; ++i) {
+    Expr *EA = CCEA->getArg(i)->IgnoreParenImpCasts();
+    Expr *EB = CCEB->getArg(i)->IgnoreParenImpCasts();
+    if (EA->isEvaluatable(Ctx) && EB->isEvaluatable(Ctx)) {
+      if (EA->EvaluateKnownConstInt(Ctx).getSExtValue() !=
+          EB->EvaluateKnownConstInt(Ctx).getSExtValue())
+        return false;
+      continue;
+    }
+    auto DREA = dyn_cast<DeclRefExpr>(EA);
+    auto DREB = dyn_cast<DeclRefExpr>(EB);
+    if (!DREA || !DREB || DREA->getDecl() != DREB->getDecl()) return false;
   }
 
   return true;
 }
 
 
+// get the variable passed as first constructor argument of a DSL object and
+// the number of explicitly passed constructor arguments
+static VarDecl *getFirstArgDecl(VarDecl *VD, size_t &num_args) {
+  VarDecl *first = nullptr;
+  num_args = 0;
+
+  if (auto CCE = dyn_cast_or_null<CXXConstructExpr>(VD->getInit())) {
+    for (size_t i=0, e=CCE->getNumArgs(); i!=e; ++i) {
+      auto arg = CCE->getArg(i)->IgnoreParenCasts();
+      if (isa<CXXDefaultArgExpr>(arg)) continue;
+
+      if (num_args++ == 0) {
+        if (auto DRE = dyn_cast<DeclRefExpr>(arg))
+          first = dyn_cast<VarDecl>(DRE->getDecl());
+      }
+    }
+  }
+
+  return first;
+}
+
+
+// get the Image declaration an Accessor, IterationSpace, or BoundaryCondition
+// refers to
+VarDecl *Rewrite::getImageDecl(VarDecl *VD) {
+  size_t num_args;
+
+  while (VD) {
+    if (compilerClasses.isTypeOfTemplateClass(VD->getType(),
+          compilerClasses.Image))
+      return VD;
+
+    if (!compilerClasses.isTypeOfTemplateClass(VD->getType(),
+          compilerClasses.Accessor) &&
+        !compilerClasses.isTypeOfTemplateClass(VD->getType(),
+          compilerClasses.IterationSpace) &&
+        !compilerClasses.isTypeOfTemplateClass(VD->getType(),
+          compilerClasses.BoundaryCondition))
+      return nullptr;
+
+    VD = getFirstArgDecl(VD, num_args);
+  }
+
+  return nullptr;
+}
+
+
+// record the region of interest of an Accessor or IterationSpace if it is
+// known at compile time: the constant width and height arguments or the size
+// of the image
+void Rewrite::setROISize(HipaccAccessor *Acc, HipaccImage *Img,
+    ArrayRef<Expr *> roi_args) {
+  if (roi_args.size() >= 2) {
+    if (!roi_args[0]->isEvaluatable(Context) ||
+        !roi_args[1]->isEvaluatable(Context))
+      return;
+    int64_t width = roi_args[0]->EvaluateKnownConstInt(Context).getSExtValue();
+    int64_t height = roi_args[1]->EvaluateKnownConstInt(Context).getSExtValue();
+    if (width > 0 && height > 0)
+      Acc->setROISize(width, height);
+  } else if (Img) {
+    Acc->setROISize(Img->getSizeX(), Img->getSizeY());
+  }
+}
+
+
+// Search main for kernels whose output image is only read by the kernel
+// executed next, e.g.
+//    IterationSpace<int> IS_TMP(TMP); Accessor<int> AccTMP(TMP);
+//    Producer P(IS_TMP, AccIN); Consumer C(IS_OUT, AccTMP);
+//    P.execute(); C.execute();
+// The producer is computed on-the-fly within the consumer, the intermediate
+// image is not allocated. Only pixel-wise reads of the intermediate image
+// without boundary handling, interpolation, or cropping are supported. The
+// producer has to assign its output exactly once, and the intermediate image
+// has to match the size of the output image of the consumer: both iteration
+// spaces and the Accessor cover their whole image.
+void Rewrite::findKernelFusions(CompoundStmt *S) {
+  llvm::DenseMap<ValueDecl *, unsigned> uses, launches;
+  llvm::DenseMap<ValueDecl *, size_t> launchPos;
+  SmallVector<VarDecl *, 16> kernels;
+
+  auto getKernelClass = [&] (VarDecl *VD) -> HipaccKernelClass * {
+    if (VD->getType()->getTypeClass() != Type::Record) return nullptr;
+    const RecordType *RT = cast<RecordType>(VD->getType());
+    if (!KernelClassDeclMap.count(RT->getDecl())) return nullptr;
+    return KernelClassDeclMap[RT->getDecl()];
+  };
+  auto getArgDecl = [] (CXXConstructExpr *CCE, size_t i) -> VarDecl * {
+    if (auto DRE = dyn_cast<DeclRefExpr>(CCE->getArg(i)->IgnoreParenCasts()))
+      return dyn_cast<VarDecl>(DRE->getDecl());
+    return nullptr;
+  };
+  auto isFused = [&] (VarDecl *VD) {
+    for (auto &fusion : KernelFusions)
+      if (fusion.producer == VD || fusion.consumer == VD) return true;
+    return false;
+  };
+
+  countReferences(S, uses);
+
+  // collect kernel declarations and the position of kernel launches
+  size_t pos = 0;
+  for (auto it=S->body_begin(), ie=S->body_end(); it!=ie; ++it, ++pos) {
+    if (auto DS = dyn_cast<DeclStmt>(*it)) {
+      for (auto decl : DS->decls()) {
+        if (auto VD = dyn_cast<VarDecl>(decl))
+          if (getKernelClass(VD) &&
+              dyn_cast_or_null<CXXConstructExpr>(VD->getInit()))
+            kernels.push_back(VD);
+      }
+    }
+    if (auto E = dyn_cast<CXXMemberCallExpr>(*it)) {
+      if (auto DRE = dyn_cast<DeclRefExpr>(
+            E->getImplicitObjectArgument()->IgnoreParenCasts())) {
+        if (E->getDirectCallee() &&
+            E->getDirectCallee()->getNameAsString() == "execute") {
+          launches[DRE->getDecl()]++;
+          launchPos[DRE->getDecl()] = pos;
+        }
+      }
+    }
+  }
+
+  for (size_t c=0; c<kernels.size(); ++c) {
+    VarDecl *consumer = kernels[c];
+    HipaccKernelClass *KCC = getKernelClass(consumer);
+    CXXConstructExpr *CCEC = dyn_cast<CXXConstructExpr>(consumer->getInit());
+    if (isFused(consumer) || launches[consumer] != 1 ||
+        CCEC->getNumArgs() != KCC->getMembers().size() ||
+        KCC->getKernelType() == UserOperator)
+      continue;
+
+    // output image of the consumer; the iteration space has to cover the
+    // whole image
+    VarDecl *outImg = nullptr;
+    for (size_t i=0, e=CCEC->getNumArgs(); i!=e; ++i) {
+      VarDecl *VD = getArgDecl(CCEC, i);
+      size_t num_args;
+      if (VD && compilerClasses.isTypeOfTemplateClass(VD->getType(),
+            compilerClasses.IterationSpace) &&
+          getFirstArgDecl(VD, num_args) && num_args == 1)
+        outImg = getImageDecl(VD);
+    }
+    if (!outImg) continue;
+
+    for (size_t i=0, e=CCEC->getNumArgs(); i!=e && !isFused(consumer); ++i) {
+      // Accessor without boundary handling, interpolation, and cropping
+      VarDecl *acc = getArgDecl(CCEC, i);
+      if (!acc || !compilerClasses.isTypeOfTemplateClass(acc->getType(),
+            compilerClasses.Accessor))
+        continue;
+      size_t num_args;
+      VarDecl *img = getFirstArgDecl(acc, num_args);
+      if (!img || num_args != 1 ||
+          !compilerClasses.isTypeOfTemplateClass(img->getType(),
+            compilerClasses.Image))
+        continue;
+
+      // the image connects exactly one IterationSpace and this Accessor, has
+      // the size of the output image, and doesn't pass its rows to callbacks
+      if (uses[acc] != 1 || uses[img] != 2 ||
+          !haveSameSize(Context, img, outImg) || isStreamedImage(img))
+        continue;
+
+      // Accessor is only read pixel-wise
+      FieldDecl *fusedField = KCC->getMembers()[i].field;
+      if (KCC->getImgAccess(fusedField) != READ_ONLY ||
+          KCC->getImgAccessDetail(fusedField) != NO_STRIDE)
+        continue;
+
+      // search for the producer writing the image, declared before the
+      // consumer and launched directly before the consumer
+      for (size_t p=0; p<c; ++p) {
+        VarDecl *producer = kernels[p];
+        HipaccKernelClass *KCP = getKernelClass(producer);
+        CXXConstructExpr *CCEP =
+          dyn_cast<CXXConstructExpr>(producer->getInit());
+        if (isFused(producer) || KCP == KCC || uses[producer] != 1 ||
+            launches[producer] != 1 ||
+            launchPos[producer]+1 != launchPos[consumer] ||
+            CCEP->getNumArgs() != KCP->getMembers().size())
+          continue;
+
+        size_t is_arg = CCEP->getNumArgs();
+        for (size_t j=0, je=CCEP->getNumArgs(); j!=je; ++j) {
+          VarDecl *IS = getArgDecl(CCEP, j);
+          size_t num_is_args;
+          if (IS && compilerClasses.isTypeOfTemplateClass(IS->getType(),
+                compilerClasses.IterationSpace) &&
+              getFirstArgDecl(IS, num_is_args) == img && num_is_args == 1 &&
+              uses[IS] == 1)
+            is_arg = j;
+        }
+        if (is_arg == CCEP->getNumArgs()) continue;
+
+        // the producer writes only to the current pixel, exactly once,
+        // doesn't return early, and has no global reduction, scan, or
+        // histogram
+        if (KCP->getReduceFunction() || KCP->getScanFunction() ||
+            KCP->getBinningFunction() ||
+            KCP->getKernelType() == UserOperator ||
+            KCP->getKernelStatistics().getOutAccessDetail() != NO_STRIDE ||
+            containsReturnStmt(KCP->getKernelFunction()->getBody()) ||
+            !assignsOutputOnce(KCP->getKernelFunction()->getBody()))
+          continue;
+
+        // member names have to be unique within the fused kernel
+        std::set<std::string> names;
+        for (auto member : KCC->getMembers())
+          if (member.field != fusedField) names.insert(member.name);
+        bool unique = true;
+        for (size_t j=0, je=CCEP->getNumArgs(); j!=je; ++j) {
+          if (j == is_arg) continue;
+          if (names.count(KCP->getMembers()[j].name)) unique = false;
+
+          // the producer must not read the output image of the consumer and
+          // Masks are not shared between both kernels
+          VarDecl *VD = getArgDecl(CCEP, j);
+          if (VD && compilerClasses.isTypeOfTemplateClass(VD->getType(),
+                compilerClasses.Accessor)) {
+            VarDecl *in = getImageDecl(VD);
+            if (!in || in == outImg) unique = false;
+          }
+          for (size_t k=0, ke=CCEC->getNumArgs(); VD && k!=ke; ++k) {
+            if (getArgDecl(CCEC, k) == VD &&
+                (compilerClasses.isTypeOfTemplateClass(VD->getType(),
+                  compilerClasses.Mask) ||
+                 compilerClasses.isTypeOfClass(VD->getType(),
+                   compilerClasses.Domain)))
+              unique = false;
+          }
+        }
+        if (!unique) continue;
+
+        KernelFusion fusion;
+        fusion.producer = producer;
+        fusion.consumer = consumer;
+        fusion.image = img;
+        fusion.iterationSpace = getArgDecl(CCEP, is_arg);
+        fusion.accessor = acc;
+        fusion.iterationSpaceArg = is_arg;
+        fusion.accessorArg = i;
+        KernelFusions.push_back(fusion);
+
+        FusedDecls.insert(img);
+        FusedDecls.insert(fusion.iterationSpace);
+        FusedDecls.insert(acc);
+        break;
+      }
+    }
+  }
+}
+
+
+Rewrite::KernelFusion *Rewrite::getKernelFusion(ValueDecl *consumer) {
+  for (auto &fusion : KernelFusions)
+    if (fusion.consumer == consumer) return &fusion;
+  return nullptr;
+}
+
+
+bool Rewrite::isFusedProducer(ValueDecl *producer) {
+  for (auto &fusion : KernelFusions)
+    if (fusion.producer == producer) return true;
+  return false;
+}
+
+
+// Create the kernel computing the producer of a fusion within the consumer:
+// the members of the consumer are followed by those of the producer, except
+// for the IterationSpace and Accessor connecting both kernels. The kernel body
+// evaluates the producer into a temporary read by the consumer, e.g.
+//    { int _fusedTMP; { producer body } { consumer body } }
+HipaccKernel *Rewrite::createFusedKernel(KernelFusion &fusion,
+    HipaccKernel *K) {
+  HipaccKernel *KP = FusedProducerMap[fusion.producer];
+  HipaccKernelClass *KCP = KP->getKernelClass();
+  HipaccKernelClass *KCC = K->getKernelClass();
+  FieldDecl *fusedField = KCC->getMembers()[fusion.accessorArg].field;
+  FieldDecl *isField = KCP->getMembers()[fusion.iterationSpaceArg].field;
+
+  HipaccKernelClass *KC = new HipaccKernelClass(KCP->getName() +
+      KCC->getName());
+  KC->setKernelFunction(KCC->getKernelFunction());
+  KC->setReduceFunction(KCC->getReduceFunction());
+  KC->setScanFunction(KCC->getScanFunction());
+  KC->setBinningFunction(KCC->getBinningFunction());
+  KC->setKernelStatistics(&KCC->getKernelStatistics());
+  KC->addMembers(KCC, fusedField);
+  KC->addMembers(KCP, isField);
+
+  VarDecl *fusedVar = createVarDecl(Context, KCC->getKernelFunction(),
+      "_fused" + fusion.image->getNameAsString(),
+      compilerClasses.getFirstTemplateType(fusion.image->getType()));
+  KC->setProducer(KCP, fusedField, fusedVar);
+
+  SmallVector<Stmt *, 3> body;
+  body.push_back(createDeclStmt(Context, fusedVar));
+  body.push_back(KCP->getKernelBody());
+  body.push_back(KCC->getKernelBody());
+  KC->setKernelBody(createCompoundStmt(Context, body));
+
+  HipaccKernel *KF = new HipaccKernel(Context, fusion.consumer, KC,
+      compilerOptions);
+
+  // map members to the objects of the original kernels
+  for (auto img : KC->getImgFields()) {
+    HipaccAccessor *Acc = K->getImgFromMapping(img);
+
+    if (Acc && Acc == K->getIterationSpace()) {
+      KF->insertMapping(img, K->getIterationSpace());
+      continue;
+    }
+
+    if (!Acc) {
+      Acc = KP->getImgFromMapping(img);
+      // Accessors read by both kernels require separate kernel parameters
+      for (auto field : KCC->getImgFields()) {
+        if (K->getImgFromMapping(field) == Acc) {
+          Acc = new HipaccAccessor(*Acc);
+          break;
+        }
+      }
+    }
+    KF->insertMapping(img, Acc);
+  }
+  for (auto mask : KC->getMaskFields()) {
+    HipaccMask *Mask = K->getMaskFromMapping(mask);
+    if (!Mask) Mask = KP->getMaskFromMapping(mask);
+    KF->insertMapping(mask, Mask);
+  }
+
+  // host arguments in the order of the kernel members
+  CXXConstructExpr *CCEC = dyn_cast<CXXConstructExpr>(
+      fusion.consumer->getInit());
+  CXXConstructExpr *CCEP = dyn_cast<CXXConstructExpr>(
+      fusion.producer->getInit());
+  for (size_t i=0, e=CCEC->getNumArgs(); i!=e; ++i)
+    if (i != fusion.accessorArg) fusion.hostArgs.push_back(CCEC->getArg(i));
+  for (size_t i=0, e=CCEP->getNumArgs(); i!=e; ++i)
+    if (i != fusion.iterationSpaceArg)
+      fusion.hostArgs.push_back(CCEP->getArg(i));
+
+  return KF;
+}
+
+
+static llvm::APFloat getFloatValue(ASTContext &Ctx, QualType QT, double value) {
+  llvm::APFloat fval(value);
+  bool loses_info;
+  fval.convert(Ctx.getFloatTypeSemantics(QT),
+      llvm::APFloat::rmNearestTiesToEven, &loses_info);
+  return fval;
+}
+
+
+// collect all declaration statements nested in a statement
+static void findDeclStmts(Stmt *S, SmallVectorImpl<DeclStmt *> &decls) {
+  if (!S) return;
+
+  if (auto DS = dyn_cast<DeclStmt>(S))
+    decls.push_back(DS);
+
+  for (auto it=S->child_begin(), ie=S->child_end(); it!=ie; ++it)
+    findDeclStmts(*it, decls);
+}
+
+
+// Search main for images whose BoundaryConditions all use the same boundary
+// mode, e.g.
+//    BoundaryCondition<uchar> BcIn(IN, 5, 5, Boundary::MIRROR);
+//    Accessor<uchar> AccIn(BcIn);
+// The image is allocated with a halo of 2x2 pixels that is filled by the
+// runtime whenever the image is written, so that Accessors on the image can
+// read the halo instead of applying border handling.
+void Rewrite::findImageHalos(CompoundStmt *S) {
+  auto getArgDecl = [] (Expr *E) -> VarDecl * {
+    if (auto DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenCasts()))
+      return dyn_cast<VarDecl>(DRE->getDecl());
+    return nullptr;
+  };
+  auto isMask = [&] (VarDecl *VD) {
+    return compilerClasses.isTypeOfTemplateClass(VD->getType(),
+             compilerClasses.Mask) ||
+           compilerClasses.isTypeOfClass(VD->getType(),
+             compilerClasses.Domain);
+  };
+  // get the size of a Mask or Domain from the array it is initialized with
+  auto getMaskSize = [&] (VarDecl *VD, unsigned &size_x, unsigned &size_y) {
+    while (VD && isMask(VD)) {
+      auto CCE = dyn_cast_or_null<CXXConstructExpr>(VD->getInit());
+      if (!CCE) return false;
+      if (CCE->getNumArgs() == 2) {
+        // Domain(size_x, size_y)
+        if (!CCE->getArg(0)->isEvaluatable(Context) ||
+            !CCE->getArg(1)->isEvaluatable(Context))
+          return false;
+        size_x = CCE->getArg(0)->EvaluateKnownConstInt(Context).getZExtValue();
+        size_y = CCE->getArg(1)->EvaluateKnownConstInt(Context).getZExtValue();
+        return true;
+      }
+      if (CCE->getNumArgs() != 1) return false;
+      VD = getArgDecl(CCE->getArg(0));
+    }
+    if (!VD) return false;
+
+    auto Array = Context.getAsConstantArrayType(VD->getType());
+    if (!Array) return false;
+    size_y = Array->getSize().getZExtValue();
+    Array = Context.getAsConstantArrayType(Array->getElementType());
+    if (!Array) return false;
+    size_x = Array->getSize().getZExtValue();
+    return true;
+  };
+  auto invalidate = [&] (VarDecl *Img) {
+    ImageHalos[Img] = { Boundary::UNDEFINED, 0, 0, nullptr, false };
+  };
+
+  // BoundaryConditions in nested scopes have to be considered as well
+  SmallVector<DeclStmt *, 16> decls;
+  findDeclStmts(S, decls);
+
+  for (auto DS : decls) {
+    for (auto decl : DS->decls()) {
+      auto VD = dyn_cast<VarDecl>(decl);
+      if (!VD) continue;
+      auto CCE = dyn_cast_or_null<CXXConstructExpr>(VD->getInit());
+      if (!CCE || !CCE->getNumArgs()) continue;
+
+      // the levels of a Pyramid are allocated by the runtime
+      if (compilerClasses.isTypeOfTemplateClass(VD->getType(),
+            compilerClasses.Pyramid)) {
+        if (auto Img = getArgDecl(CCE->getArg(0)))
+          invalidate(Img);
+        continue;
+      }
+
+      if (!compilerClasses.isTypeOfTemplateClass(VD->getType(),
+            compilerClasses.BoundaryCondition))
+        continue;
+
+      // BoundaryConditions on Pyramid calls are not considered
+      VarDecl *Img = getArgDecl(CCE->getArg(0));
+      if (!Img || !compilerClasses.isTypeOfTemplateClass(Img->getType(),
+            compilerClasses.Image))
+        continue;
+
+      ImageHalo halo = { Boundary::UNDEFINED, 0, 0, nullptr, true };
+      size_t size_args = 0;
+      for (size_t i=1, e=CCE->getNumArgs(); i!=e; ++i) {
+        auto arg = CCE->getArg(i)->IgnoreParenCasts();
+        if (isa<CXXDefaultArgExpr>(arg)) continue;
+
+        if (auto DRE = dyn_cast<DeclRefExpr>(arg)) {
+          if (DRE->getDecl()->getKind() == Decl::EnumConstant &&
+              DRE->getDecl()->getType().getAsString() ==
+              "enum hipacc::Boundary") {
+            halo.mode = static_cast<Boundary>(
+                arg->EvaluateKnownConstInt(Context).getZExtValue());
+            if (halo.mode == Boundary::CONSTANT && i+1 != e)
+              halo.const_val = CCE->getArg(++i);
+            continue;
+          }
+          if (auto V = dyn_cast<VarDecl>(DRE->getDecl())) {
+            if (isMask(V)) {
+              if (!getMaskSize(V, halo.size_x, halo.size_y))
+                halo.valid = false;
+              continue;
+            }
+          }
+        }
+
+        if (!arg->isEvaluatable(Context)) {
+          halo.valid = false;
+          continue;
+        }
+        unsigned size = arg->EvaluateKnownConstInt(Context).getZExtValue();
+        if (size_args++ == 0) {
+          halo.size_x = size;
+          halo.size_y = size;
+        } else {
+          halo.size_y = size;
+        }
+      }
+
+      // reads without boundary handling do not depend on the halo
+      if (halo.mode == Boundary::UNDEFINED) continue;
+      if (halo.mode == Boundary::CONSTANT && !halo.const_val)
+        halo.valid = false;
+
+      if (!ImageHalos.count(Img)) {
+        ImageHalos[Img] = halo;
+        continue;
+      }
+
+      // the halo can be filled according to one boundary mode only
+      ImageHalo &prev = ImageHalos[Img];
+      double prev_val, val;
+      if (!prev.valid || !halo.valid || prev.mode != halo.mode ||
+          (halo.mode == Boundary::CONSTANT &&
+           (!getConstantValue(Context, prev.const_val, prev_val) ||
+            !getConstantValue(Context, halo.const_val, val) ||
+            prev_val != val))) {
+        invalidate(Img);
+        continue;
+      }
+      prev.size_x = std::max(prev.size_x, halo.size_x);
+      prev.size_y = std::max(prev.size_y, halo.size_y);
+    }
+  }
+}
+
+
+// check whether the halo of the image provides the pixels read through the
+// BoundaryCondition: the halo has to be filled according to the same boundary
+// mode and constant, and has to be at least as large as half the window
+bool Rewrite::isCoveredByHalo(HipaccBoundaryCondition *BC) {
+  HipaccImage *Img = BC->getImage();
+  if (BC->getBoundaryMode() != Img->getHaloMode() ||
+      BC->getSizeX()/2 > Img->getHaloX() || BC->getSizeY()/2 > Img->getHaloY())
+    return false;
+
+  if (BC->getBoundaryMode() == Boundary::CONSTANT) {
+    auto iter = ImageHalos.find(Img->getDecl());
+    double val, halo_val;
+    if (iter == ImageHalos.end() || !iter->second.const_val ||
+        !BC->getConstExpr() ||
+        !getConstantValue(Context, BC->getConstExpr(), val) ||
+        !getConstantValue(Context, iter->second.const_val, halo_val) ||
+        val != halo_val)
+      return false;
+  }
+
+  return true;
+}
+
+
+// Split kernels convolving an Accessor with a constant Mask of rank one, e.g.
+//    output() = (uchar)(convolve(mask, Reduce::SUM, [&] () -> float {
+//                 return mask() * input(mask); }) + 0.5f);
+// into a row kernel writing the convolution of the input with the row vector
+// of the Mask to an intermediate image and the original kernel, which reads
+// the intermediate image and uses the column vector of the Mask. The
+// intermediate image and its Accessor are declared in hostStr. Returns the
+// column kernel or nullptr if the kernel can't be separated.
+HipaccKernel *Rewrite::createSeparatedKernels(HipaccKernel *K,
+    std::string &hostStr) {
+  HipaccKernelClass *KC = K->getKernelClass();
+  HipaccIterationSpace *IS = K->getIterationSpace();
+  VarDecl *VD = K->getDecl();
+  CXXConstructExpr *CCE = dyn_cast<CXXConstructExpr>(VD->getInit());
+
+  if (KC->getReduceFunction() || KC->getKernelType() == UserOperator ||
+      CCE->getNumArgs() != KC->getMembers().size() || IS->isCrop())
+    return nullptr;
+
+  // a single convolution computing the sum over the Mask
+  SmallVector<CXXMemberCallExpr *, 4> convolutions, outputs;
+  findMemberCalls(KC->getKernelBody(), "convolve", convolutions);
+  findMemberCalls(KC->getKernelBody(), "output", outputs);
+  if (convolutions.size() != 1 || outputs.empty()) return nullptr;
+  CXXMemberCallExpr *conv = convolutions[0];
+
+  llvm::APSInt mode;
+  if (!conv->getArg(1)->EvaluateAsInt(mode, Context) ||
+      static_cast<Reduce>(mode.getZExtValue()) != Reduce::SUM)
+    return nullptr;
+
+  auto ME = dyn_cast<MemberExpr>(conv->getArg(0)->IgnoreImpCasts());
+  FieldDecl *maskField = ME ? dyn_cast<FieldDecl>(ME->getMemberDecl()) :
+    nullptr;
+  HipaccMask *Mask = maskField ? K->getMaskFromMapping(maskField) : nullptr;
+  if (!Mask || Mask->isDomain() || !Mask->isConstant() ||
+      !Mask->getType()->isRealFloatingType() ||
+      Mask->getSizeX() < 2 || Mask->getSizeY() < 2)
+    return nullptr;
+
+  // the lambda-function returns mask() * acc(mask) or acc(mask) * mask()
+  auto MTE = dyn_cast<MaterializeTemporaryExpr>(conv->getArg(2));
+  auto LE = MTE ?
+    dyn_cast<LambdaExpr>(MTE->GetTemporaryExpr()->IgnoreImpCasts()) : nullptr;
+  auto LB = LE ? dyn_cast<CompoundStmt>(LE->getBody()) : nullptr;
+  if (!LB || LB->size() != 1 || !isa<ReturnStmt>(LB->body_back()))
+    return nullptr;
+  Expr *RV = dyn_cast<ReturnStmt>(LB->body_back())->getRetValue();
+  auto BO = RV ? dyn_cast<BinaryOperator>(RV->IgnoreParenCasts()) : nullptr;
+  if (!BO || BO->getOpcode() != BO_Mul) return nullptr;
+
+  FieldDecl *accField = nullptr;
+  bool readsMask = false;
+  for (auto operand : { BO->getLHS(), BO->getRHS() }) {
+    auto call = dyn_cast<CXXOperatorCallExpr>(operand->IgnoreParenCasts());
+    if (!call || call->getOperator() != OO_Call) return nullptr;
+    auto obj = dyn_cast<MemberExpr>(call->getArg(0)->IgnoreImpCasts());
+    auto FD = obj ? dyn_cast<FieldDecl>(obj->getMemberDecl()) : nullptr;
+    if (!FD) return nullptr;
+
+    if (FD == maskField && call->getNumArgs() == 1) {
+      readsMask = true;
+      continue;
+    }
+    auto arg = call->getNumArgs() == 2 ?
+      dyn_cast<MemberExpr>(call->getArg(1)->IgnoreImpCasts()) : nullptr;
+    if (!arg || arg->getMemberDecl() != maskField ||
+        !K->getImgFromMapping(FD) || K->getImgFromMapping(FD) == IS)
+      return nullptr;
+    accField = FD;
+  }
+  if (!readsMask || !accField) return nullptr;
+
+  // Accessor and Mask are used only within the convolution
+  llvm::DenseMap<ValueDecl *, unsigned> uses, conv_uses;
+  countReferences(KC->getKernelBody(), uses);
+  countReferences(conv, conv_uses);
+  if (uses[accField] != conv_uses[accField] ||
+      uses[maskField] != conv_uses[maskField])
+    return nullptr;
+
+  // the intermediate image stores the floating point result of the lambda;
+  // it has no halo, hence input images with halo are not separated
+  HipaccAccessor *Acc = K->getImgFromMapping(accField);
+  HipaccBoundaryCondition *BC = Acc->getBC();
+  QualType QT = conv->getType().getUnqualifiedType();
+  QualType ET = QT->isVectorType() ?
+    QT->getAs<VectorType>()->getElementType() : QT;
+  if (Acc->getInterpolationMode() != Interpolate::NO || Acc->isCrop() ||
+      BC->isPyramid() || BC->getImage()->hasHalo() ||
+      !ET->isRealFloatingType() ||
+      (BC->getBoundaryMode() == Boundary::CONSTANT && QT->isVectorType()))
+    return nullptr;
+
+  // mask(x, y) = col[y] * row[x]
+  size_t size_x = Mask->getSizeX(), size_y = Mask->getSizeY();
+  std::vector<double> coeffs(size_x*size_y);
+  size_t pivot = 0;
+  for (size_t i=0; i<coeffs.size(); ++i) {
+    if (!getConstantValue(Context, Mask->getInitExpr(i % size_x, i / size_x),
+          coeffs[i]))
+      return nullptr;
+    if (std::fabs(coeffs[i]) > std::fabs(coeffs[pivot])) pivot = i;
+  }
+  double max = std::fabs(coeffs[pivot]);
+  if (max == 0) return nullptr;
+
+  std::vector<double> row(size_x), col(size_y);
+  for (size_t x=0; x<size_x; ++x)
+    row[x] = coeffs[(pivot / size_x)*size_x + x];
+  for (size_t y=0; y<size_y; ++y)
+    col[y] = coeffs[y*size_x + pivot % size_x] / coeffs[pivot];
+  for (size_t y=0; y<size_y; ++y)
+    for (size_t x=0; x<size_x; ++x)
+      if (std::fabs(col[y]*row[x] - coeffs[y*size_x + x]) > 1e-5*max)
+        return nullptr;
+
+  // constant Masks holding the row and column vectors
+  std::string name = VD->getNameAsString();
+  auto createMask = [&] (ArrayRef<double> values, bool is_row,
+      std::string suffix) -> HipaccMask * {
+    VarDecl *maskVD = createVarDecl(Context, VD->getDeclContext(),
+        Mask->getDecl()->getNameAsString() + suffix,
+        Mask->getDecl()->getType());
+    HipaccMask *M = new HipaccMask(maskVD, Mask->getType(),
+        HipaccMask::MaskType::Mask);
+
+    SmallVector<Expr *, 16> inits;
+    for (auto value : values) {
+      Expr *lit = FloatingLiteral::Create(Context, getFloatValue(Context,
+            Mask->getType(), value), false, Mask->getType(), SourceLocation());
+      if (is_row) inits.push_back(lit);
+      else inits.push_back(new (Context) InitListExpr(Context,
+            SourceLocation(), lit, SourceLocation()));
+    }
+    InitListExpr *init_list = new (Context) InitListExpr(Context,
+        SourceLocation(), inits, SourceLocation());
+    if (is_row)
+      init_list = new (Context) InitListExpr(Context, SourceLocation(),
+          init_list, SourceLocation());
+
+    M->setSizeX(is_row ? values.size() : 1);
+    M->setSizeY(is_row ? 1 : values.size());
+    M->setIsConstant(true);
+    M->setInitList(init_list);
+    return M;
+  };
+
+  // intermediate image and its Accessor, used as IterationSpace by the row
+  // kernel
+  HipaccImage *In = Acc->getImage();
+  VarDecl *imgVD = createVarDecl(Context, VD->getDeclContext(), "_sep" + name,
+      QT);
+  HipaccImage *Img = new HipaccImage(Context, imgVD, QT);
+  if (compilerOptions.emitC99()) {
+    Img->setSizeX(In->getSizeX());
+    Img->setSizeY(In->getSizeY());
+  }
+  VarDecl *tmpVD = createVarDecl(Context, VD->getDeclContext(),
+      "_sepAcc" + name, QT);
+  HipaccIterationSpace *ISRow = new HipaccIterationSpace(tmpVD, Img, false);
+
+  // the row kernel handles the horizontal border, the column kernel the
+  // vertical border; constant pixels outside the image are convolved with the
+  // row vector before
+  HipaccBoundaryCondition *BCRow = new HipaccBoundaryCondition(Acc->getDecl(),
+      In);
+  BCRow->setSizeX(BC->getSizeX());
+  BCRow->setSizeY(1);
+  BCRow->setBoundaryMode(BC->getBoundaryMode());
+  HipaccBoundaryCondition *BCCol = new HipaccBoundaryCondition(tmpVD, Img);
+  BCCol->setSizeX(1);
+  BCCol->setSizeY(BC->getSizeY());
+  BCCol->setBoundaryMode(BC->getBoundaryMode());
+  if (BC->getBoundaryMode() == Boundary::CONSTANT) {
+    Expr::EvalResult val;
+    double const_val, row_sum = 0;
+    if (!BC->getConstExpr()->EvaluateAsRValue(val, Context) ||
+        !getConstantValue(Context, BC->getConstExpr(), const_val))
+      return nullptr;
+    for (auto value : row) row_sum += value;
+    BCRow->setConstVal(val.Val, Context);
+    APValue col_val(getFloatValue(Context, QT, const_val*row_sum));
+    BCCol->setConstVal(col_val, Context);
+  }
+  HipaccAccessor *AccRow = new HipaccAccessor(Acc->getDecl(), BCRow,
+      Interpolate::NO, false);
+  HipaccAccessor *AccCol = new HipaccAccessor(tmpVD, BCCol, Interpolate::NO,
+      false);
+  // the intermediate image has the same size as the input image
+  for (auto A : { AccRow, AccCol, static_cast<HipaccAccessor *>(ISRow) })
+    A->setROISize(Acc->getROIWidth(), Acc->getROIHeight());
+
+  // row kernel: output() = convolve(...);
+  KernelSeparation separation;
+  separation.kernel = VD;
+  HipaccKernelClass *KCR = new HipaccKernelClass(KC->getName());
+  KCR->setKernelFunction(KC->getKernelFunction());
+  KCR->setKernelStatistics(&KC->getKernelStatistics());
+  FieldDecl *isField = nullptr;
+  for (size_t i=0, e=KC->getMembers().size(); i!=e; ++i) {
+    auto member = KC->getMembers()[i];
+    if (member.field == accField) {
+      KCR->addImgArg(member.field, member.type, member.name);
+    } else if (member.field == maskField) {
+      KCR->addMaskArg(member.field, member.type, member.name);
+    } else if (K->getImgFromMapping(member.field) == IS) {
+      KCR->addISArg(member.field, QT, member.name);
+      isField = member.field;
+    } else {
+      continue;
+    }
+    separation.hostArgs.push_back(CCE->getArg(i));
+  }
+  Stmt *body = createBinaryOperator(Context, outputs[0], conv, BO_Assign, QT);
+  KCR->setKernelBody(createCompoundStmt(Context, body));
+
+  VarDecl *rowVD = createVarDecl(Context, VD->getDeclContext(), name + "Row",
+      VD->getType());
+  separation.rowKernel = new HipaccKernel(Context, rowVD, KCR,
+      compilerOptions);
+  separation.rowKernel->insertMapping(isField, ISRow);
+  separation.rowKernel->insertMapping(accField, AccRow);
+  separation.rowKernel->insertMapping(maskField, createMask(row, true, "Row"));
+
+  // column kernel: original kernel reading the intermediate image
+  HipaccKernelClass *KCC = new HipaccKernelClass(KC->getName());
+  KCC->setKernelFunction(KC->getKernelFunction());
+  KCC->setScanFunction(KC->getScanFunction());
+  KCC->setBinningFunction(KC->getBinningFunction());
+  KCC->setKernelStatistics(&KC->getKernelStatistics());
+  KCC->addMembers(KC, nullptr);
+  KCC->setMemberType(accField, QT);
+
+  HipaccKernel *KS = new HipaccKernel(Context, VD, KCC, compilerOptions);
+  for (auto img : KCC->getImgFields()) {
+    if (img == isField) KS->insertMapping(img, IS);
+    else if (img == accField) KS->insertMapping(img, AccCol);
+    else KS->insertMapping(img, K->getImgFromMapping(img));
+  }
+  for (auto mask : KCC->getMaskFields()) {
+    if (mask == maskField) KS->insertMapping(mask, createMask(col, false,
+          "Col"));
+    else KS->insertMapping(mask, K->getMaskFromMapping(mask));
+  }
+
+  // allocate the intermediate image
+  stringCreator.writeMemoryAllocation(Img, In->getName() + ".width",
+      In->getName() + ".height", "NULL", hostStr);
+  hostStr += "\n" + stringCreator.getIndent();
+  hostStr += "HipaccAccessor " + ISRow->getName() + "(" + Img->getName() +
+    ");\n" + stringCreator.getIndent();
+  ImgDeclMap[imgVD] = Img;
+  KernelDeclMap[rowVD] = separation.rowKernel;
+  KernelSeparations.push_back(separation);
+
+  return KS;
+}
+
+
+Rewrite::KernelSeparation *Rewrite::getKernelSeparation(ValueDecl *kernel) {
+  for (auto &separation : KernelSeparations)
+    if (separation.kernel == kernel) return &separation;
+  return nullptr;
+}
+
+
 bool Rewrite::VisitCXXOperatorCallExpr(CXXOperatorCallExpr *E) {
   if (!compilerClasses.HipaccEoP) return true;
 
@@ -1616,10 +2716,23 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
   //    float *out = img.data();
   // c) convert reduced_data() calls
   //    float min = MinReduction.reduced_data();
-  // d) convert width()/height() calls
+  // d) convert binned_data() calls
+  //    std::vector<uint> hist = Histogram.binned_data(256);
+  // e) convert width()/height() calls
 
   if (auto DRE =
       dyn_cast<DeclRefExpr>(E->getImplicitObjectArgument()->IgnoreParenCasts())) {
+    // remove execute calls of producers computed within a fused kernel
+    if (FusedProducerMap.count(DRE->getDecl()) &&
+        E->getDirectCallee()->getNameAsString() == "execute") {
+      SourceLocation startLoc = E->getLocStart();
+      const char *startBuf = SM.getCharacterData(startLoc);
+      const char *semiPtr = strchr(startBuf, ';');
+      TextRewriter.RemoveText(startLoc, semiPtr-startBuf+1, TextRewriteOptions);
+
+      return true;
+    }
+
     // match execute calls to user kernel instances
     if (!KernelDeclMap.empty() &&
         E->getDirectCallee()->getNameAsString() == "execute") {
@@ -1631,20 +2744,72 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
 
         // this was checked before, when the user class was parsed
         CXXConstructExpr *CCE = dyn_cast<CXXConstructExpr>(VD->getInit());
-        assert(CCE->getNumArgs()==K->getKernelClass()->getMembers().size() &&
+        ArrayRef<Expr *> hostArgs(CCE->getArgs(), CCE->getNumArgs());
+        // fused kernels take the arguments of producer and consumer
+        if (KernelFusion *fusion = getKernelFusion(VD))
+          hostArgs = fusion->hostArgs;
+        assert(hostArgs.size()==K->getKernelClass()->getMembers().size() &&
             "number of arguments doesn't match!");
 
         // set host argument names and retrieve literals stored to temporaries
-        K->setHostArgNames(llvm::makeArrayRef(CCE->getArgs(),
-              CCE->getNumArgs()), newStr, literalCount);
+        K->setHostArgNames(hostArgs, newStr, literalCount);
+
+        // streamed images are backed by a rolling buffer holding the rows
+        // around the current strip of the iteration space
+        if (compilerOptions.streamExecution()) {
+          unsigned DiagIDStream = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+              "Accessor %0 of kernel %1 can't be streamed: %2.");
+          for (auto img : K->getKernelClass()->getImgFields()) {
+            HipaccAccessor *Acc = K->getImgFromMapping(img);
+            if (!Acc || Acc == K->getIterationSpace()) continue;
+            if (Acc->isCrop())
+              Diags.Report(E->getExprLoc(), DiagIDStream) << Acc->getName()
+                << K->getName() << "offset and region of interest not supported";
+            else if (Acc->getInterpolationMode() != Interpolate::NO)
+              Diags.Report(E->getExprLoc(), DiagIDStream) << Acc->getName()
+                << K->getName() << "interpolation not supported";
+          }
+          // global operators require the whole output image in memory
+          HipaccKernelClass *KC = K->getKernelClass();
+          if (K->getIterationSpace()->getImage()->isStreamed() &&
+              (KC->getReduceFunction() || KC->getScanFunction() ||
+               KC->getBinningFunction())) {
+            unsigned DiagIDGlobal = Diags.getCustomDiagID(
+                DiagnosticsEngine::Error, "Kernel %0 can't write to streamed "
+                "Image %1: reductions, scans, and histograms are not supported.");
+            Diags.Report(E->getExprLoc(), DiagIDGlobal) << K->getName()
+              << K->getIterationSpace()->getImage()->getName();
+          }
+          if (K->getStreamOffsetY() < 0) {
+            unsigned DiagIDRows = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                "Rows read around the current pixel by kernel %0 can't be "
+                "determined for streaming execution.");
+            Diags.Report(E->getExprLoc(), DiagIDRows) << K->getName();
+          }
+        }
 
         //
         // TODO: handle the case when only reduce function is specified
         //
+        // separated kernels launch the row kernel first
+        if (KernelSeparation *separation = getKernelSeparation(VD)) {
+          HipaccKernel *KR = separation->rowKernel;
+          KR->setHostArgNames(separation->hostArgs, newStr, literalCount);
+          stringCreator.writeKernelCall(KR->getKernelName(),
+              KR->getKernelClass(), KR, newStr);
+          newStr += "\n" + stringCreator.getIndent();
+        }
+
         // create kernel call string
         stringCreator.writeKernelCall(K->getKernelName(), K->getKernelClass(),
             K, newStr);
 
+        // create scan call string
+        if (K->getKernelClass()->getScanFunction()) {
+          newStr += "\n" + stringCreator.getIndent();
+          stringCreator.writeScanCall(K, newStr);
+        }
+
         // create reduce call string
         if (K->getKernelClass()->getReduceFunction()) {
           newStr += "\n" + stringCreator.getIndent();
@@ -1677,6 +2842,27 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
           SourceRange range(E->getLocStart(), E->getLocEnd());
           TextRewriter.ReplaceText(range, K->getReduceStr());
 
+          return true;
+        }
+        if (ME->getMemberNameInfo().getAsString() == "binned_data") {
+          HipaccKernel *K = KernelDeclMap[DRE->getDecl()];
+
+          if (!K->getKernelClass()->getBinningFunction()) {
+            unsigned DiagIDBin = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                "binned_data() requires a bin function in kernel class %0.");
+            Diags.Report(E->getExprLoc(), DiagIDBin)
+              << K->getKernelClass()->getName();
+            return true;
+          }
+
+          // replace member function invocation up to the number of bins,
+          // which is the last argument of the binning function
+          stringCreator.writeBinningCall(K, newStr);
+          SourceLocation startLoc = E->getLocStart();
+          const char *startBuf = SM.getCharacterData(startLoc);
+          const char *parenPtr = strchr(startBuf, '(');
+          TextRewriter.ReplaceText(startLoc, parenPtr-startBuf+1, newStr);
+
           return true;
         }
       }
@@ -1777,7 +2963,7 @@ void Rewrite::setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K) {
   // create kernel body
   ASTTranslate *HipaccEst = new ASTTranslate(Context, kernelDeclEst, K, KC,
       builtins, compilerOptions, true);
-  Stmt *kernelStmtsEst = HipaccEst->Hipacc(KC->getKernelFunction()->getBody());
+  Stmt *kernelStmtsEst = HipaccEst->Hipacc(KC->getKernelBody());
   kernelDeclEst->setBody(kernelStmtsEst);
 
   // write kernel to file
@@ -1923,20 +3109,61 @@ void Rewrite::setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K) {
 }
 
 
+// Print the binary function of a global operator, e.g. the reduce function of
+// a kernel, as inline function with the given name. For CUDA, the function
+// opens an extern "C" block, which has to be closed by the caller.
+void Rewrite::printOperatorFunction(FunctionDecl *fun, std::string name,
+    PrintingPolicy Policy, llvm::raw_ostream *OS) {
+  // write kernel name and qualifiers
+  switch (compilerOptions.getTargetLang()) {
+    default: break;
+    case Language::CUDA:
+      *OS << "extern \"C\" {\n";
+      *OS << "__device__ ";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      *OS << "static ";
+      break;
+  }
+  *OS << "inline " << fun->getReturnType().getAsString() << " " << name
+      << "(";
+  // write kernel parameters
+  size_t comma = 0;
+  for (auto param : fun->params()) {
+    std::string Name(param->getNameAsString());
+    QualType T = param->getType();
+    // normal arguments
+    if (comma++) *OS << ", ";
+    if (ParmVarDecl *Parm = dyn_cast<ParmVarDecl>(fun))
+      T = Parm->getOriginalType();
+    T.getAsStringInternal(Name, Policy);
+    *OS << Name;
+  }
+  *OS << ") ";
+
+  // print kernel body
+  fun->getBody()->printPretty(*OS, 0, Policy, 0);
+}
+
+
 void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
     PrintingPolicy Policy, llvm::raw_ostream *OS) {
   FunctionDecl *fun = KC->getReduceFunction();
 
   // preprocessor defines
-  if (!compilerOptions.exploreConfig()) {
+  if (!compilerOptions.exploreConfig() && !compilerOptions.emitC99()) {
     *OS << "#define BS " << K->getNumThreadsReduce() << "\n"
         << "#define PPT " << K->getPixelsPerThreadReduce() << "\n";
   }
-  if (K->getIterationSpace()->isCrop()) {
+  // the C/C++ reduction takes the region from the accessor instead
+  if (K->getIterationSpace()->isCrop() && !compilerOptions.emitC99()) {
     *OS << "#define USE_OFFSETS\n";
   }
   switch (compilerOptions.getTargetLang()) {
-    case Language::C99: break;
+    case Language::C99:
+      *OS << "#include \"hipacc_cpu_red.hpp\"\n\n";
+      break;
     case Language::OpenCLACC:
     case Language::OpenCLCPU:
     case Language::OpenCLGPU:
@@ -1980,40 +3207,16 @@ void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
   }
 
 
-  // write kernel name and qualifiers
-  switch (compilerOptions.getTargetLang()) {
-    default: break;
-    case Language::CUDA:
-      *OS << "extern \"C\" {\n";
-      *OS << "__device__ ";
-      break;
-    case Language::Renderscript:
-    case Language::Filterscript:
-      *OS << "static ";
-      break;
-  }
-  *OS << "inline " << fun->getReturnType().getAsString() << " "
-      << K->getReduceName() << "(";
-  // write kernel parameters
-  size_t comma = 0;
-  for (auto param : fun->params()) {
-    std::string Name(param->getNameAsString());
-    QualType T = param->getType();
-    // normal arguments
-    if (comma++) *OS << ", ";
-    if (ParmVarDecl *Parm = dyn_cast<ParmVarDecl>(fun))
-      T = Parm->getOriginalType();
-    T.getAsStringInternal(Name, Policy);
-    *OS << Name;
-  }
-  *OS << ") ";
-
-  // print kernel body
-  fun->getBody()->printPretty(*OS, 0, Policy, 0);
+  printOperatorFunction(fun, K->getReduceName(), Policy, OS);
 
   // instantiate reduction
   switch (compilerOptions.getTargetLang()) {
-    case Language::C99: break;
+    case Language::C99:
+      // the region of the iteration space is taken from the accessor
+      *OS << "REDUCTION_CPU_2D(" << K->getReduceName() << "2D, "
+          << fun->getReturnType().getAsString() << ", "
+          << K->getReduceName() << ")\n";
+      break;
     case Language::OpenCLACC:
     case Language::OpenCLCPU:
     case Language::OpenCLGPU:
@@ -2081,6 +3284,129 @@ void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
 }
 
 
+// Print the scan function of a kernel and instantiate the inclusive 2D scan
+// applied in place to the iteration space after the kernel was executed
+void Rewrite::printScanFunction(HipaccKernelClass *KC, HipaccKernel *K,
+    PrintingPolicy Policy, llvm::raw_ostream *OS) {
+  FunctionDecl *fun = KC->getScanFunction();
+  std::string type(fun->getReturnType().getAsString());
+
+  // preprocessor defines
+  if (!compilerOptions.emitC99()) {
+    *OS << "#define BS " << K->getNumThreadsReduce() << "\n";
+  }
+  switch (compilerOptions.getTargetLang()) {
+    case Language::C99:
+      *OS << "#include \"hipacc_cpu_red.hpp\"\n\n";
+      break;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      *OS << "#include \"hipacc_cl_red.hpp\"\n\n";
+      break;
+    case Language::CUDA:
+      *OS << "#include \"hipacc_cu_red.hpp\"\n\n";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      // not supported, reported when parsing the kernel class
+      return;
+  }
+
+  printOperatorFunction(fun, K->getScanName(), Policy, OS);
+
+  // instantiate scan
+  switch (compilerOptions.getTargetLang()) {
+    case Language::C99:
+      *OS << "SCAN_CPU_2D(" << K->getScanName() << "2D, " << type << ", "
+          << K->getScanName() << ")\n";
+      break;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      *OS << "SCAN_CL_ROW(" << K->getScanName() << "Row, " << type << ", "
+          << K->getScanName() << ")\n";
+      *OS << "SCAN_CL_COLUMN(" << K->getScanName() << "Column, " << type
+          << ", " << K->getScanName() << ")\n";
+      break;
+    case Language::CUDA:
+      *OS << "SCAN_CUDA_ROW(" << K->getScanName() << "Row, " << type << ", "
+          << K->getScanName() << ")\n";
+      *OS << "SCAN_CUDA_COLUMN(" << K->getScanName() << "Column, " << type
+          << ", " << K->getScanName() << ")\n";
+      *OS << "}\n";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      break;
+  }
+  *OS << "#include \"hipacc_undef.hpp\"\n";
+
+  *OS << "\n";
+}
+
+
+// Print the bin function of a kernel and instantiate the histogram computed
+// over the iteration space using privatized bins
+void Rewrite::printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
+    PrintingPolicy Policy, llvm::raw_ostream *OS) {
+  FunctionDecl *fun = KC->getBinningFunction();
+  std::string type(K->getIterationSpace()->getImage()->getTypeStr());
+
+  // preprocessor defines
+  if (!compilerOptions.emitC99()) {
+    *OS << "#define BS " << K->getNumThreadsReduce() << "\n"
+        << "#define PPT " << K->getPixelsPerThreadReduce() << "\n";
+  }
+  switch (compilerOptions.getTargetLang()) {
+    case Language::C99:
+      *OS << "#include \"hipacc_cpu_red.hpp\"\n\n";
+      break;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      *OS << "#include \"hipacc_cl_red.hpp\"\n\n";
+      break;
+    case Language::CUDA:
+      *OS << "#include \"hipacc_cu_red.hpp\"\n\n";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      // not supported, reported when parsing the kernel class
+      return;
+  }
+
+  printOperatorFunction(fun, K->getBinningName(), Policy, OS);
+
+  // instantiate histogram
+  switch (compilerOptions.getTargetLang()) {
+    case Language::C99:
+      *OS << "BINNING_CPU_2D(" << K->getBinningName() << "2D, " << type
+          << ", " << K->getBinningName() << ")\n";
+      break;
+    case Language::OpenCLACC:
+    case Language::OpenCLCPU:
+    case Language::OpenCLGPU:
+      *OS << "BINNING_CL_2D(" << K->getBinningName() << "2D, " << type
+          << ", " << K->getBinningName() << ")\n";
+      *OS << "BINNING_CL_1D(" << K->getBinningName() << "1D)\n";
+      break;
+    case Language::CUDA:
+      *OS << "BINNING_CUDA_2D(" << K->getBinningName() << "2D, " << type
+          << ", " << K->getBinningName() << ")\n";
+      *OS << "BINNING_CUDA_1D(" << K->getBinningName() << "1D)\n";
+      *OS << "}\n";
+      break;
+    case Language::Renderscript:
+    case Language::Filterscript:
+      break;
+  }
+  *OS << "#include \"hipacc_undef.hpp\"\n";
+
+  *OS << "\n";
+}
+
+
 void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     HipaccKernel *K, std::string file, bool emitHints) {
   PrintingPolicy Policy = Context.getPrintingPolicy();
@@ -2234,6 +3560,44 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     }
   }
 
+  // print constant literals of a Mask to a 2D array
+  auto printConstantMask = [&] (HipaccMask *Mask) {
+    switch (compilerOptions.getTargetLang()) {
+      case Language::OpenCLACC:
+      case Language::OpenCLCPU:
+      case Language::OpenCLGPU:
+        *OS << "__constant ";
+        break;
+      case Language::CUDA:
+        *OS << "__device__ __constant__ ";
+        break;
+      case Language::C99:
+      case Language::Renderscript:
+      case Language::Filterscript:
+        *OS << "static const ";
+        break;
+    }
+    *OS << Mask->getTypeStr() << " " << Mask->getName() << K->getName() << "["
+        << Mask->getSizeYStr() << "][" << Mask->getSizeXStr() << "] = {\n";
+
+    for (size_t y=0; y<Mask->getSizeY(); ++y) {
+      *OS << "        {";
+      for (size_t x=0; x<Mask->getSizeX(); ++x) {
+        Mask->getInitExpr(x, y)->printPretty(*OS, 0, Policy, 0);
+        if (x<Mask->getSizeX()-1) {
+          *OS << ", ";
+        }
+      }
+      if (y<Mask->getSizeY()-1) {
+        *OS << "},\n";
+      } else {
+        *OS << "}\n";
+      }
+    }
+    *OS << "    };\n\n";
+    Mask->setIsPrinted(true);
+  };
+
   // declarations of textures, surfaces, variables, etc.
   num_arg = 0;
   for (auto arg : K->getDeviceArgFields()) {
@@ -2304,41 +3668,7 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     HipaccMask *Mask = K->getMaskFromMapping(arg);
     if (Mask) {
       if (Mask->isConstant()) {
-        switch (compilerOptions.getTargetLang()) {
-          case Language::OpenCLACC:
-          case Language::OpenCLCPU:
-          case Language::OpenCLGPU:
-            *OS << "__constant ";
-            break;
-          case Language::CUDA:
-            *OS << "__device__ __constant__ ";
-            break;
-          case Language::C99:
-          case Language::Renderscript:
-          case Language::Filterscript:
-            *OS << "static const ";
-            break;
-        }
-        *OS << Mask->getTypeStr() << " " << Mask->getName() << K->getName() << "["
-            << Mask->getSizeYStr() << "][" << Mask->getSizeXStr() << "] = {\n";
-
-        // print Mask constant literals to 2D array
-        for (size_t y=0; y<Mask->getSizeY(); ++y) {
-          *OS << "        {";
-          for (size_t x=0; x<Mask->getSizeX(); ++x) {
-            Mask->getInitExpr(x, y)->printPretty(*OS, 0, Policy, 0);
-            if (x<Mask->getSizeX()-1) {
-              *OS << ", ";
-            }
-          }
-          if (y<Mask->getSizeY()-1) {
-            *OS << "},\n";
-          } else {
-            *OS << "}\n";
-          }
-        }
-        *OS << "    };\n\n";
-        Mask->setIsPrinted(true);
+        printConstantMask(Mask);
       } else {
         // emit declaration in CUDA and Renderscript
         // for other back ends, the mask will be added as kernel parameter
@@ -2372,6 +3702,10 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     }
   }
 
+  // constant tables of precomputed expressions
+  for (auto table : K->getTables())
+    printConstantMask(table);
+
   // extern scope for CUDA
   *OS << "\n";
   if (compilerOptions.emitCUDA()) {
@@ -2525,10 +3859,25 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
         case Language::C99:
           if (comma++) *OS << ", ";
           if (memAcc==READ_ONLY) *OS << "const ";
+          if (compilerOptions.streamExecution()) {
+            // streaming execution: rows are addressed through row tables,
+            // see hipaccLaunchKernelStreamed()
+            *OS << Acc->getImage()->getTypeStr()
+                << " *const *" << Name;
+            break;
+          }
+          if (memAcc==WRITE_ONLY && K->getPixelsPerIterationCPU() > 1) {
+            // stores to the output image must not alias with the loads of
+            // rows shared among the pixels computed per iteration
+            *OS << Acc->getImage()->getTypeStr()
+                << " (*__restrict " << Name << ")"
+                << "[" << Acc->getImage()->getStrideStr() << "]";
+            break;
+          }
           *OS << Acc->getImage()->getTypeStr()
               << " " << Name
               << "[" << Acc->getImage()->getSizeYStr() << "]"
-              << "[" << Acc->getImage()->getSizeXStr() << "]";
+              << "[" << Acc->getImage()->getStrideStr() << "]";
           // alternative for Pencil:
           // *OS << "[static const restrict 2048][4096]";
           break;
@@ -2589,7 +3938,34 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
   *OS << ") ";
 
   // print kernel body
-  D->getBody()->printPretty(*OS, 0, Policy, 0);
+  if (compilerOptions.emitC99() && K->vectorize()) {
+    // replace labels marking loops for vectorization by the loop pragma
+    // macro, passing the vector width of the target device; iterations are
+    // independent unless the kernel reads the image it writes
+    bool independent = true;
+    for (auto img : KC->getImgFields()) {
+      HipaccAccessor *Acc = K->getImgFromMapping(img);
+      if (Acc && Acc != K->getIterationSpace() &&
+          Acc->getImage() == K->getIterationSpace()->getImage())
+        independent = false;
+    }
+
+    std::string body;
+    llvm::raw_string_ostream BS(body);
+    D->getBody()->printPretty(BS, 0, Policy, 0);
+    BS.flush();
+
+    std::string label("HIPACC_SIMD_LOOP:");
+    std::string pragma(std::string(independent ? "HIPACC_SIMD_LOOP_INDEPENDENT"
+          : "HIPACC_SIMD_LOOP") + "(" + std::to_string(K->getVectorWidth()) + ")");
+    for (size_t pos = body.find(label); pos != std::string::npos;
+         pos = body.find(label, pos + pragma.size())) {
+      body.replace(pos, label.size(), pragma);
+    }
+    *OS << body;
+  } else {
+    D->getBody()->printPretty(*OS, 0, Policy, 0);
+  }
   if (compilerOptions.emitCUDA()) {
     *OS << "}\n";
   }
@@ -2598,6 +3974,12 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
   if (KC->getReduceFunction()) {
     printReductionFunction(KC, K, Policy, OS);
   }
+  if (KC->getScanFunction()) {
+    printScanFunction(KC, K, Policy, OS);
+  }
+  if (KC->getBinningFunction()) {
+    printBinningFunction(KC, K, Policy, OS);
+  }
 
   *OS << "#endif //" + ifdef + "\n";
   *OS << "\n";
@@ -87,15 +87,31 @@ enum hipaccMemoryType {
 
 
 class HipaccImage {
+    private:
+        // host copy of the image shared among all copies of the image; it is
+        // either allocated on first use or aliases memory owned elsewhere
+        struct HostBuffer {
+            char *data;
+            bool owned;
+        };
+
     public:
         size_t width, height;
         size_t stride, alignment;
         size_t pixel_size;
         void *mem;
         hipaccMemoryType mem_type;
-        char *host;
         uint32_t *refcount;
 
+    private:
+        HostBuffer *host_buffer;
+
+        void release_host() {
+            if (host_buffer->owned) delete[] host_buffer->data;
+            host_buffer->data = NULL;
+            host_buffer->owned = false;
+        }
+
     public:
         HipaccImage(size_t width, size_t height, size_t stride,
                     size_t alignment, size_t pixel_size, void *mem,
@@ -106,10 +122,11 @@ class HipaccImage {
             pixel_size(pixel_size),
             mem(mem),
             mem_type(mem_type),
-            host(new char[width*height*pixel_size]),
-            refcount(new uint32_t(1))
+            refcount(new uint32_t(1)),
+            host_buffer(new HostBuffer())
         {
-            std::fill(host, host + width*height*pixel_size, 0);
+            host_buffer->data = NULL;
+            host_buffer->owned = false;
         }
 
         HipaccImage(const HipaccImage &image) :
@@ -120,22 +137,42 @@ class HipaccImage {
             pixel_size(image.pixel_size),
             mem(image.mem),
             mem_type(image.mem_type),
-            host(image.host),
-            refcount(image.refcount)
+            refcount(image.refcount),
+            host_buffer(image.host_buffer)
         {
             ++(*refcount);
         }
 
         ~HipaccImage() {
             --(*refcount);
-            if (host != NULL &&
-                *refcount == 0) {
+            if (*refcount == 0) {
+              release_host();
+              delete host_buffer;
               delete refcount;
-              delete[] host;
-              host = NULL;
             }
         }
 
+        // host copy of the image (width*height pixels without padding),
+        // allocated on first use
+        char *host() {
+            if (host_buffer->data == NULL) {
+                host_buffer->data = new char[width*height*pixel_size]();
+                host_buffer->owned = true;
+            }
+            return host_buffer->data;
+        }
+
+        // let the host copy alias memory owned by the application or the
+        // runtime, e.g. unpadded CPU memory; NULL detaches the alias
+        void set_host(void *data) {
+            release_host();
+            host_buffer->data = (char *)data;
+        }
+
+        bool host_is(const void *data) const {
+            return data != NULL && host_buffer->data == data;
+        }
+
         bool operator==(HipaccImage other) const {
             return mem==other.mem;
         }
@@ -37,13 +37,18 @@
 #include <math.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -68,7 +73,14 @@ class HipaccContext : public HipaccContextBase {
         std::vector<cl_platform_name> platform_names;
         std::vector<cl_device_id> devices, devices_all;
         std::vector<cl_context> contexts;
-        std::vector<cl_command_queue> queues;
+        std::vector<cl_command_queue> queues, transfer_queues;
+        std::map<std::string, cl_program> programs;
+        // asynchronous mode: pending uploads from the host copy of images and
+        // the last pending command using each image
+        std::map<void *, cl_event> transfer_events, image_events;
+        // images passed as arguments to kernels
+        std::map<cl_kernel, std::map<unsigned int, void *> > kernel_images;
+        std::vector<cl_event> kernel_events;
 
     public:
         static HipaccContext &getInstance() {
@@ -84,12 +96,86 @@ class HipaccContext : public HipaccContextBase {
         void add_device_all(cl_device_id id) { devices_all.push_back(id); }
         void add_context(cl_context id) { contexts.push_back(id); }
         void add_command_queue(cl_command_queue id) { queues.push_back(id); }
+        void add_transfer_queue(cl_command_queue id) { transfer_queues.push_back(id); }
         std::vector<cl_platform_id> get_platforms() { return platforms; }
         std::vector<cl_platform_name> get_platform_names() { return platform_names; }
         std::vector<cl_device_id> get_devices() { return devices; }
         std::vector<cl_device_id> get_devices_all() { return devices_all; }
         std::vector<cl_context> get_contexts() { return contexts; }
         std::vector<cl_command_queue> get_command_queues() { return queues; }
+        std::vector<cl_command_queue> get_transfer_queues() { return transfer_queues; }
+        void add_program(std::string key, cl_program program) { programs[key] = program; }
+        cl_program get_program(std::string key) {
+            auto it = programs.find(key);
+            return it == programs.end() ? NULL : it->second;
+        }
+        void release_programs() {
+            for (auto program : programs) clReleaseProgram(program.second);
+            programs.clear();
+        }
+        void add_transfer_event(void *mem, cl_event event) { transfer_events[mem] = event; }
+        cl_event take_transfer_event(void *mem) {
+            auto it = transfer_events.find(mem);
+            if (it == transfer_events.end()) return NULL;
+            cl_event event = it->second;
+            transfer_events.erase(it);
+            return event;
+        }
+        std::vector<void *> get_transfer_mems() {
+            std::vector<void *> mems;
+            for (auto it : transfer_events) mems.push_back(it.first);
+            return mems;
+        }
+        bool is_image(void *mem) {
+            for (auto &img : imgs) {
+                if (img.mem == mem) return true;
+            }
+            return false;
+        }
+        void set_image_event(void *mem, cl_event event) {
+            clRetainEvent(event);
+            auto it = image_events.find(mem);
+            if (it != image_events.end()) clReleaseEvent(it->second);
+            image_events[mem] = event;
+        }
+        cl_event take_image_event(void *mem) {
+            auto it = image_events.find(mem);
+            if (it == image_events.end()) return NULL;
+            cl_event event = it->second;
+            image_events.erase(it);
+            return event;
+        }
+        std::vector<void *> get_image_event_mems() {
+            std::vector<void *> mems;
+            for (auto it : image_events) mems.push_back(it.first);
+            return mems;
+        }
+        // events a command using the given images has to wait for
+        std::vector<cl_event> get_image_events(const std::vector<void *> &mems) {
+            std::vector<cl_event> events;
+            for (auto mem : mems) {
+                auto it = image_events.find(mem);
+                if (it != image_events.end() &&
+                    std::find(events.begin(), events.end(), it->second) == events.end())
+                    events.push_back(it->second);
+            }
+            return events;
+        }
+        void set_kernel_image(cl_kernel kernel, unsigned int num, void *mem) {
+            if (mem) kernel_images[kernel][num] = mem;
+            else kernel_images[kernel].erase(num);
+        }
+        std::vector<void *> get_kernel_images(cl_kernel kernel) {
+            std::vector<void *> mems;
+            for (auto it : kernel_images[kernel]) mems.push_back(it.second);
+            return mems;
+        }
+        void add_kernel_event(cl_event event) { kernel_events.push_back(event); }
+        std::vector<cl_event> take_kernel_events() {
+            std::vector<cl_event> events;
+            events.swap(kernel_events);
+            return events;
+        }
 };
 
 
@@ -376,10 +462,29 @@ void hipaccCreateContextsAndCommandQueues(bool all_devies=false) {
         #endif
 
         Ctx.add_command_queue(command_queue);
+
+        // separate in-order queue for memory transfers in asynchronous mode,
+        // overlapping with kernels executed by the first queue
+        #ifdef CL_VERSION_2_0
+        command_queue = clCreateCommandQueueWithProperties(context, devices[i], cprops, &err);
+        checkErr(err, "clCreateCommandQueueWithProperties()");
+        #else
+        command_queue = clCreateCommandQueue(context, devices[i], CL_QUEUE_PROFILING_ENABLE, &err);
+        checkErr(err, "clCreateCommandQueue()");
+        #endif
+
+        Ctx.add_transfer_queue(command_queue);
     }
 }
 
 
+// Release the programs cached by hipaccBuildProgramAndKernel(); call before the
+// OpenCL library is unloaded, otherwise they are reclaimed at process teardown
+void hipaccReleaseContext() {
+    HipaccContext::getInstance().release_programs();
+}
+
+
 // Get binary from OpenCL program and dump it to stderr
 void hipaccDumpBinary(cl_program program, cl_device_id device) {
     cl_uint num_devices;
@@ -420,28 +525,190 @@ void hipaccDumpBinary(cl_program program, cl_device_id device) {
 }
 
 
-// Load OpenCL source file, build program, and create kernel
-cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_name, bool print_progress=true, bool dump_binary=false, bool print_log=false, std::string build_options=std::string(), std::string build_includes=std::string()) {
-    cl_int err = CL_SUCCESS;
-    cl_program program;
-    cl_kernel kernel;
+// Directory of the persistent program binary cache: HIPACC_CL_CACHE_DIR if
+// set, $HOME/.cache/hipacc otherwise; an empty string disables the cache
+std::string hipaccGetProgramCacheDir() {
+    const char *env = getenv("HIPACC_CL_CACHE_DIR");
+    if (env) return std::string(env);
+
+    const char *home = getenv("HOME");
+    if (!home) return std::string();
+
+    return std::string(home) + "/.cache/hipacc";
+}
+
+
+// Append the contents of the files included by the source to the key of the
+// binary cache, so that binaries are rebuilt when the runtime headers change.
+// Included files are searched in the given directories.
+void hipaccAppendIncludes(std::string &key, const std::string &source, const
+        std::vector<std::string> &dirs, std::set<std::string> &seen) {
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line.compare(pos, 8, "#include") != 0) continue;
+        size_t begin = line.find_first_of("\"<", pos + 8);
+        if (begin == std::string::npos) continue;
+        size_t end = line.find_first_of("\">", begin + 1);
+        if (end == std::string::npos) continue;
+
+        std::string name = line.substr(begin + 1, end - begin - 1);
+        if (!seen.insert(name).second) continue;
+
+        for (auto dir : dirs) {
+            std::ifstream file((dir + "/" + name).c_str());
+            if (!file.is_open()) continue;
+
+            std::string contents(std::istreambuf_iterator<char>(file),
+                    (std::istreambuf_iterator<char>()));
+            key += '\0' + name + '\0' + contents;
+            hipaccAppendIncludes(key, contents, dirs, seen);
+            break;
+        }
+    }
+}
+
+
+// Get file name of the cached binary for the given program source and build
+// options on the selected device. The key covers the source, the files it
+// includes from the directory of the source and the -I directories of the
+// build options, the build options, and the platform and device.
+std::string hipaccGetProgramCacheFile(std::string &file_name, std::string &source, std::string &build_options) {
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::string cache_dir = hipaccGetProgramCacheDir();
+    if (cache_dir.empty()) return std::string();
 
-    std::ifstream srcFile(file_name.c_str());
-    if (!srcFile.is_open()) {
-        std::cerr << "ERROR: Can't open OpenCL source file '" << file_name << "'!" << std::endl;
-        exit(EXIT_FAILURE);
+    // create cache directory including parent directories
+    for (size_t pos = cache_dir.find('/', 1); ; pos = cache_dir.find('/', pos + 1)) {
+        mkdir(cache_dir.substr(0, pos).c_str(), 0755);
+        if (pos == std::string::npos) break;
     }
 
-    std::string clString(std::istreambuf_iterator<char>(srcFile),
-            (std::istreambuf_iterator<char>()));
+    // include directories: directory of the source file and -I options
+    std::vector<std::string> dirs;
+    size_t slash = file_name.rfind('/');
+    dirs.push_back(slash == std::string::npos ? "." : file_name.substr(0, slash));
+    std::istringstream options(build_options);
+    std::string option;
+    while (options >> option) {
+        if (option == "-I") {
+            if (options >> option) dirs.push_back(option);
+        } else if (option.compare(0, 2, "-I") == 0) {
+            dirs.push_back(option.substr(2));
+        }
+    }
 
-    const size_t length = clString.length();
-    const char *c_str = clString.c_str();
+    char buffer[1024];
+    std::string key(source);
+    std::set<std::string> seen;
+    hipaccAppendIncludes(key, source, dirs, seen);
+    key += '\0' + build_options;
+    clGetPlatformInfo(Ctx.get_platforms()[0], CL_PLATFORM_VERSION, sizeof(buffer), &buffer, NULL);
+    key += '\0' + std::string(buffer);
+    clGetDeviceInfo(Ctx.get_devices()[0], CL_DEVICE_NAME, sizeof(buffer), &buffer, NULL);
+    key += '\0' + std::string(buffer);
+    clGetDeviceInfo(Ctx.get_devices()[0], CL_DEVICE_VERSION, sizeof(buffer), &buffer, NULL);
+    key += '\0' + std::string(buffer);
+    clGetDeviceInfo(Ctx.get_devices()[0], CL_DRIVER_VERSION, sizeof(buffer), &buffer, NULL);
+    key += '\0' + std::string(buffer);
+
+    // 64-bit FNV-1a hash
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i=0; i<key.size(); ++i) {
+        hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+    }
+
+    std::stringstream cache_file;
+    cache_file << cache_dir << "/" << std::hex << std::setw(16)
+               << std::setfill('0') << hash << ".bin";
+
+    return cache_file.str();
+}
+
+
+// Create program from cached binary, returns NULL if there is no valid binary
+cl_program hipaccLoadProgramBinary(std::string cache_file, std::string &build_options) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_device_id device = Ctx.get_devices()[0];
+    cl_int err = CL_SUCCESS, binary_status = CL_SUCCESS;
 
-    if (print_progress) std::cerr << "<HIPACC:> Compiling '" << kernel_name << "' .";
-    program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
-    checkErr(err, "clCreateProgramWithSource()");
+    std::ifstream binFile(cache_file.c_str(), std::ios::binary);
+    if (!binFile.is_open()) return NULL;
+
+    std::vector<unsigned char> binary((std::istreambuf_iterator<char>(binFile)),
+            std::istreambuf_iterator<char>());
+    if (binary.empty()) return NULL;
+
+    const size_t length = binary.size();
+    const unsigned char *data = binary.data();
+    cl_program program = clCreateProgramWithBinary(Ctx.get_contexts()[0], 1, &device, &length, &data, &binary_status, &err);
+    if (err != CL_SUCCESS) return NULL;
+
+    if (binary_status == CL_SUCCESS) {
+        err = clBuildProgram(program, 1, &device, build_options.c_str(), NULL, NULL);
+    }
+    if (binary_status != CL_SUCCESS || err != CL_SUCCESS) {
+        // outdated or corrupted binary, rebuild from source
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+
+// Store program binary in the cache; failures are not fatal
+void hipaccStoreProgramBinary(cl_program program, std::string cache_file) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_device_id device = Ctx.get_devices()[0];
+    cl_uint num_devices;
+
+    cl_int err = clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices, NULL);
+    if (err != CL_SUCCESS) return;
+
+    std::vector<cl_device_id> devices(num_devices);
+    std::vector<size_t> binary_sizes(num_devices);
+    err = clGetProgramInfo(program, CL_PROGRAM_DEVICES, devices.size() * sizeof(cl_device_id), devices.data(), NULL);
+    err |= clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, binary_sizes.size() * sizeof(size_t), binary_sizes.data(), NULL);
+    if (err != CL_SUCCESS) return;
+
+    std::vector<std::vector<unsigned char> > storage(num_devices);
+    std::vector<unsigned char *> binaries(num_devices);
+    for (size_t i=0; i<num_devices; ++i) {
+        storage[i].resize(binary_sizes[i]);
+        binaries[i] = storage[i].data();
+    }
+    err = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char *)*binaries.size(), binaries.data(), NULL);
+    if (err != CL_SUCCESS) return;
+
+    for (size_t i=0; i<num_devices; ++i) {
+        if (devices[i] != device || binary_sizes[i] == 0) continue;
+
+        // write to temporary file first, so that concurrent processes never
+        // see a partially written binary
+        std::stringstream tmp_file;
+        tmp_file << cache_file << "." << getpid() << ".tmp";
+        std::ofstream binFile(tmp_file.str().c_str(), std::ios::binary);
+        if (!binFile.is_open()) return;
+        binFile.write((const char *)binaries[i], binary_sizes[i]);
+        binFile.close();
+
+        if (binFile.fail() || rename(tmp_file.str().c_str(), cache_file.c_str()) != 0) {
+            remove(tmp_file.str().c_str());
+        }
+    }
+}
+
+
+// Load OpenCL source file, build program, and create kernel. Programs are
+// shared among all kernels of the same file and build options; binaries are
+// kept in a persistent cache, so that warm starts skip compilation
+cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_name, bool print_progress=true, bool dump_binary=false, bool print_log=false, std::string build_options=std::string(), std::string build_includes=std::string()) {
+    cl_int err = CL_SUCCESS;
+    cl_program program;
+    cl_kernel kernel;
+    HipaccContext &Ctx = HipaccContext::getInstance();
 
     cl_platform_name platform_name = Ctx.get_platform_names()[0];
     if (build_options.empty()) {
@@ -466,40 +733,79 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     if (!build_includes.empty()) {
         build_options += " " + build_includes;
     }
-    err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
-    if (print_progress) std::cerr << ".";
-
-    cl_build_status build_status;
-    clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_STATUS, sizeof(build_status), &build_status, NULL);
-
-    if (build_status == CL_BUILD_ERROR || err != CL_SUCCESS || print_log) {
-        // determine the size of the options and log
-        size_t log_size, options_size;
-        err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_OPTIONS, 0, NULL, &options_size);
-        err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
-
-        // allocate memory for the options and log
-        char *program_build_options = new char[options_size];
-        char *program_build_log = new char[log_size];
-
-        // get the options and log
-        err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_OPTIONS, options_size, program_build_options, NULL);
-        err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_LOG, log_size, program_build_log, NULL);
-        if (print_progress) {
-            if (err != CL_SUCCESS) std::cerr << ". failed!" << std::endl;
-            else std::cerr << ".";
+
+    std::string program_key(file_name + "\n" + build_options);
+    program = Ctx.get_program(program_key);
+    if (program && !print_log) {
+        kernel = clCreateKernel(program, kernel_name.c_str(), &err);
+        checkErr(err, "clCreateKernel()");
+        if (dump_binary) hipaccDumpBinary(program, Ctx.get_devices()[0]);
+
+        return kernel;
+    }
+
+    std::ifstream srcFile(file_name.c_str());
+    if (!srcFile.is_open()) {
+        std::cerr << "ERROR: Can't open OpenCL source file '" << file_name << "'!" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string clString(std::istreambuf_iterator<char>(srcFile),
+            (std::istreambuf_iterator<char>()));
+
+    // the build log is only available when compiling from source
+    std::string cache_file = hipaccGetProgramCacheFile(file_name, clString, build_options);
+    program = NULL;
+    if (!cache_file.empty() && !print_log) {
+        program = hipaccLoadProgramBinary(cache_file, build_options);
+        if (program && print_progress) std::cerr << "<HIPACC:> Loading '" << kernel_name << "' from cache .";
+    }
+
+    if (!program) {
+        const size_t length = clString.length();
+        const char *c_str = clString.c_str();
+
+        if (print_progress) std::cerr << "<HIPACC:> Compiling '" << kernel_name << "' .";
+        program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
+        checkErr(err, "clCreateProgramWithSource()");
+
+        err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+        if (print_progress) std::cerr << ".";
+
+        cl_build_status build_status;
+        clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_STATUS, sizeof(build_status), &build_status, NULL);
+
+        if (build_status == CL_BUILD_ERROR || err != CL_SUCCESS || print_log) {
+            // determine the size of the options and log
+            size_t log_size, options_size;
+            err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_OPTIONS, 0, NULL, &options_size);
+            err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+
+            // allocate memory for the options and log
+            char *program_build_options = new char[options_size];
+            char *program_build_log = new char[log_size];
+
+            // get the options and log
+            err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_OPTIONS, options_size, program_build_options, NULL);
+            err |= clGetProgramBuildInfo(program, Ctx.get_devices()[0], CL_PROGRAM_BUILD_LOG, log_size, program_build_log, NULL);
+            if (print_progress) {
+                if (err != CL_SUCCESS) std::cerr << ". failed!" << std::endl;
+                else std::cerr << ".";
+            }
+            std::cerr << std::endl
+                      << "<HIPACC:> OpenCL build options : " << std::endl
+                      << program_build_options << std::endl
+                      << "<HIPACC:> OpenCL build log : " << std::endl
+                      << program_build_log << std::endl;
+
+            // free memory for options and log
+            delete[] program_build_options;
+            delete[] program_build_log;
         }
-        std::cerr << std::endl
-                  << "<HIPACC:> OpenCL build options : " << std::endl
-                  << program_build_options << std::endl
-                  << "<HIPACC:> OpenCL build log : " << std::endl
-                  << program_build_log << std::endl;
-
-        // free memory for options and log
-        delete[] program_build_options;
-        delete[] program_build_log;
+        checkErr(err, "clBuildProgram(), clGetProgramBuildInfo()");
+
+        if (!cache_file.empty()) hipaccStoreProgramBinary(program, cache_file);
     }
-    checkErr(err, "clBuildProgram(), clGetProgramBuildInfo()");
 
     if (dump_binary) hipaccDumpBinary(program, Ctx.get_devices()[0]);
 
@@ -507,9 +813,14 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     checkErr(err, "clCreateKernel()");
     if (print_progress) std::cerr << ". done" << std::endl;
 
-    // release program
-    err = clReleaseProgram(program);
-    checkErr(err, "clReleaseProgram()");
+    // keep program for other kernels of the same file, replacing the program
+    // that was rebuilt to print the build log
+    cl_program old_program = Ctx.get_program(program_key);
+    if (old_program) {
+        err = clReleaseProgram(old_program);
+        checkErr(err, "clReleaseProgram()");
+    }
+    Ctx.add_program(program_key, program);
 
     return kernel;
 }
@@ -520,7 +831,12 @@ HipaccImage createImage(T *host_mem, void *mem, size_t width, size_t height, siz
     HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), mem, mem_type);
     HipaccContext &Ctx = HipaccContext::getInstance();
     Ctx.add_image(img);
-    hipaccWriteMemory(img, host_mem ? host_mem : (T*)img.host);
+    if (host_mem) {
+        hipaccWriteMemory(img, host_mem);
+    } else {
+        std::vector<T> zeros(width*height);
+        hipaccWriteMemory(img, zeros.data());
+    }
     return img;
 }
 
@@ -640,17 +956,85 @@ cl_sampler hipaccCreateSampler(cl_bool normalized_coords, cl_addressing_mode add
 }
 
 
+bool hipacc_async = false;
+
+
+// Wait for the pending transfer from the host memory of an image
+void hipaccWaitForTransfer(HipaccImage &img) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_event event = Ctx.take_transfer_event(img.mem);
+    if (event == NULL) return;
+
+    cl_int err = clWaitForEvents(1, &event);
+    err |= clReleaseEvent(event);
+    checkErr(err, "clWaitForEvents()");
+}
+
+
+// Wait for all commands in the command queues and collect timings of kernels
+// launched asynchronously
+void hipaccFinish(int num_device=0) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_int err = clFinish(Ctx.get_command_queues()[num_device]);
+    if (Ctx.get_transfer_queues().size())
+        err |= clFinish(Ctx.get_transfer_queues()[num_device]);
+    checkErr(err, "clFinish()");
+
+    for (auto mem : Ctx.get_transfer_mems()) {
+        cl_event event = Ctx.take_transfer_event(mem);
+        err |= clReleaseEvent(event);
+    }
+    for (auto mem : Ctx.get_image_event_mems()) {
+        cl_event event = Ctx.take_image_event(mem);
+        err |= clReleaseEvent(event);
+    }
+    for (auto event : Ctx.take_kernel_events()) {
+        cl_ulong end, start;
+        err |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, 0);
+        err |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, 0);
+        err |= clReleaseEvent(event);
+        total_time += (end-start)*1.0e-6f;
+        last_gpu_timing = (end-start)*1.0e-6f;
+    }
+    checkErr(err, "clGetEventProfilingInfo(), clReleaseEvent()");
+}
+
+
+// Enable asynchronous execution: memory transfers and kernel launches return
+// without waiting for completion. Uploads and reads are executed by a separate
+// transfer queue and overlap with kernels; each command waits only for the
+// pending commands using the same images. Reading memory back to the host is a
+// synchronization point, kernel timings are updated there.
+void hipaccSetAsyncExecution(bool async) {
+    if (hipacc_async && !async &&
+        HipaccContext::getInstance().get_command_queues().size())
+        hipaccFinish();
+    hipacc_async = async;
+}
+
+
 // Release buffer or image
 void hipaccReleaseMemory(HipaccImage &img) {
-    cl_int err = clReleaseMemObject((cl_mem)img.mem);
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    hipaccWaitForTransfer(img);
+    cl_event event = Ctx.take_image_event(img.mem);
+    cl_int err = CL_SUCCESS;
+    if (event) {
+        err = clWaitForEvents(1, &event);
+        err |= clReleaseEvent(event);
+        checkErr(err, "clWaitForEvents()");
+    }
+
+    err = clReleaseMemObject((cl_mem)img.mem);
     checkErr(err, "clReleaseMemObject()");
 
-    HipaccContext &Ctx = HipaccContext::getInstance();
     Ctx.del_image(img);
 }
 
 
-// Write to memory
+// Write to memory; in asynchronous mode the data is staged in the host copy
+// of the image, which is not touched before the transfer completes, since the
+// caller may reuse host_mem right away
 template<typename T>
 void hipaccWriteMemory(HipaccImage &img, T *host_mem, int num_device=0) {
     if (host_mem == NULL) return;
@@ -659,11 +1043,22 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem, int num_device=0) {
     size_t height = img.height;
     size_t stride = img.stride;
 
-    if ((char *)host_mem != img.host)
-        std::copy(host_mem, host_mem + width*height, (T*)img.host);
+    hipaccWaitForTransfer(img);
+    void *src = host_mem;
+    if (hipacc_async) {
+        if (!img.host_is(host_mem))
+            std::copy(host_mem, host_mem + width*height, (T*)img.host());
+        src = img.host();
+    }
 
     HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_command_queue queue = hipacc_async ?
+        Ctx.get_transfer_queues()[num_device] :
+        Ctx.get_command_queues()[num_device];
+    std::vector<cl_event> wait = Ctx.get_image_events({ img.mem });
     cl_int err = CL_SUCCESS;
+    cl_event event;
+    cl_event *event_ptr = hipacc_async ? &event : NULL;
     if (img.mem_type >= Array2D) {
         const size_t origin[] = { 0, 0, 0 };
         const size_t region[] = { width, height, 1 };
@@ -671,28 +1066,38 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem, int num_device=0) {
         const size_t input_row_pitch = width*sizeof(T);
         const size_t input_slice_pitch = 0;
 
-        err = clEnqueueWriteImage(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, origin, region, input_row_pitch, input_slice_pitch, host_mem, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueWriteImage(queue, (cl_mem)img.mem, CL_FALSE, origin, region, input_row_pitch, input_slice_pitch, src, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
+        if (!hipacc_async) err |= clFinish(queue);
         checkErr(err, "clEnqueueWriteImage()");
     } else {
         if (stride > width) {
-            for (size_t i=0; i<height; ++i) {
-                err |= clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &host_mem[i*width], 0, NULL, NULL);
-            }
+            const size_t origin[] = { 0, 0, 0 };
+            const size_t region[] = { sizeof(T)*width, height, 1 };
+            err = clEnqueueWriteBufferRect(queue, (cl_mem)img.mem, CL_FALSE, origin, origin, region, sizeof(T)*stride, 0, sizeof(T)*width, 0, src, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
         } else {
-            err = clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, 0, sizeof(T)*width*height, host_mem, 0, NULL, NULL);
+            err = clEnqueueWriteBuffer(queue, (cl_mem)img.mem, CL_FALSE, 0, sizeof(T)*width*height, src, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
         }
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        if (!hipacc_async) err |= clFinish(queue);
         checkErr(err, "clEnqueueWriteBuffer()");
     }
+
+    if (hipacc_async) {
+        Ctx.set_image_event(img.mem, event);
+        Ctx.add_transfer_event(img.mem, event);
+    }
 }
 
 
-// Read from memory
+// Read from memory; this is a synchronization point in asynchronous mode, the
+// host copy of the image is allocated on first use
 template<typename T>
 T *hipaccReadMemory(HipaccImage &img, int num_device=0) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_command_queue queue = hipacc_async ?
+        Ctx.get_transfer_queues()[num_device] :
+        Ctx.get_command_queues()[num_device];
+    std::vector<cl_event> wait = Ctx.get_image_events({ img.mem });
 
     if (img.mem_type >= Array2D) {
         const size_t origin[] = { 0, 0, 0 };
@@ -701,8 +1106,7 @@ T *hipaccReadMemory(HipaccImage &img, int num_device=0) {
         const size_t row_pitch = img.width*sizeof(T);
         const size_t slice_pitch = 0;
 
-        err = clEnqueueReadImage(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, origin, region, row_pitch, slice_pitch, (T*)img.host, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueReadImage(queue, (cl_mem)img.mem, CL_FALSE, origin, region, row_pitch, slice_pitch, (T*)img.host(), wait.size(), wait.size() ? wait.data() : NULL, NULL);
         checkErr(err, "clEnqueueReadImage()");
     } else {
         size_t width = img.width;
@@ -710,17 +1114,17 @@ T *hipaccReadMemory(HipaccImage &img, int num_device=0) {
         size_t stride = img.stride;
 
         if (stride > width) {
-            for (size_t i=0; i<height; ++i) {
-                err |= clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &((T*)img.host)[i*width], 0, NULL, NULL);
-            }
+            const size_t origin[] = { 0, 0, 0 };
+            const size_t region[] = { sizeof(T)*width, height, 1 };
+            err = clEnqueueReadBufferRect(queue, (cl_mem)img.mem, CL_FALSE, origin, origin, region, sizeof(T)*stride, 0, sizeof(T)*width, 0, img.host(), wait.size(), wait.size() ? wait.data() : NULL, NULL);
         } else {
-            err = clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img.mem, CL_FALSE, 0, sizeof(T)*width*height, (T*)img.host, 0, NULL, NULL);
+            err = clEnqueueReadBuffer(queue, (cl_mem)img.mem, CL_FALSE, 0, sizeof(T)*width*height, (T*)img.host(), wait.size(), wait.size() ? wait.data() : NULL, NULL);
         }
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueReadBuffer()");
     }
+    hipaccFinish(num_device);
 
-    return (T*)img.host;
+    return (T*)img.host();
 }
 
 
@@ -744,6 +1148,9 @@ void hipaccWriteDomainFromMask(HipaccImage &dom, T* host_mem) {
 void hipaccCopyMemory(HipaccImage &src, HipaccImage &dst, int num_device=0) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait = Ctx.get_image_events({ src.mem, dst.mem });
+    cl_event event;
+    cl_event *event_ptr = hipacc_async ? &event : NULL;
 
     assert(src.width == dst.width && src.height == dst.height && src.pixel_size == dst.pixel_size && "Invalid CopyBuffer or CopyImage!");
 
@@ -751,14 +1158,21 @@ void hipaccCopyMemory(HipaccImage &src, HipaccImage &dst, int num_device=0) {
         const size_t origin[] = { 0, 0, 0 };
         const size_t region[] = { src.width, src.height, 1 };
 
-        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src.mem, (cl_mem)dst.mem, origin, origin, region, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src.mem, (cl_mem)dst.mem, origin, origin, region, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
+        if (!hipacc_async) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyImage()");
     } else {
-        err = clEnqueueCopyBuffer(Ctx.get_command_queues()[num_device], (cl_mem)src.mem, (cl_mem)dst.mem, 0, 0, src.width*src.height*src.pixel_size, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueCopyBuffer(Ctx.get_command_queues()[num_device], (cl_mem)src.mem, (cl_mem)dst.mem, 0, 0, src.width*src.height*src.pixel_size, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
+        if (!hipacc_async) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyBuffer()");
     }
+
+    if (hipacc_async) {
+        Ctx.set_image_event(src.mem, event);
+        Ctx.set_image_event(dst.mem, event);
+        err = clReleaseEvent(event);
+        checkErr(err, "clReleaseEvent()");
+    }
 }
 
 
@@ -766,6 +1180,9 @@ void hipaccCopyMemory(HipaccImage &src, HipaccImage &dst, int num_device=0) {
 void hipaccCopyMemoryRegion(HipaccAccessor &src, HipaccAccessor &dst, int num_device=0) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait = Ctx.get_image_events({ src.img.mem, dst.img.mem });
+    cl_event event;
+    cl_event *event_ptr = hipacc_async ? &event : NULL;
 
     if (src.img.mem_type >= Array2D) {
         const size_t dst_origin[] = { (size_t)dst.offset_x, (size_t)dst.offset_y, 0 };
@@ -774,8 +1191,8 @@ void hipaccCopyMemoryRegion(HipaccAccessor &src, HipaccAccessor &dst, int num_de
 
         err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device],
                 (cl_mem)src.img.mem, (cl_mem)dst.img.mem, src_origin, dst_origin,
-                region, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+                region, wait.size(), wait.size() ? wait.data() : NULL, event_ptr);
+        if (!hipacc_async) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyImage()");
     } else {
         const size_t dst_origin[] = { dst.offset_x*dst.img.pixel_size, (size_t)dst.offset_y, 0 };
@@ -785,10 +1202,18 @@ void hipaccCopyMemoryRegion(HipaccAccessor &src, HipaccAccessor &dst, int num_de
         err = clEnqueueCopyBufferRect(Ctx.get_command_queues()[num_device],
                 (cl_mem)src.img.mem, (cl_mem)dst.img.mem, src_origin, dst_origin,
                 region, src.img.stride*src.img.pixel_size, 0,
-                dst.img.stride*dst.img.pixel_size, 0, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+                dst.img.stride*dst.img.pixel_size, 0, wait.size(),
+                wait.size() ? wait.data() : NULL, event_ptr);
+        if (!hipacc_async) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyBufferRect()");
     }
+
+    if (hipacc_async) {
+        Ctx.set_image_event(src.img.mem, event);
+        Ctx.set_image_event(dst.img.mem, event);
+        err = clReleaseEvent(event);
+        checkErr(err, "clReleaseEvent()");
+    }
 }
 
 
@@ -799,6 +1224,7 @@ double hipaccCopyBufferBenchmark(HipaccImage &src, HipaccImage &dst, int num_dev
     HipaccContext &Ctx = HipaccContext::getInstance();
 
     assert(src.width == dst.width && src.height == dst.height && src.pixel_size == dst.pixel_size && "Invalid CopyBuffer!");
+    if (hipacc_async) hipaccFinish(num_device);
 
     float timing=FLT_MAX;
     #ifdef EVENT_TIMING
@@ -859,11 +1285,17 @@ template<typename T>
 void hipaccSetKernelArg(cl_kernel kernel, unsigned int num, size_t size, T* param) {
     cl_int err = clSetKernelArg(kernel, num, size, param);
     checkErr(err, "clSetKernelArg()");
+
+    // keep track of images used by the kernel for asynchronous execution
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    void *mem = NULL;
+    if (param && size == sizeof(cl_mem)) std::memcpy(&mem, param, sizeof(cl_mem));
+    Ctx.set_kernel_image(kernel, num, mem && Ctx.is_image(mem) ? mem : NULL);
 }
 
 
-// Enqueue and launch kernel
-void hipaccEnqueueKernel(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, bool print_timing=true) {
+// Enqueue and launch kernel; synchronous launches are forced using sync
+void hipaccEnqueueKernel(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, bool print_timing=true, bool sync=false) {
     cl_int err;
     #ifdef EVENT_TIMING
     cl_event event;
@@ -872,9 +1304,27 @@ void hipaccEnqueueKernel(cl_kernel kernel, size_t *global_work_size, size_t *loc
     long end, start;
     #endif
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<void *> mems = Ctx.get_kernel_images(kernel);
+    std::vector<cl_event> wait = Ctx.get_image_events(mems);
+
+    if (hipacc_async && !sync) {
+        // wait only for pending commands using the same images, timing is
+        // collected at the next synchronization point
+        cl_event kernel_event;
+        err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, wait.size(), wait.size() ? wait.data() : NULL, &kernel_event);
+        checkErr(err, "clEnqueueNDRangeKernel()");
+        for (auto mem : mems) Ctx.set_image_event(mem, kernel_event);
+        #ifdef EVENT_TIMING
+        Ctx.add_kernel_event(kernel_event);
+        #else
+        err = clReleaseEvent(kernel_event);
+        checkErr(err, "clReleaseEvent()");
+        #endif
+        return;
+    }
 
     #ifdef EVENT_TIMING
-    err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, 0, NULL, &event);
+    err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, wait.size(), wait.size() ? wait.data() : NULL, &event);
     err |= clFinish(Ctx.get_command_queues()[0]);
     checkErr(err, "clEnqueueNDRangeKernel()");
 
@@ -891,7 +1341,7 @@ void hipaccEnqueueKernel(cl_kernel kernel, size_t *global_work_size, size_t *loc
     #else
     clFinish(Ctx.get_command_queues()[0]);
     start = getMicroTime();
-    err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, 0, NULL, NULL);
+    err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, wait.size(), wait.size() ? wait.data() : NULL, NULL);
     err |= clFinish(Ctx.get_command_queues()[0]);
     end = getMicroTime();
     checkErr(err, "clEnqueueNDRangeKernel()");
@@ -977,8 +1427,8 @@ T hipaccApplyReduction(cl_kernel kernel2D, cl_kernel kernel1D, HipaccAccessor
 
     // get reduced value
     err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(T), &result, 0, NULL, NULL);
-    err |= clFinish(Ctx.get_command_queues()[0]);
     checkErr(err, "clEnqueueReadBuffer()");
+    hipaccFinish();
 
     err = clReleaseMemObject(output);
     checkErr(err, "clReleaseMemObject()");
@@ -1070,7 +1520,7 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D,
                 hipaccSetKernelArg(exploreReduction2D, 9, sizeof(unsigned int), &idle_left);
             }
 
-            hipaccEnqueueKernel(exploreReduction2D, global_work_size, local_work_size, false);
+            hipaccEnqueueKernel(exploreReduction2D, global_work_size, local_work_size, false, true);
 
 
             // second step: reduce partial blocks on GPU
@@ -1085,7 +1535,7 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D,
                 hipaccSetKernelArg(exploreReduction1D, 2, sizeof(unsigned int), &num_blocks);
                 hipaccSetKernelArg(exploreReduction1D, 3, sizeof(unsigned int), &ppt);
 
-                hipaccEnqueueKernel(exploreReduction1D, global_work_size, local_work_size, false);
+                hipaccEnqueueKernel(exploreReduction1D, global_work_size, local_work_size, false, true);
 
                 num_blocks = global_work_size[0]/local_work_size[0];
             }
@@ -1122,8 +1572,8 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D,
 
     // get reduced value
     err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(T), &result, 0, NULL, NULL);
-    err |= clFinish(Ctx.get_command_queues()[0]);
     checkErr(err, "clEnqueueReadBuffer()");
+    hipaccFinish();
 
     err = clReleaseMemObject(output);
     checkErr(err, "clReleaseMemObject()");
@@ -1140,6 +1590,123 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D,
 }
 
 
+// Apply an inclusive 2D scan in place to the region of an image: rows are
+// scanned first by one work-group per row, columns afterwards by one work-item
+// per column
+void hipaccApplyScan(cl_kernel kernelRow, cl_kernel kernelColumn, HipaccAccessor
+        &acc, unsigned int max_threads) {
+    if (acc.width == 0 || acc.height == 0) return;
+
+    size_t local_work_size[2];
+    local_work_size[0] = max_threads;
+    local_work_size[1] = 1;
+    size_t global_work_size[2];
+    global_work_size[0] = local_work_size[0];
+    global_work_size[1] = acc.height;
+
+    hipaccSetKernelArg(kernelRow, 0, sizeof(cl_mem), &acc.img.mem);
+    hipaccSetKernelArg(kernelRow, 1, sizeof(unsigned int), &acc.width);
+    hipaccSetKernelArg(kernelRow, 2, sizeof(unsigned int), &acc.height);
+    hipaccSetKernelArg(kernelRow, 3, sizeof(unsigned int), &acc.img.stride);
+    hipaccSetKernelArg(kernelRow, 4, sizeof(unsigned int), &acc.offset_x);
+    hipaccSetKernelArg(kernelRow, 5, sizeof(unsigned int), &acc.offset_y);
+
+    hipaccEnqueueKernel(kernelRow, global_work_size, local_work_size);
+
+    global_work_size[0] = (int)ceilf((float)(acc.width)/local_work_size[0])*local_work_size[0];
+    global_work_size[1] = 1;
+
+    hipaccSetKernelArg(kernelColumn, 0, sizeof(cl_mem), &acc.img.mem);
+    hipaccSetKernelArg(kernelColumn, 1, sizeof(unsigned int), &acc.width);
+    hipaccSetKernelArg(kernelColumn, 2, sizeof(unsigned int), &acc.height);
+    hipaccSetKernelArg(kernelColumn, 3, sizeof(unsigned int), &acc.img.stride);
+    hipaccSetKernelArg(kernelColumn, 4, sizeof(unsigned int), &acc.offset_x);
+    hipaccSetKernelArg(kernelColumn, 5, sizeof(unsigned int), &acc.offset_y);
+
+    hipaccEnqueueKernel(kernelColumn, global_work_size, local_work_size);
+}
+void hipaccApplyScan(cl_kernel kernelRow, cl_kernel kernelColumn, HipaccImage
+        &img, unsigned int max_threads) {
+    HipaccAccessor acc(img);
+    hipaccApplyScan(kernelRow, kernelColumn, acc, max_threads);
+}
+
+
+// Compute the histogram of the region of an image: each work-group accumulates
+// pixels_per_thread rows into privatized bins in local memory, the partial
+// histograms are merged afterwards
+std::vector<unsigned int> hipaccApplyBinning(cl_kernel kernel2D, cl_kernel
+        kernel1D, HipaccAccessor &acc, unsigned int max_threads, unsigned int
+        pixels_per_thread, unsigned int num_bins) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_int err = CL_SUCCESS;
+    cl_mem output;  // GPU memory for partial histograms
+    std::vector<unsigned int> hist(num_bins);
+
+    if (num_bins == 0 || acc.width == 0 || acc.height == 0) return hist;
+
+    // bins are privatized in local memory if they fit, otherwise they are
+    // accumulated in the partial histograms using global atomics
+    cl_ulong local_mem_size = 0;
+    err = clGetDeviceInfo(Ctx.get_devices()[0], CL_DEVICE_LOCAL_MEM_SIZE,
+            sizeof(local_mem_size), &local_mem_size, NULL);
+    checkErr(err, "clGetDeviceInfo()");
+    unsigned int use_local = sizeof(unsigned int)*num_bins <= local_mem_size;
+
+    size_t local_work_size[2];
+    local_work_size[0] = max_threads;
+    local_work_size[1] = 1;
+    size_t global_work_size[2];
+    global_work_size[0] = local_work_size[0];
+    global_work_size[1] = (int)ceilf((float)(acc.height)/pixels_per_thread);
+
+    unsigned int num_partials = global_work_size[1];
+    output = clCreateBuffer(Ctx.get_contexts()[0], CL_MEM_READ_WRITE,
+            sizeof(unsigned int)*num_bins*num_partials, NULL, &err);
+    checkErr(err, "clCreateBuffer()");
+
+    hipaccSetKernelArg(kernel2D, 0, sizeof(cl_mem), &acc.img.mem);
+    hipaccSetKernelArg(kernel2D, 1, sizeof(cl_mem), &output);
+    hipaccSetKernelArg(kernel2D, 2, sizeof(unsigned int)*(use_local ? num_bins
+                : 1), (void *)NULL);
+    hipaccSetKernelArg(kernel2D, 3, sizeof(unsigned int), &acc.width);
+    hipaccSetKernelArg(kernel2D, 4, sizeof(unsigned int), &acc.height);
+    hipaccSetKernelArg(kernel2D, 5, sizeof(unsigned int), &acc.img.stride);
+    hipaccSetKernelArg(kernel2D, 6, sizeof(unsigned int), &acc.offset_x);
+    hipaccSetKernelArg(kernel2D, 7, sizeof(unsigned int), &acc.offset_y);
+    hipaccSetKernelArg(kernel2D, 8, sizeof(unsigned int), &num_bins);
+    hipaccSetKernelArg(kernel2D, 9, sizeof(unsigned int), &use_local);
+
+    hipaccEnqueueKernel(kernel2D, global_work_size, local_work_size);
+
+    global_work_size[0] = (int)ceilf((float)(num_bins)/local_work_size[0])*local_work_size[0];
+    global_work_size[1] = 1;
+
+    hipaccSetKernelArg(kernel1D, 0, sizeof(cl_mem), &output);
+    hipaccSetKernelArg(kernel1D, 1, sizeof(unsigned int), &num_bins);
+    hipaccSetKernelArg(kernel1D, 2, sizeof(unsigned int), &num_partials);
+
+    hipaccEnqueueKernel(kernel1D, global_work_size, local_work_size);
+
+    // get histogram
+    err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(unsigned int)*num_bins, hist.data(), 0, NULL, NULL);
+    checkErr(err, "clEnqueueReadBuffer()");
+    hipaccFinish();
+
+    err = clReleaseMemObject(output);
+    checkErr(err, "clReleaseMemObject()");
+
+    return hist;
+}
+std::vector<unsigned int> hipaccApplyBinning(cl_kernel kernel2D, cl_kernel
+        kernel1D, HipaccImage &img, unsigned int max_threads, unsigned int
+        pixels_per_thread, unsigned int num_bins) {
+    HipaccAccessor acc(img);
+    return hipaccApplyBinning(kernel2D, kernel1D, acc, max_threads,
+            pixels_per_thread, num_bins);
+}
+
+
 // Benchmark timing for a kernel call
 void hipaccEnqueueKernelBenchmark(cl_kernel kernel, std::vector<std::pair<size_t, void *> > args, size_t *global_work_size, size_t *local_work_size, bool print_timing=true) {
     float timing=FLT_MAX;
@@ -1155,7 +1722,7 @@ void hipaccEnqueueKernelBenchmark(cl_kernel kernel, std::vector<std::pair<size_t
         }
 
         // launch kernel
-        hipaccEnqueueKernel(kernel, global_work_size, local_work_size, print_timing);
+        hipaccEnqueueKernel(kernel, global_work_size, local_work_size, print_timing, true);
         #ifdef EVENT_TIMING
         if (last_gpu_timing < timing) timing = last_gpu_timing;
         #else
@@ -1236,7 +1803,7 @@ void hipaccKernelExploration(std::string filename, std::string kernel,
                 // start timing
                 total_time = 0.0f;
 
-                hipaccEnqueueKernel(exploreKernel, global_work_size, local_work_size, false);
+                hipaccEnqueueKernel(exploreKernel, global_work_size, local_work_size, false, true);
 
                 // stop timing
                 #ifdef EVENT_TIMING
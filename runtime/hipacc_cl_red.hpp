@@ -142,5 +142,125 @@ __kernel void NAME(__global const DATA_TYPE *input, __global DATA_TYPE *output,
     if (tid == 0) output[get_group_id(0)] = sdata[0]; \
 }
 
+// inclusive 2D scan, step 1:
+// scan each row of the region in place using one work-group per row; the row
+// is processed in chunks of BS pixels, each scanned in local memory and
+// combined with the carry of the previous chunks
+#define SCAN_CL_ROW(NAME, DATA_TYPE, SCAN) \
+__kernel __attribute__((reqd_work_group_size(BS, 1, 1))) void NAME( \
+        __global DATA_TYPE *data, const unsigned int width, \
+        const unsigned int height, const unsigned int stride, \
+        const unsigned int offset_x, const unsigned int offset_y) { \
+    const unsigned int tid = get_local_id(0); \
+    __global DATA_TYPE *row = data + (get_group_id(1) + offset_y)*stride + offset_x; \
+ \
+    __local DATA_TYPE sdata[BS]; \
+ \
+    DATA_TYPE carry; \
+ \
+    for (unsigned int x0=0; x0 < width; x0 += BS) { \
+        const unsigned int x = x0 + tid; \
+        DATA_TYPE val = row[min(x, width-1)]; \
+        sdata[tid] = val; \
+ \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+ \
+        for (unsigned int s=1; s < BS; s<<=1) { \
+            if (tid >= s) val = SCAN(sdata[tid - s], val); \
+            barrier(CLK_LOCAL_MEM_FENCE); \
+            sdata[tid] = val; \
+            barrier(CLK_LOCAL_MEM_FENCE); \
+        } \
+ \
+        if (x0) val = SCAN(carry, val); \
+        if (x < width) row[x] = val; \
+        carry = x0 ? SCAN(carry, sdata[BS-1]) : sdata[BS-1]; \
+ \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+    } \
+}
+
+
+// inclusive 2D scan, step 2:
+// scan each column of the region in place; each work-item walks down one
+// column, so that the accesses of a work-group are coalesced
+#define SCAN_CL_COLUMN(NAME, DATA_TYPE, SCAN) \
+__kernel __attribute__((reqd_work_group_size(BS, 1, 1))) void NAME( \
+        __global DATA_TYPE *data, const unsigned int width, \
+        const unsigned int height, const unsigned int stride, \
+        const unsigned int offset_x, const unsigned int offset_y) { \
+    const unsigned int gid_x = get_global_id(0); \
+    if (gid_x >= width) return; \
+ \
+    __global DATA_TYPE *col = data + offset_y*stride + offset_x + gid_x; \
+ \
+    DATA_TYPE val = col[0]; \
+    for (unsigned int y=1; y < height; ++y) { \
+        col += stride; \
+        *col = val = SCAN(val, *col); \
+    } \
+}
+
+// histogram, step 1:
+// accumulate PPT rows of the region into bins in local memory, which are
+// written to the partial histogram of the work-group in linear memory; bins
+// exceeding the local memory are accumulated in the partial histogram directly
+#define BINNING_CL_2D(NAME, DATA_TYPE, BIN) \
+__kernel __attribute__((reqd_work_group_size(BS, 1, 1))) void NAME( \
+        __global const DATA_TYPE *input, __global uint *output, \
+        __local uint *lhist, const unsigned int width, \
+        const unsigned int height, const unsigned int stride, \
+        const unsigned int offset_x, const unsigned int offset_y, \
+        const unsigned int num_bins, const unsigned int use_local) { \
+    const unsigned int tid = get_local_id(0); \
+    const unsigned int y_start = PPT * get_group_id(1); \
+    const unsigned int y_end = min(y_start + PPT, height); \
+    __global uint *partial = output + get_group_id(1)*num_bins; \
+ \
+    if (use_local) { \
+        for (unsigned int i=tid; i < num_bins; i += BS) lhist[i] = 0; \
+ \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+ \
+        for (unsigned int y=y_start; y < y_end; ++y) { \
+            __global const DATA_TYPE *row = input + (y + offset_y)*stride + offset_x; \
+            for (unsigned int x=tid; x < width; x += BS) { \
+                const unsigned int idx = BIN(row[x], num_bins); \
+                if (idx < num_bins) atomic_inc(&lhist[idx]); \
+            } \
+        } \
+ \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+ \
+        for (unsigned int i=tid; i < num_bins; i += BS) partial[i] = lhist[i]; \
+    } else { \
+        for (unsigned int i=tid; i < num_bins; i += BS) partial[i] = 0; \
+ \
+        barrier(CLK_GLOBAL_MEM_FENCE); \
+ \
+        for (unsigned int y=y_start; y < y_end; ++y) { \
+            __global const DATA_TYPE *row = input + (y + offset_y)*stride + offset_x; \
+            for (unsigned int x=tid; x < width; x += BS) { \
+                const unsigned int idx = BIN(row[x], num_bins); \
+                if (idx < num_bins) atomic_inc(&partial[idx]); \
+            } \
+        } \
+    } \
+}
+
+
+// histogram, step 2:
+// merge the partial histograms into the first one, one work-item per bin
+#define BINNING_CL_1D(NAME) \
+__kernel void NAME(__global uint *partial, const unsigned int num_bins, \
+        const unsigned int num_partials) { \
+    const unsigned int gid = get_global_id(0); \
+    if (gid >= num_bins) return; \
+ \
+    uint sum = 0; \
+    for (unsigned int i=0; i < num_partials; ++i) sum += partial[i*num_bins + gid]; \
+    partial[gid] = sum; \
+}
+
 //#endif  // __HIPACC_CL_RED_HPP__
 
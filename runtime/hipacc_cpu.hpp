@@ -30,19 +30,153 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "hipacc_base.hpp"
 
+// Loop pragmas emitted for the inner loops of vectorized kernels, taking the
+// vector width of the target device profile. Vectorization is left to the host
+// compiler, the pragmas are hints only and no vector code is emitted.
+// HIPACC_SIMD_LOOP_INDEPENDENT marks loops whose iterations are independent,
+// i.e. kernels that do not read the image they write: the pragmas assert this
+// to the compiler. HIPACC_SIMD_LOOP marks all other loops and only overrides
+// the cost model, leaving the dependence check to the compiler; GCC has no such
+// hint. OpenMP SIMD directives are used when enabled (e.g. -fopenmp-simd with
+// -D HIPACC_OPENMP_SIMD, or -fopenmp).
+#define HIPACC_PRAGMA(x) _Pragma(#x)
+#ifndef HIPACC_SIMD_LOOP
+#if defined(__clang__)
+#define HIPACC_SIMD_LOOP(width) HIPACC_PRAGMA(clang loop vectorize(enable) vectorize_width(width) interleave(enable))
+#elif defined(__INTEL_COMPILER)
+#define HIPACC_SIMD_LOOP(width) _Pragma("vector always")
+#else
+#define HIPACC_SIMD_LOOP(width)
+#endif
+#endif
+#ifndef HIPACC_SIMD_LOOP_INDEPENDENT
+#if defined(_OPENMP) || defined(HIPACC_OPENMP_SIMD)
+#define HIPACC_SIMD_LOOP_INDEPENDENT(width) HIPACC_PRAGMA(omp simd simdlen(width))
+#elif defined(__clang__)
+#define HIPACC_SIMD_LOOP_INDEPENDENT(width) HIPACC_PRAGMA(clang loop vectorize(assume_safety) vectorize_width(width) interleave(enable))
+#elif defined(__INTEL_COMPILER)
+#define HIPACC_SIMD_LOOP_INDEPENDENT(width) HIPACC_PRAGMA(simd vectorlength(width))
+#elif defined(__GNUC__)
+#define HIPACC_SIMD_LOOP_INDEPENDENT(width) _Pragma("GCC ivdep")
+#else
+#define HIPACC_SIMD_LOOP_INDEPENDENT(width)
+#endif
+#endif
+
+// alignment of image memory, suitable for the widest SIMD registers
+#define HIPACC_CPU_ALIGNMENT 64
+
+// Callback transferring row y of a streamed image from/to the application
+typedef std::function<void(void *row, size_t y)> hipacc_row_fn;
+
+// State of a streamed image: only a window of rows is held in memory
+struct HipaccStream {
+    hipacc_row_fn read, write;
+    char *buffer;
+    size_t buffer_rows;
+    // rows [first_row, last_row) of the image are held in the buffer
+    size_t first_row, last_row;
+};
+
+// Boundary mode used to fill the halo of images allocated with a physical
+// halo: kernels read the halo instead of applying border handling
+enum hipaccHaloMode {
+    HaloClamp,
+    HaloRepeat,
+    HaloMirror,
+    HaloConstant
+};
+
+// Halo of an image: img.mem points to the first pixel within the allocation
+struct HipaccHalo {
+    char *base;
+    int halo_x, halo_y;
+    hipaccHaloMode mode;
+    std::vector<char> const_val;
+};
+
 class HipaccContext : public HipaccContextBase {
+    private:
+        // streamed images are identified by the reference counter shared
+        // among all copies of an image
+        std::map<uint32_t *, HipaccStream> streams;
+        // images wrapping memory owned by the application
+        std::set<uint32_t *> wrapped;
+        // images allocated with a physical halo
+        std::map<uint32_t *, HipaccHalo> halos;
+        // row tables of the images used by a streamed kernel launch
+        std::map<uint32_t *, std::vector<void *> > row_tables;
+
     public:
         static HipaccContext &getInstance() {
             static HipaccContext instance;
 
             return instance;
         }
+
+        void add_stream(HipaccImage &img, const hipacc_row_fn &read,
+                        const hipacc_row_fn &write) {
+            HipaccStream stream = { read, write, NULL, 0, 0, 0 };
+            streams[img.refcount] = stream;
+        }
+        HipaccStream *get_stream(HipaccImage &img) {
+            std::map<uint32_t *, HipaccStream>::iterator it =
+                streams.find(img.refcount);
+            return it == streams.end() ? NULL : &it->second;
+        }
+        void del_stream(HipaccImage &img) {
+            HipaccStream *stream = get_stream(img);
+            if (stream) {
+                free(stream->buffer);
+                streams.erase(img.refcount);
+            }
+        }
+
+        void add_wrapped(HipaccImage &img) { wrapped.insert(img.refcount); }
+        bool is_wrapped(HipaccImage &img) {
+            return wrapped.count(img.refcount) != 0;
+        }
+        void del_wrapped(HipaccImage &img) { wrapped.erase(img.refcount); }
+
+        void add_halo(HipaccImage &img, const HipaccHalo &halo) {
+            halos[img.refcount] = halo;
+        }
+        HipaccHalo *get_halo(HipaccImage &img) {
+            std::map<uint32_t *, HipaccHalo>::iterator it =
+                halos.find(img.refcount);
+            return it == halos.end() ? NULL : &it->second;
+        }
+        void del_halo(HipaccImage &img) { halos.erase(img.refcount); }
+
+        // returns NULL if the image already has a row table
+        std::vector<void *> *add_rows(HipaccImage &img) {
+            if (row_tables.count(img.refcount)) return NULL;
+            std::vector<void *> &rows = row_tables[img.refcount];
+            rows.assign(img.height, NULL);
+            return &rows;
+        }
+        void **get_rows(HipaccImage &img) {
+            std::map<uint32_t *, std::vector<void *> >::iterator it =
+                row_tables.find(img.refcount);
+            return it == row_tables.end() ? NULL : it->second.data();
+        }
+        void del_rows(HipaccImage &img) { row_tables.erase(img.refcount); }
 };
 
 long start_time = 0L;
@@ -61,17 +195,221 @@ void hipaccStopTiming() {
 }
 
 
+void hipaccPrepareKernelLaunch(hipacc_launch_info &info) {
+    // calculate a) first column/row that requires no border handling (left,
+    // top) and b) first column/row that requires border handling (right,
+    // bottom); in contrast to the GPU back ends, these are pixel coordinates
+    // including the offset of the iteration space
+    info.bh_start_left = info.offset_x + info.size_x;
+    info.bh_start_right = info.offset_x + info.is_width - info.size_x;
+    info.bh_start_top = info.offset_y + info.size_y;
+    info.bh_start_bottom = info.offset_y + info.is_height - info.size_y;
+
+    // pixels may require border handling on both sides for small images
+    if (info.is_width >= 2*info.size_x && info.is_height >= 2*info.size_y) {
+        info.bh_fall_back = 0;
+    } else {
+        info.bh_fall_back = 1;
+    }
+}
+
+
+// window of an Accessor with border handling
+typedef struct hipacc_border_info {
+    const HipaccAccessor &acc;
+    int size_x, size_y;
+} hipacc_border_info;
+
+void hipaccPrepareKernelLaunch(hipacc_launch_info &info,
+        std::initializer_list<hipacc_border_info> accs) {
+    hipaccPrepareKernelLaunch(info);
+
+    // Accessors exceeding the iteration space provide valid pixels beyond its
+    // right and bottom border: border handling is only required where the
+    // window of an Accessor leaves its region of interest
+    int strip_x = 0, strip_y = 0;
+    for (auto &bi : accs) {
+        strip_x = std::max(strip_x, bi.size_x -
+                std::max((int)bi.acc.width - info.is_width, 0));
+        strip_y = std::max(strip_y, bi.size_y -
+                std::max((int)bi.acc.height - info.is_height, 0));
+    }
+    info.bh_start_right = info.offset_x + info.is_width - strip_x;
+    info.bh_start_bottom = info.offset_y + info.is_height - strip_y;
+}
+
+
+// Pool of worker threads executing rows of the iteration space in parallel.
+// The calling thread participates in the computation, so a pool for n threads
+// holds n-1 workers. Each row is computed by exactly one thread, hence the
+// results are identical to serial execution. The pool only grows: runs using
+// fewer threads leave the surplus workers idle.
+class HipaccWorkerPool {
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable start_cond, done_cond;
+        const std::function<void(int, int)> *job;
+        std::atomic<int> next_row;
+        int num_rows, chunk_size;
+        size_t participants, active, generation;
+        bool shutdown;
+
+        HipaccWorkerPool() :
+            job(NULL), next_row(0), num_rows(0), chunk_size(1),
+            participants(0), active(0), generation(0), shutdown(false) {}
+
+        ~HipaccWorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                shutdown = true;
+            }
+            start_cond.notify_all();
+            for (auto &worker : workers) worker.join();
+        }
+
+        void process(const std::function<void(int, int)> &fn, int rows,
+                     int chunk) {
+            int row;
+            while ((row = next_row.fetch_add(chunk)) < rows) {
+                fn(row, std::min(row + chunk, rows));
+            }
+        }
+
+        // seen is the generation of the last job posted before the worker was
+        // spawned: only jobs posted afterwards are processed
+        void run_worker(size_t index, size_t seen) {
+            while (true) {
+                const std::function<void(int, int)> *fn;
+                int rows, chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    start_cond.wait(lock, [&] {
+                            return shutdown ||
+                                   (generation != seen && index < participants);
+                            });
+                    if (shutdown) return;
+                    seen = generation;
+                    fn = job;
+                    rows = num_rows;
+                    chunk = chunk_size;
+                }
+                process(*fn, rows, chunk);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--active == 0) done_cond.notify_one();
+                }
+            }
+        }
+
+        void grow(size_t num_workers) {
+            if (workers.size() >= num_workers) return;
+
+            size_t current;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = generation;
+            }
+            for (size_t i=workers.size(); i<num_workers; ++i) {
+                workers.emplace_back(&HipaccWorkerPool::run_worker, this, i,
+                                     current);
+            }
+        }
+
+    public:
+        static HipaccWorkerPool &getInstance() {
+            static HipaccWorkerPool instance;
+
+            return instance;
+        }
+
+        void run(size_t num_threads, int rows,
+                 const std::function<void(int, int)> &fn) {
+            if (num_threads > (size_t)rows) num_threads = rows;
+            if (num_threads <= 1) {
+                fn(0, rows);
+                return;
+            }
+
+            grow(num_threads - 1);
+            // several chunks per thread for load balancing
+            int chunk = std::max(1, rows / (int)(4*num_threads));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &fn;
+                num_rows = rows;
+                chunk_size = chunk;
+                next_row = 0;
+                participants = active = num_threads - 1;
+                ++generation;
+            }
+            start_cond.notify_all();
+            process(fn, rows, chunk);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cond.wait(lock, [&] { return active == 0; });
+            job = NULL;
+        }
+};
+
+size_t hipacc_num_threads = 0;
+
+// Set number of threads used for kernel execution at runtime, overriding the
+// value selected at compile time and the HIPACC_NUM_THREADS environment
+// variable; 0 restores the default behavior
+void hipaccSetNumThreads(size_t num_threads) {
+    hipacc_num_threads = num_threads;
+}
+
+size_t hipaccGetNumThreads(size_t num_threads) {
+    if (hipacc_num_threads) return hipacc_num_threads;
+
+    const char *env = getenv("HIPACC_NUM_THREADS");
+    if (env && atoi(env) > 0) return atoi(env);
+
+    if (num_threads) return num_threads;
+
+    size_t hw_threads = std::thread::hardware_concurrency();
+    return hw_threads ? hw_threads : 1;
+}
+
+// Execute kernel on rows [0, rows) of the iteration space using num_threads
+// threads; num_threads=0 uses all available cores
+void hipaccLaunchKernel(size_t num_threads, int rows,
+                        const std::function<void(int, int)> &kernel) {
+    HipaccWorkerPool::getInstance().run(hipaccGetNumThreads(num_threads), rows,
+                                        kernel);
+}
+
+
 template<typename T>
 HipaccImage createImage(T *host_mem, void *mem, size_t width, size_t height, size_t stride, size_t alignment, hipaccMemoryType mem_type=Global) {
     HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), mem, mem_type);
     HipaccContext &Ctx = HipaccContext::getInstance();
     Ctx.add_image(img);
-    hipaccWriteMemory(img, host_mem ? host_mem : (T*)img.host);
+    // unpadded memory is host memory already: no separate host copy required
+    if (stride == width) img.set_host(mem);
+    if (host_mem) hipaccWriteMemory(img, host_mem);
+    else std::memset(mem, 0, sizeof(T)*stride*height);
 
     return img;
 }
 
 
+// Allocate memory starting at a SIMD-friendly address; release with free()
+template<typename T>
+T *hipaccAllocAligned(size_t size) {
+    void *mem = NULL;
+    if (posix_memalign(&mem, HIPACC_CPU_ALIGNMENT, size) != 0) {
+        std::cerr << "ERROR: Allocation of " << size << " bytes failed"
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return (T *)mem;
+}
+
+
 // Allocate memory with alignment specified
 template<typename T>
 HipaccImage hipaccCreateMemory(T *host_mem, size_t width, size_t height, size_t alignment) {
@@ -79,39 +417,285 @@ HipaccImage hipaccCreateMemory(T *host_mem, size_t width, size_t height, size_t
     alignment = (int)ceilf((float)alignment/sizeof(T)) * sizeof(T);
     int stride = (int)ceilf((float)(width)/(alignment/sizeof(T))) * (alignment/sizeof(T));
 
-    T *mem = (T *)malloc(sizeof(T)*stride*height);
+    T *mem = hipaccAllocAligned<T>(sizeof(T)*stride*height);
     return createImage(host_mem, (void *)mem, width, height, stride, alignment);
 }
 
 
-// Allocate memory without any alignment considerations
+// Allocate memory without any padding of rows
 template<typename T>
 HipaccImage hipaccCreateMemory(T *host_mem, size_t width, size_t height) {
-    T *mem = (T *)malloc(sizeof(T)*width*height);
+    T *mem = hipaccAllocAligned<T>(sizeof(T)*width*height);
     return createImage(host_mem, (void *)mem, width, height, width, 0);
 }
 
 
+// Fill the halo of an image allocated by hipaccCreateMemoryHalo() according
+// to its boundary mode; images without halo are left untouched
+void hipaccFillHalo(HipaccImage &img) {
+    HipaccHalo *halo = HipaccContext::getInstance().get_halo(img);
+    if (halo == NULL) return;
+
+    const int width = img.width, height = img.height;
+    const int halo_x = halo->halo_x, halo_y = halo->halo_y;
+    const ptrdiff_t stride = img.stride, pixel_size = img.pixel_size;
+    char *mem = (char *)img.mem;
+
+    // index of the pixel within the image providing the value of the halo
+    auto map = [&] (int idx, int size) {
+        switch (halo->mode) {
+            case HaloRepeat:
+                idx %= size;
+                if (idx < 0) idx += size;
+                break;
+            case HaloMirror:
+                if (idx < 0) idx = -idx - 1;
+                if (idx >= size) idx = 2*size - idx - 1;
+                break;
+            default:
+                break;
+        }
+        return std::min(std::max(idx, 0), size - 1);
+    };
+    auto fill = [&] (int x, int y) {
+        const char *src = halo->mode == HaloConstant ? halo->const_val.data() :
+            mem + (map(y, height)*stride + map(x, width))*pixel_size;
+        std::memcpy(mem + (y*stride + x)*pixel_size, src, pixel_size);
+    };
+
+    // left and right columns of all rows, then rows above and below
+    // including the corners
+    for (int y=0; y<height; ++y) {
+        for (int x=-halo_x; x<0; ++x) fill(x, y);
+        for (int x=width; x<width+halo_x; ++x) fill(x, y);
+    }
+    for (int y=-halo_y; y<0; ++y) {
+        for (int x=-halo_x; x<width+halo_x; ++x) fill(x, y);
+    }
+    for (int y=height; y<height+halo_y; ++y) {
+        for (int x=-halo_x; x<width+halo_x; ++x) fill(x, y);
+    }
+}
+
+
+// Allocate memory with a physical halo of halo_x columns and halo_y rows on
+// each side. The halo is filled according to the boundary mode whenever the
+// image is written, so that kernels can read it without border handling.
+template<typename T>
+HipaccImage hipaccCreateMemoryHalo(T *host_mem, size_t width, size_t height,
+                                   int halo_x, int halo_y, hipaccHaloMode mode,
+                                   T const_val=T()) {
+    size_t stride = width + 2*halo_x;
+    size_t size = sizeof(T)*stride*(height + 2*halo_y);
+    T *base = hipaccAllocAligned<T>(size);
+    std::memset(base, 0, size);
+
+    HipaccImage img = HipaccImage(width, height, stride, 0, sizeof(T),
+                                  (void *)(base + halo_y*stride + halo_x));
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    Ctx.add_image(img);
+
+    HipaccHalo halo = { (char *)base, halo_x, halo_y, mode,
+                        std::vector<char>(sizeof(T)) };
+    std::memcpy(halo.const_val.data(), &const_val, sizeof(T));
+    Ctx.add_halo(img, halo);
+
+    if (host_mem) hipaccWriteMemory(img, host_mem);
+    else hipaccFillHalo(img);
+
+    return img;
+}
+
+
+// Create an image that is streamed through memory: the kernel launch reads
+// rows on demand using the read callback and hands computed rows of the
+// iteration space to the write callback. Only a window of rows around the
+// strip being processed is allocated, see hipaccLaunchKernelStreamed().
+// Streamed images can be accessed by kernels only, not by hipaccReadMemory(),
+// hipaccWriteMemory(), global reductions, scans, or histograms.
+template<typename T>
+HipaccImage hipaccCreateStreamedMemory(size_t width, size_t height,
+                                       const hipacc_row_fn &read,
+                                       const hipacc_row_fn &write=hipacc_row_fn()) {
+    // mem holds a single row while the image is not used by a kernel launch
+    T *mem = hipaccAllocAligned<T>(sizeof(T)*width);
+    HipaccImage img = HipaccImage(width, height, width, 0, sizeof(T), mem);
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    Ctx.add_image(img);
+    Ctx.add_stream(img, read, write);
+
+    return img;
+}
+
+
+// Create an image from memory owned by the application without copying it;
+// the memory has to stay valid until the image is released and is not freed
+// by hipaccReleaseMemory(). stride is given in pixels.
+template<typename T>
+HipaccImage hipaccWrapMemory(T *host_mem, size_t width, size_t height,
+                             size_t stride=0) {
+    if (stride == 0) stride = width;
+    HipaccImage img = HipaccImage(width, height, stride, 0, sizeof(T),
+                                  (void *)host_mem);
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    Ctx.add_image(img);
+    Ctx.add_wrapped(img);
+    if (stride == width) img.set_host(host_mem);
+
+    return img;
+}
+
+
 // Release memory
 void hipaccReleaseMemory(HipaccImage &img) {
     HipaccContext &Ctx = HipaccContext::getInstance();
-    free(img.mem);
+    Ctx.del_stream(img);
+    HipaccHalo *halo = Ctx.get_halo(img);
+    if (!Ctx.is_wrapped(img)) free(halo ? (void *)halo->base : img.mem);
+    Ctx.del_halo(img);
+    Ctx.del_wrapped(img);
     Ctx.del_image(img);
 }
 
 
+// Execute kernel in horizontal strips of strip_rows rows of the iteration
+// space. Streamed images among the given images are backed by a rolling
+// buffer of strip_rows+2*halo_rows rows: rows still required by the next
+// strip are kept, missing rows are read, and computed rows of the iteration
+// space are written back after each strip. Other images are used in place.
+// Kernels address the rows of all given images through row tables, see
+// hipaccGetRows(): only the entries of buffered rows of streamed images are
+// set. This requires that accessors read at most halo_rows rows above/below
+// the current pixel and have no offset, region of interest, or interpolation,
+// which is checked by the compiler.
+void hipaccLaunchKernelStreamed(size_t num_threads, int strip_rows,
+                                int halo_rows, HipaccAccessor &is,
+                                std::vector<HipaccImage *> images,
+                                const std::function<void(int, int)> &kernel) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<std::pair<HipaccImage *, HipaccStream *> > streams;
+    std::vector<HipaccImage *> tables;
+
+    if (strip_rows <= 0) strip_rows = is.height;
+
+    for (size_t i=0; i<images.size(); ++i) {
+        HipaccImage &img = *images[i];
+        std::vector<void *> *rows = Ctx.add_rows(img);
+        if (!rows) continue;
+        tables.push_back(&img);
+
+        size_t row_size = img.stride*img.pixel_size;
+        HipaccStream *stream = Ctx.get_stream(img);
+        if (!stream) {
+            for (size_t y=0; y<img.height; ++y)
+                (*rows)[y] = (char *)img.mem + y*row_size;
+            continue;
+        }
+
+        size_t buffer_rows = std::min((size_t)(strip_rows + 2*halo_rows), img.height);
+        if (stream->buffer_rows < buffer_rows) {
+            free(stream->buffer);
+            stream->buffer = hipaccAllocAligned<char>(row_size*buffer_rows);
+            stream->buffer_rows = buffer_rows;
+        }
+        stream->first_row = stream->last_row = 0;
+        streams.push_back(std::make_pair(&img, stream));
+    }
+
+    if (streams.empty()) strip_rows = is.height;
+
+    for (int start=0; start<(int)is.height; start+=strip_rows) {
+        int end = std::min(start + strip_rows, (int)is.height);
+
+        for (size_t i=0; i<streams.size(); ++i) {
+            HipaccImage &img = *streams[i].first;
+            HipaccStream &stream = *streams[i].second;
+            void **rows = Ctx.get_rows(img);
+            size_t row_size = img.stride*img.pixel_size;
+            size_t lo, hi;
+
+            if (img.refcount == is.img.refcount) {
+                // output: rows of the current strip
+                lo = is.offset_y + start;
+                hi = is.offset_y + end;
+                for (size_t y=lo; y<hi; ++y) {
+                    char *row = stream.buffer + (y-lo)*row_size;
+                    if (stream.read) stream.read(row, y);
+                    else std::memset(row, 0, row_size);
+                }
+            } else {
+                // input: rows of the current strip plus halo
+                lo = std::max(is.offset_y + start - halo_rows, 0);
+                hi = std::min(is.offset_y + end + halo_rows, (int)img.height);
+                size_t next = lo;
+                if (lo >= stream.first_row && lo < stream.last_row) {
+                    std::memmove(stream.buffer,
+                                 stream.buffer + (lo-stream.first_row)*row_size,
+                                 (stream.last_row-lo)*row_size);
+                    next = stream.last_row;
+                }
+                for (size_t y=next; y<hi; ++y) {
+                    stream.read(stream.buffer + (y-lo)*row_size, y);
+                }
+            }
+
+            for (size_t y=stream.first_row; y<stream.last_row; ++y)
+                rows[y] = NULL;
+            for (size_t y=lo; y<hi; ++y)
+                rows[y] = stream.buffer + (y-lo)*row_size;
+            stream.first_row = lo;
+            stream.last_row = hi;
+        }
+
+        hipaccLaunchKernel(num_threads, end - start,
+                           [&] (int row_start, int row_end) {
+                               kernel(start + row_start, start + row_end);
+                           });
+
+        for (size_t i=0; i<streams.size(); ++i) {
+            HipaccImage &img = *streams[i].first;
+            HipaccStream &stream = *streams[i].second;
+            if (img.refcount != is.img.refcount || !stream.write) continue;
+
+            size_t row_size = img.stride*img.pixel_size;
+            for (size_t y=stream.first_row; y<stream.last_row; ++y) {
+                stream.write(stream.buffer + (y-stream.first_row)*row_size, y);
+            }
+        }
+    }
+
+    for (size_t i=0; i<tables.size(); ++i) Ctx.del_rows(*tables[i]);
+}
+
+
+// Row table of an image used by a kernel launched by
+// hipaccLaunchKernelStreamed(): entry y points to row y of the image
+void **hipaccGetRows(HipaccImage &img) {
+    return HipaccContext::getInstance().get_rows(img);
+}
+
+
+// Streamed images hold only a window of rows: operations on the whole image
+// are not supported
+void hipaccCheckNotStreamed(HipaccImage &img, const char *operation) {
+    if (HipaccContext::getInstance().get_stream(img)) {
+        std::cerr << "ERROR: " << operation
+                  << " is not supported for streamed images" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+
 // Write to memory
 template<typename T>
 void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
-    if (host_mem == NULL) return;
+    if (host_mem == NULL || host_mem == img.mem) return;
+    hipaccCheckNotStreamed(img, "hipaccWriteMemory()");
 
     size_t width  = img.width;
     size_t height = img.height;
     size_t stride = img.stride;
 
-    if ((char *)host_mem != img.host)
-        std::copy(host_mem, host_mem + width*height, (T*)img.host);
-
     if (stride > width) {
         for (size_t i=0; i<height; ++i) {
             std::memcpy(&((T*)img.mem)[i*stride], &host_mem[i*width], sizeof(T)*width);
@@ -119,33 +703,46 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
     } else {
         std::memcpy(img.mem, host_mem, sizeof(T)*width*height);
     }
+    hipaccFillHalo(img);
 }
 
 
-// Read from memory
+// Read from memory; unpadded images return their memory without copying
 template<typename T>
 T *hipaccReadMemory(HipaccImage &img) {
+    hipaccCheckNotStreamed(img, "hipaccReadMemory()");
+    if (img.host_is(img.mem)) return (T*)img.mem;
+
     size_t width  = img.width;
     size_t height = img.height;
     size_t stride = img.stride;
+    T *host = (T*)img.host();
 
-    if (stride > width) {
-        for (size_t i=0; i<height; ++i) {
-            std::memcpy(&((T*)img.host)[i*width], &((T*)img.mem)[i*stride], sizeof(T)*width);
-        }
-    } else {
-        std::memcpy((T*)img.host, img.mem, sizeof(T)*width*height);
+    for (size_t i=0; i<height; ++i) {
+        std::memcpy(&host[i*width], &((T*)img.mem)[i*stride], sizeof(T)*width);
     }
 
-    return (T*)img.host;
+    return host;
 }
 
 
 // Copy from memory to memory
 void hipaccCopyMemory(HipaccImage &src, HipaccImage &dst) {
+    hipaccCheckNotStreamed(src, "hipaccCopyMemory()");
+    hipaccCheckNotStreamed(dst, "hipaccCopyMemory()");
+    HipaccContext &Ctx = HipaccContext::getInstance();
     size_t height = src.height;
     size_t stride = src.stride;
-    std::memcpy(dst.mem, src.mem, src.pixel_size*stride*height);
+    if (stride == dst.stride && !Ctx.get_halo(src) && !Ctx.get_halo(dst)) {
+        std::memcpy(dst.mem, src.mem, src.pixel_size*stride*height);
+    } else {
+        size_t row_size = src.pixel_size*src.width;
+        for (size_t i=0; i<height; ++i) {
+            std::memcpy((char *)dst.mem + i*dst.stride*dst.pixel_size,
+                        (char *)src.mem + i*stride*src.pixel_size, row_size);
+        }
+    }
+    hipaccFillHalo(dst);
 }
 
 
@@ -172,6 +769,7 @@ void hipaccCopyMemoryRegion(HipaccAccessor &src, HipaccAccessor &dst) {
                     &((uchar*)src.img.mem)[src.offset_x*src.img.pixel_size + (src.offset_y + i)*src.img.stride*src.img.pixel_size],
                     src.width*src.img.pixel_size);
     }
+    hipaccFillHalo(dst.img);
 }
 
 #endif  // __HIPACC_CPU_HPP__
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2014, Saarland University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#ifndef __HIPACC_CPU_RED_HPP__
+#define __HIPACC_CPU_RED_HPP__
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// Apply global reduction to the region of an image described by the accessor.
+// Rows are split into blocks, several per thread for load balancing; each
+// block is reduced into a partial result and the partial results are combined
+// pairwise afterwards.
+template<typename T, typename F>
+T hipaccApplyReduction(HipaccAccessor &acc, size_t num_threads, F reduce) {
+    hipaccCheckNotStreamed(acc.img, "global reduction");
+    const T *input = (const T *)acc.img.mem;
+    const size_t stride = acc.img.stride;
+    const int width = acc.width;
+    const int height = acc.height;
+
+    // there is no neutral element for the reduce function
+    assert(width > 0 && height > 0 && "reduction of empty iteration space");
+
+    if (num_threads != 1) num_threads = hipaccGetNumThreads(num_threads);
+    const int num_blocks = std::min(height, (int)(4*num_threads));
+    std::vector<T> partial(num_blocks);
+
+    auto reduce_blocks = [&] (int block_start, int block_end) {
+        for (int block=block_start; block<block_end; ++block) {
+            const int row_start = block * height / num_blocks;
+            const int row_end = (block + 1) * height / num_blocks;
+            const T *row = input + (row_start + acc.offset_y)*stride + acc.offset_x;
+
+            T val = row[0];
+            for (int x=1; x<width; ++x) val = reduce(val, row[x]);
+            for (int y=row_start+1; y<row_end; ++y) {
+                row += stride;
+                for (int x=0; x<width; ++x) val = reduce(val, row[x]);
+            }
+            partial[block] = val;
+        }
+    };
+    HipaccWorkerPool::getInstance().run(num_threads, num_blocks, reduce_blocks);
+
+    // tree combine of partial results
+    for (int step=1; step<num_blocks; step*=2) {
+        for (int i=0; i+step<num_blocks; i+=2*step) {
+            partial[i] = reduce(partial[i], partial[i+step]);
+        }
+    }
+
+    return partial[0];
+}
+
+// Instantiate a reduction function for the iteration space and the reduce
+// function of a kernel
+#define REDUCTION_CPU_2D(NAME, DATA_TYPE, REDUCE) \
+inline DATA_TYPE NAME(HipaccAccessor &acc, size_t num_threads) { \
+    return hipaccApplyReduction<DATA_TYPE>(acc, num_threads, \
+            [] (DATA_TYPE left, DATA_TYPE right) { \
+                return REDUCE(left, right); \
+            }); \
+} \
+inline DATA_TYPE NAME(HipaccImage &img, size_t num_threads) { \
+    HipaccAccessor acc(img); \
+    return NAME(acc, num_threads); \
+}
+
+// Apply an inclusive 2D scan in place to the region of an image described by
+// the accessor: rows are scanned first, columns afterwards, so that each pixel
+// holds the scan over the rectangle from the origin of the region to the pixel,
+// e.g. the summed-area table for addition. The row pass distributes rows over
+// the threads; the column pass distributes blocks of adjacent columns, which
+// are scanned row by row to keep the accesses of each thread contiguous.
+template<typename T, typename F>
+void hipaccApplyScan(HipaccAccessor &acc, size_t num_threads, F scan) {
+    hipaccCheckNotStreamed(acc.img, "scan");
+    T *data = (T *)acc.img.mem + acc.offset_y*acc.img.stride + acc.offset_x;
+    const size_t stride = acc.img.stride;
+    const int width = acc.width;
+    const int height = acc.height;
+
+    if (width <= 0 || height <= 0) return;
+    if (num_threads != 1) num_threads = hipaccGetNumThreads(num_threads);
+
+    auto scan_rows = [&] (int row_start, int row_end) {
+        for (int y=row_start; y<row_end; ++y) {
+            T *row = data + y*stride;
+            T val = row[0];
+            for (int x=1; x<width; ++x) row[x] = val = scan(val, row[x]);
+        }
+    };
+    HipaccWorkerPool::getInstance().run(num_threads, height, scan_rows);
+
+    // block boundaries are multiples of 64 columns, so that threads share no
+    // cache lines if the first column of the region is cache line aligned
+    const int num_chunks = (width + 63) / 64;
+    const int num_blocks = std::min(num_chunks, (int)(4*num_threads));
+    auto scan_columns = [&] (int block_start, int block_end) {
+        const int col_start = std::min(width,
+                                       block_start * num_chunks / num_blocks * 64);
+        const int col_end = std::min(width,
+                                     block_end * num_chunks / num_blocks * 64);
+        const T *prev = data + col_start;
+        for (int y=1; y<height; ++y) {
+            T *row = data + y*stride + col_start;
+            for (int x=0; x<col_end-col_start; ++x) row[x] = scan(prev[x], row[x]);
+            prev = row;
+        }
+    };
+    HipaccWorkerPool::getInstance().run(num_threads, num_blocks, scan_columns);
+}
+
+// Instantiate a scan function for the iteration space and the scan function of
+// a kernel
+#define SCAN_CPU_2D(NAME, DATA_TYPE, SCAN) \
+inline void NAME(HipaccAccessor &acc, size_t num_threads) { \
+    hipaccApplyScan<DATA_TYPE>(acc, num_threads, \
+            [] (DATA_TYPE left, DATA_TYPE right) { \
+                return SCAN(left, right); \
+            }); \
+} \
+inline void NAME(HipaccImage &img, size_t num_threads) { \
+    HipaccAccessor acc(img); \
+    NAME(acc, num_threads); \
+}
+
+// Compute the histogram of the region of an image described by the accessor
+// using the bin function, which maps a pixel to its bin. Rows are split into
+// one block per thread, each accumulated into private bins; the private bins
+// are merged in parallel afterwards, each thread summing a range of bins. Bin
+// indices outside of the histogram are ignored.
+template<typename T, typename F>
+std::vector<unsigned int> hipaccApplyBinning(HipaccAccessor &acc, size_t
+        num_threads, unsigned int num_bins, F bin) {
+    hipaccCheckNotStreamed(acc.img, "binning");
+    const T *input = (const T *)acc.img.mem;
+    const size_t stride = acc.img.stride;
+    const int width = acc.width;
+    const int height = acc.height;
+
+    if (num_threads != 1) num_threads = hipaccGetNumThreads(num_threads);
+    const int num_blocks = std::max(1, std::min(height, (int)num_threads));
+    std::vector<std::vector<unsigned int> > partial(num_blocks,
+            std::vector<unsigned int>(num_bins, 0));
+
+    auto bin_blocks = [&] (int block_start, int block_end) {
+        for (int block=block_start; block<block_end; ++block) {
+            const int row_start = block * height / num_blocks;
+            const int row_end = (block + 1) * height / num_blocks;
+            unsigned int *hist = partial[block].data();
+
+            for (int y=row_start; y<row_end; ++y) {
+                const T *row = input + (y + acc.offset_y)*stride + acc.offset_x;
+                for (int x=0; x<width; ++x) {
+                    unsigned int idx = bin(row[x], num_bins);
+                    if (idx < num_bins) ++hist[idx];
+                }
+            }
+        }
+    };
+    HipaccWorkerPool::getInstance().run(num_threads, num_blocks, bin_blocks);
+
+    // merge private bins
+    std::vector<unsigned int> hist(num_bins, 0);
+    auto merge_bins = [&] (int bin_start, int bin_end) {
+        for (int block=0; block<num_blocks; ++block) {
+            const unsigned int *src = partial[block].data();
+            for (int idx=bin_start; idx<bin_end; ++idx) {
+                hist[idx] += src[idx];
+            }
+        }
+    };
+    HipaccWorkerPool::getInstance().run(num_threads, num_bins, merge_bins);
+
+    return hist;
+}
+
+// Instantiate a binning function for the iteration space and the bin function
+// of a kernel
+#define BINNING_CPU_2D(NAME, DATA_TYPE, BIN) \
+inline std::vector<unsigned int> NAME(HipaccAccessor &acc, size_t num_threads, \
+        unsigned int num_bins) { \
+    return hipaccApplyBinning<DATA_TYPE>(acc, num_threads, num_bins, \
+            [] (DATA_TYPE pixel, unsigned int num_bins) { \
+                return BIN(pixel, num_bins); \
+            }); \
+} \
+inline std::vector<unsigned int> NAME(HipaccImage &img, size_t num_threads, \
+        unsigned int num_bins) { \
+    HipaccAccessor acc(img); \
+    return NAME(acc, num_threads, num_bins); \
+}
+
+#endif  // __HIPACC_CPU_RED_HPP__
+
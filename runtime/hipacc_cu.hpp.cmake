@@ -333,7 +333,12 @@ HipaccImage createImage(T *host_mem, void *mem, size_t width, size_t height, siz
     HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), mem, mem_type);
     HipaccContext &Ctx = HipaccContext::getInstance();
     Ctx.add_image(img);
-    hipaccWriteMemory(img, host_mem ? host_mem : (T*)img.host);
+    if (host_mem) {
+        hipaccWriteMemory(img, host_mem);
+    } else {
+        std::vector<T> zeros(width*height);
+        hipaccWriteMemory(img, zeros.data());
+    }
 
     return img;
 }
@@ -421,9 +426,6 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
     size_t height = img.height;
     size_t stride = img.stride;
 
-    if ((char *)host_mem != img.host)
-        std::copy(host_mem, host_mem + width*height, (T*)img.host);
-
     if (img.mem_type >= Array2D) {
         cudaError_t err = cudaMemcpyToArray((cudaArray *)img.mem, 0, 0, host_mem, sizeof(T)*width*height, cudaMemcpyHostToDevice);
         checkErr(err, "cudaMemcpyToArray()");
@@ -439,7 +441,7 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
 }
 
 
-// Read from memory
+// Read from memory; the host copy of the image is allocated on first use
 template<typename T>
 T *hipaccReadMemory(HipaccImage &img) {
     size_t width  = img.width;
@@ -447,19 +449,19 @@ T *hipaccReadMemory(HipaccImage &img) {
     size_t stride = img.stride;
 
     if (img.mem_type >= Array2D) {
-        cudaError_t err = cudaMemcpyFromArray((T*)img.host, (cudaArray *)img.mem, 0, 0, sizeof(T)*width*height, cudaMemcpyDeviceToHost);
+        cudaError_t err = cudaMemcpyFromArray((T*)img.host(), (cudaArray *)img.mem, 0, 0, sizeof(T)*width*height, cudaMemcpyDeviceToHost);
         checkErr(err, "cudaMemcpyFromArray()");
     } else {
         if (stride > width) {
-            cudaError_t err = cudaMemcpy2D((T*)img.host, width*sizeof(T), img.mem, stride*sizeof(T), width*sizeof(T), height, cudaMemcpyDeviceToHost);
+            cudaError_t err = cudaMemcpy2D((T*)img.host(), width*sizeof(T), img.mem, stride*sizeof(T), width*sizeof(T), height, cudaMemcpyDeviceToHost);
             checkErr(err, "cudaMemcpy2D()");
         } else {
-            cudaError_t err = cudaMemcpy((T*)img.host, img.mem, sizeof(T)*width*height, cudaMemcpyDeviceToHost);
+            cudaError_t err = cudaMemcpy((T*)img.host(), img.mem, sizeof(T)*width*height, cudaMemcpyDeviceToHost);
             checkErr(err, "cudaMemcpy()");
         }
     }
 
-    return (T*)img.host;
+    return (T*)img.host();
 }
 
 
@@ -991,6 +993,130 @@ T hipaccApplyReduction(const void *kernel2D, std::string kernel2D_name, const
 }
 
 
+// Apply an inclusive 2D scan in place to the region of an image: rows are
+// scanned first by one block per row, columns afterwards by one thread per
+// column
+void hipaccApplyScan(const void *kernelRow, std::string kernelRow_name, const
+        void *kernelColumn, std::string kernelColumn_name, HipaccAccessor &acc,
+        unsigned int max_threads) {
+    if (acc.width == 0 || acc.height == 0) return;
+
+    dim3 block(max_threads, 1);
+    dim3 grid(1, acc.height);
+
+    size_t offset = 0;
+    hipaccConfigureCall(grid, block);
+
+    hipaccSetupArgument(&acc.img.mem, sizeof(void *), offset);
+    hipaccSetupArgument(&acc.width, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.height, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.img.stride, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_x, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_y, sizeof(unsigned int), offset);
+
+    hipaccLaunchKernel(kernelRow, kernelRow_name, grid, block);
+
+    grid = dim3((int)ceilf((float)(acc.width)/block.x), 1);
+
+    offset = 0;
+    hipaccConfigureCall(grid, block);
+
+    hipaccSetupArgument(&acc.img.mem, sizeof(void *), offset);
+    hipaccSetupArgument(&acc.width, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.height, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.img.stride, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_x, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_y, sizeof(unsigned int), offset);
+
+    hipaccLaunchKernel(kernelColumn, kernelColumn_name, grid, block);
+}
+void hipaccApplyScan(const void *kernelRow, std::string kernelRow_name, const
+        void *kernelColumn, std::string kernelColumn_name, HipaccImage &img,
+        unsigned int max_threads) {
+    HipaccAccessor acc(img);
+    hipaccApplyScan(kernelRow, kernelRow_name, kernelColumn,
+            kernelColumn_name, acc, max_threads);
+}
+
+
+// Compute the histogram of the region of an image: each block accumulates
+// pixels_per_thread rows into privatized bins in shared memory, the partial
+// histograms are merged afterwards
+std::vector<unsigned int> hipaccApplyBinning(const void *kernel2D, std::string
+        kernel2D_name, const void *kernel1D, std::string kernel1D_name,
+        HipaccAccessor &acc, unsigned int max_threads, unsigned int
+        pixels_per_thread, unsigned int num_bins) {
+    unsigned int *output;   // GPU memory for partial histograms
+    std::vector<unsigned int> hist(num_bins);
+
+    if (num_bins == 0 || acc.width == 0 || acc.height == 0) return hist;
+
+    // bins are privatized in shared memory if they fit, otherwise they are
+    // accumulated in the partial histograms using global atomics
+    int device = 0, shared_mem_size = 0;
+    cudaError_t err = cudaGetDevice(&device);
+    checkErr(err, "cudaGetDevice()");
+    err = cudaDeviceGetAttribute(&shared_mem_size,
+            cudaDevAttrMaxSharedMemoryPerBlock, device);
+    checkErr(err, "cudaDeviceGetAttribute()");
+    unsigned int use_shared = sizeof(unsigned int)*num_bins <=
+        (size_t)shared_mem_size;
+
+    dim3 block(max_threads, 1);
+    dim3 grid(1, (int)ceilf((float)(acc.height)/pixels_per_thread));
+    unsigned int num_partials = grid.y;
+
+    err = cudaMalloc((void **) &output, sizeof(unsigned int)*num_bins*num_partials);
+    checkErr(err, "cudaMalloc()");
+
+    // the bins are privatized in dynamically allocated shared memory
+    size_t offset = 0;
+    err = cudaConfigureCall(grid, block, use_shared ?
+            sizeof(unsigned int)*num_bins : 0, 0);
+    checkErr(err, "cudaConfigureCall()");
+
+    hipaccSetupArgument(&acc.img.mem, sizeof(void *), offset);
+    hipaccSetupArgument(&output, sizeof(unsigned int *), offset);
+    hipaccSetupArgument(&acc.width, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.height, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.img.stride, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_x, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&acc.offset_y, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&num_bins, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&use_shared, sizeof(unsigned int), offset);
+
+    hipaccLaunchKernel(kernel2D, kernel2D_name, grid, block);
+
+    grid = dim3((int)ceilf((float)(num_bins)/block.x), 1);
+
+    offset = 0;
+    hipaccConfigureCall(grid, block);
+
+    hipaccSetupArgument(&output, sizeof(unsigned int *), offset);
+    hipaccSetupArgument(&num_bins, sizeof(unsigned int), offset);
+    hipaccSetupArgument(&num_partials, sizeof(unsigned int), offset);
+
+    hipaccLaunchKernel(kernel1D, kernel1D_name, grid, block);
+
+    // get histogram
+    err = cudaMemcpy(hist.data(), output, sizeof(unsigned int)*num_bins, cudaMemcpyDeviceToHost);
+    checkErr(err, "cudaMemcpy()");
+
+    err = cudaFree(output);
+    checkErr(err, "cudaFree()");
+
+    return hist;
+}
+std::vector<unsigned int> hipaccApplyBinning(const void *kernel2D, std::string
+        kernel2D_name, const void *kernel1D, std::string kernel1D_name,
+        HipaccImage &img, unsigned int max_threads, unsigned int
+        pixels_per_thread, unsigned int num_bins) {
+    HipaccAccessor acc(img);
+    return hipaccApplyBinning(kernel2D, kernel2D_name, kernel1D,
+            kernel1D_name, acc, max_threads, pixels_per_thread, num_bins);
+}
+
+
 // Perform global reduction using memory fence operations and return result
 template<typename T>
 T hipaccApplyReductionThreadFence(const void *kernel2D, std::string
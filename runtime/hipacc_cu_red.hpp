@@ -264,5 +264,114 @@ __global__ void NAME(const DATA_TYPE *input, DATA_TYPE *output, const unsigned \
     if (tid == 0) output[blockIdx.x] = sdata[0]; \
 }
 
+// inclusive 2D scan, step 1:
+// scan each row of the region in place using one block per row; the row is
+// processed in chunks of BS pixels, each scanned in shared memory and combined
+// with the carry of the previous chunks
+#define SCAN_CUDA_ROW(NAME, DATA_TYPE, SCAN) \
+__global__ void __launch_bounds__ (BS) NAME(DATA_TYPE *data, \
+        const unsigned int width, const unsigned int height, \
+        const unsigned int stride, const unsigned int offset_x, \
+        const unsigned int offset_y) { \
+    const unsigned int tid = threadIdx.x; \
+    DATA_TYPE *row = data + (blockIdx.y + offset_y)*stride + offset_x; \
+ \
+    __shared__ DATA_TYPE sdata[BS]; \
+ \
+    DATA_TYPE carry; \
+ \
+    for (unsigned int x0=0; x0 < width; x0 += BS) { \
+        const unsigned int x = x0 + tid; \
+        DATA_TYPE val = row[min(x, width-1)]; \
+        sdata[tid] = val; \
+ \
+        __syncthreads(); \
+ \
+        for (unsigned int s=1; s < BS; s<<=1) { \
+            if (tid >= s) val = SCAN(sdata[tid - s], val); \
+            __syncthreads(); \
+            sdata[tid] = val; \
+            __syncthreads(); \
+        } \
+ \
+        if (x0) val = SCAN(carry, val); \
+        if (x < width) row[x] = val; \
+        carry = x0 ? SCAN(carry, sdata[BS-1]) : sdata[BS-1]; \
+ \
+        __syncthreads(); \
+    } \
+}
+
+
+// inclusive 2D scan, step 2:
+// scan each column of the region in place; each thread walks down one column,
+// so that the accesses of a warp are coalesced
+#define SCAN_CUDA_COLUMN(NAME, DATA_TYPE, SCAN) \
+__global__ void __launch_bounds__ (BS) NAME(DATA_TYPE *data, \
+        const unsigned int width, const unsigned int height, \
+        const unsigned int stride, const unsigned int offset_x, \
+        const unsigned int offset_y) { \
+    const unsigned int gid_x = blockDim.x * blockIdx.x + threadIdx.x; \
+    if (gid_x >= width) return; \
+ \
+    DATA_TYPE *col = data + offset_y*stride + offset_x + gid_x; \
+ \
+    DATA_TYPE val = col[0]; \
+    for (unsigned int y=1; y < height; ++y) { \
+        col += stride; \
+        *col = val = SCAN(val, *col); \
+    } \
+}
+
+// histogram, step 1:
+// accumulate PPT rows of the region into bins in shared memory, which are
+// written to the partial histogram of the block in linear memory; the size of
+// the shared memory is specified at launch. Bins exceeding the shared memory
+// are accumulated in the partial histogram directly
+#define BINNING_CUDA_2D(NAME, DATA_TYPE, BIN) \
+__global__ void __launch_bounds__ (BS) NAME(const DATA_TYPE *input, \
+        unsigned int *output, const unsigned int width, \
+        const unsigned int height, const unsigned int stride, \
+        const unsigned int offset_x, const unsigned int offset_y, \
+        const unsigned int num_bins, const unsigned int use_shared) { \
+    extern __shared__ unsigned int lhist[]; \
+    const unsigned int tid = threadIdx.x; \
+    const unsigned int y_start = PPT * blockIdx.y; \
+    const unsigned int y_end = min(y_start + PPT, height); \
+    unsigned int *partial = output + blockIdx.y*num_bins; \
+    unsigned int *hist = use_shared ? lhist : partial; \
+ \
+    for (unsigned int i=tid; i < num_bins; i += BS) hist[i] = 0; \
+ \
+    __syncthreads(); \
+ \
+    for (unsigned int y=y_start; y < y_end; ++y) { \
+        const DATA_TYPE *row = input + (y + offset_y)*stride + offset_x; \
+        for (unsigned int x=tid; x < width; x += BS) { \
+            const unsigned int idx = BIN(row[x], num_bins); \
+            if (idx < num_bins) atomicAdd(&hist[idx], 1); \
+        } \
+    } \
+ \
+    __syncthreads(); \
+ \
+    if (use_shared) \
+        for (unsigned int i=tid; i < num_bins; i += BS) partial[i] = lhist[i]; \
+}
+
+
+// histogram, step 2:
+// merge the partial histograms into the first one, one thread per bin
+#define BINNING_CUDA_1D(NAME) \
+__global__ void NAME(unsigned int *partial, const unsigned int num_bins, \
+        const unsigned int num_partials) { \
+    const unsigned int gid = blockDim.x * blockIdx.x + threadIdx.x; \
+    if (gid >= num_bins) return; \
+ \
+    unsigned int sum = 0; \
+    for (unsigned int i=0; i < num_partials; ++i) sum += partial[i*num_bins + gid]; \
+    partial[gid] = sum; \
+}
+
 //#endif  // __HIPACC_CU_RED_HPP__
 
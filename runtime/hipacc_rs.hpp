@@ -406,9 +406,6 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
     size_t height = img.height;
     size_t stride = img.stride;
 
-    if ((char *)host_mem != img.host)
-        std::copy(host_mem, host_mem + width*height, (T*)img.host);
-
     if (stride > width) {
         T* buff = new T[stride * height];
         for (size_t i=0; i<height; ++i) {
@@ -422,7 +419,7 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
 }
 
 
-// Read from allocation
+// Read from allocation; the host copy of the image is allocated on first use
 template<typename T>
 T *hipaccReadMemory(HipaccImage &img) {
     size_t width  = img.width;
@@ -433,14 +430,14 @@ T *hipaccReadMemory(HipaccImage &img) {
         T* buff = new T[stride * height];
         COPYTO(T, (Allocation *)img.mem, 0, stride * height, buff);
         for (size_t i=0; i<height; ++i) {
-            std::memcpy(&((T*)img.host)[i*width], buff + (i * stride), sizeof(T) * width);
+            std::memcpy(&((T*)img.host())[i*width], buff + (i * stride), sizeof(T) * width);
         }
         delete[] buff;
     } else {
-        COPYTO(T, (Allocation *)img.mem, 0, width * height, (T*)img.host);
+        COPYTO(T, (Allocation *)img.mem, 0, width * height, (T*)img.host());
     }
 
-    return (T*)img.host;
+    return (T*)img.host();
 }
 
 
@@ -491,7 +488,12 @@ HipaccImage createImage(T *host_mem, size_t width, size_t height, size_t stride,
 \
     HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), (void *)allocation.get()); \
     Ctx.add_image(img, allocation); \
-    hipaccWriteMemory(img, host_mem ? host_mem : (T*)img.host); \
+    if (host_mem) { \
+        hipaccWriteMemory(img, host_mem); \
+    } else { \
+        std::vector<T> zeros(width*height); \
+        hipaccWriteMemory(img, zeros.data()); \
+    } \
 \
     return img; \
 } \
@@ -24,12 +24,20 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 
-// undef macros defined for reductions
+// undef macros defined for reductions, scans, and histograms
 #undef REDUCTION_CUDA_2D_THREAD_FENCE
 #undef REDUCTION_CUDA_2D
 #undef REDUCTION_CUDA_1D
 #undef REDUCTION_CL_2D
 #undef REDUCTION_CL_1D
+#undef SCAN_CUDA_ROW
+#undef SCAN_CUDA_COLUMN
+#undef SCAN_CL_ROW
+#undef SCAN_CL_COLUMN
+#undef BINNING_CUDA_2D
+#undef BINNING_CUDA_1D
+#undef BINNING_CL_2D
+#undef BINNING_CL_1D
 #undef OFFSETS
 #undef IS_HEIGHT
 #undef OFFSET_BLOCK
@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+// reference
+template<typename data_t, typename bin_t>
+std::vector<unsigned int> calc_histogram(data_t *in, int width, int height,
+        int offset_x, int offset_y, int is_width, int is_height, unsigned int
+        num_bins, bin_t bin) {
+    std::vector<unsigned int> hist(num_bins, 0);
+
+    for (int y=offset_y; y<offset_y+is_height; ++y) {
+        for (int x=offset_x; x<offset_x+is_width; ++x) {
+            unsigned int idx = bin(in[x + y*width], num_bins);
+            if (idx < num_bins) ++hist[idx];
+        }
+    }
+
+    return hist;
+}
+
+
+// Kernel description in HIPAcc
+class HistogramUChar : public Kernel<uchar> {
+    private:
+        Accessor<uchar> &in;
+
+    public:
+        HistogramUChar(IterationSpace<uchar> &iter, Accessor<uchar> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        uint bin(uchar pixel, uint num_bins) {
+            return pixel * num_bins / 256;
+        }
+};
+class HistogramUInt : public Kernel<uint> {
+    private:
+        Accessor<uint> &in;
+
+    public:
+        HistogramUInt(IterationSpace<uint> &iter, Accessor<uint> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        // pixels beyond the last bin are ignored
+        uint bin(uint pixel, uint num_bins) {
+            return pixel;
+        }
+};
+
+
+// compare the histogram against the reference
+bool compare(std::vector<unsigned int> &hist, std::vector<unsigned int>
+        &reference, const char *name) {
+    if (hist.size() != reference.size()) {
+        fprintf(stderr, "Test FAILED for histogram (%s): %d vs %d bins\n",
+                name, (int)hist.size(), (int)reference.size());
+        return false;
+    }
+    for (size_t i=0; i<hist.size(); ++i) {
+        if (hist[i] != reference[i]) {
+            fprintf(stderr, "Test FAILED for histogram (%s), at bin %d: %u vs %u\n",
+                    name, (int)i, hist[i], reference[i]);
+            return false;
+        }
+    }
+    fprintf(stderr, "Histogram (%s): PASSED\n", name);
+
+    return true;
+}
+
+
+int main(int argc, const char **argv) {
+    double time0, time1, dt;
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    // more bins than fit into local/shared memory
+    const unsigned int num_bins_large = 1 << 16;
+
+    // host memory for image of width x height pixels
+    uchar *input_uchar = (uchar *)malloc(sizeof(uchar)*width*height);
+    uint *input_uint = (uint *)malloc(sizeof(uint)*width*height);
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input_uchar[y*width + x] = (uchar) ((x*x + 3*y) % 256);
+            input_uint[y*width + x] = (uint) ((x*7919 + y*104729) % (num_bins_large + 1024));
+        }
+    }
+
+    // input and output image of width x height pixels
+    Image<uchar> in_uchar(width, height, input_uchar);
+    Image<uchar> out_uchar(width, height);
+    Image<uint> in_uint(width, height, input_uint);
+    Image<uint> out_uint(width, height);
+
+    Accessor<uchar> acc_in_uchar(in_uchar);
+    Accessor<uchar> acc_roi_uchar(in_uchar, width/3, height/3, width/3, height/3);
+    Accessor<uint> acc_in_uint(in_uint);
+
+    // iteration spaces
+    IterationSpace<uchar> out_uchar_iter(out_uchar);
+    IterationSpace<uchar> out_roi_uchar_iter(out_uchar, width/3, height/3, width/3, height/3);
+    IterationSpace<uint> out_uint_iter(out_uint);
+
+    HistogramUChar histUChar(out_uchar_iter, acc_in_uchar);
+    HistogramUChar histRoiUChar(out_roi_uchar_iter, acc_roi_uchar);
+    HistogramUInt histUInt(out_uint_iter, acc_in_uint);
+
+    fprintf(stderr, "Calculating histograms ...\n");
+    time0 = time_ms();
+
+    histUChar.execute();
+    std::vector<unsigned int> hist_uchar_256 = histUChar.binned_data(256);
+    std::vector<unsigned int> hist_uchar_64 = histUChar.binned_data(64);
+    histRoiUChar.execute();
+    std::vector<unsigned int> hist_roi_uchar = histRoiUChar.binned_data(256);
+    histUInt.execute();
+    std::vector<unsigned int> hist_uint = histUInt.binned_data(num_bins_large);
+
+    time1 = time_ms();
+    dt = time1 - time0;
+    fprintf(stderr, "Hipacc: %.3f ms, %.3f Mpixel/s\n", dt, ((width*height)/dt)/1000);
+
+
+    fprintf(stderr, "\nCalculating reference ...\n");
+    time0 = time_ms();
+
+    // calculate reference
+    auto bin_uchar = [] (uchar pixel, unsigned int num_bins) {
+        return pixel * num_bins / 256;
+    };
+    auto bin_uint = [] (uint pixel, unsigned int num_bins) {
+        return pixel;
+    };
+    std::vector<unsigned int> ref_uchar_256 = calc_histogram(input_uchar,
+            width, height, 0, 0, width, height, 256, bin_uchar);
+    std::vector<unsigned int> ref_uchar_64 = calc_histogram(input_uchar,
+            width, height, 0, 0, width, height, 64, bin_uchar);
+    std::vector<unsigned int> ref_roi_uchar = calc_histogram(input_uchar,
+            width, height, width/3, height/3, width/3, height/3, 256, bin_uchar);
+    std::vector<unsigned int> ref_uint = calc_histogram(input_uint,
+            width, height, 0, 0, width, height, num_bins_large, bin_uint);
+
+    time1 = time_ms();
+    dt = time1 - time0;
+    fprintf(stderr, "Reference: %.3f ms, %.3f Mpixel/s\n", dt, (width*height/dt)/1000);
+
+    // compare results
+    bool passed_all = true;
+    fprintf(stderr, "\nComparing results ...\n");
+    passed_all &= compare(hist_uchar_256, ref_uchar_256, "img, uchar, 256 bins");
+    passed_all &= compare(hist_uchar_64, ref_uchar_64, "img, uchar, 64 bins");
+    passed_all &= compare(hist_roi_uchar, ref_roi_uchar, "acc, uchar, 256 bins");
+    passed_all &= compare(hist_uint, ref_uint, "img, uint, 65536 bins");
+
+    // print final result
+    if (passed_all) {
+        fprintf(stderr, "Tests PASSED\n");
+    } else {
+        fprintf(stderr, "Tests FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // memory cleanup
+    free(input_uchar);
+    free(input_uint);
+
+    return EXIT_SUCCESS;
+}
+
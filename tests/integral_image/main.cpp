@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+#define EPS 1e-4f
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+// reference: inclusive 2D scan of the region of interest, pixels outside of
+// the region are copied
+template<typename data_t>
+void integral_image(data_t *in, data_t *out, int width, int height, int
+        offset_x, int offset_y, int is_width, int is_height) {
+    for (int i=0; i<width*height; ++i) out[i] = in[i];
+
+    for (int y=offset_y; y<offset_y+is_height; ++y) {
+        for (int x=offset_x+1; x<offset_x+is_width; ++x) {
+            out[y*width + x] += out[y*width + x-1];
+        }
+    }
+    for (int y=offset_y+1; y<offset_y+is_height; ++y) {
+        for (int x=offset_x; x<offset_x+is_width; ++x) {
+            out[y*width + x] += out[(y-1)*width + x];
+        }
+    }
+}
+template<typename data_t>
+void integral_image(data_t *in, data_t *out, int width, int height) {
+    integral_image<data_t>(in, out, width, height, 0, 0, width, height);
+}
+
+
+// Kernel description in HIPAcc
+class IntegralImageInt : public Kernel<int> {
+    private:
+        Accessor<int> &in;
+
+    public:
+        IntegralImageInt(IterationSpace<int> &iter, Accessor<int> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        int scan(int left, int right) {
+            return left + right;
+        }
+};
+class IntegralImageFloat : public Kernel<float> {
+    private:
+        Accessor<float> &in;
+
+    public:
+        IntegralImageFloat(IterationSpace<float> &iter, Accessor<float> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        float scan(float left, float right) {
+            return left + right;
+        }
+};
+
+
+// compare the result against the reference
+template<typename data_t>
+bool compare(data_t *output, data_t *reference, int width, int height, const
+        char *name) {
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            double ref = reference[y*width + x];
+            double derr = fabs(ref - output[y*width + x]);
+            if (derr > EPS * fmax(1.0, fabs(ref))) {
+                fprintf(stderr, "Test FAILED for integral image (%s), at (%d,%d): %f vs. %f\n",
+                        name, x, y, (double)output[y*width + x], ref);
+                return false;
+            }
+        }
+    }
+    fprintf(stderr, "Integral image (%s): PASSED\n", name);
+
+    return true;
+}
+
+
+int main(int argc, const char **argv) {
+    double time0, time1, dt;
+    const int width = WIDTH;
+    const int height = HEIGHT;
+
+    // host memory for image of width x height pixels
+    int *input_int = (int *)malloc(sizeof(int)*width*height);
+    int *reference_out_int = (int *)malloc(sizeof(int)*width*height);
+    int *reference_acc_int = (int *)malloc(sizeof(int)*width*height);
+    float *input_float = (float *)malloc(sizeof(float)*width*height);
+    float *reference_out_float = (float *)malloc(sizeof(float)*width*height);
+
+    // initialize data: multiples of 1/8, so that the sums are exact in float
+    // for images of up to 2048x2048 pixels regardless of the summation order
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input_int[y*width + x] = (x + 3*y) % 7;
+            input_float[y*width + x] = (float) ((x + 3*y) % 7) * 0.125f;
+        }
+    }
+
+    // input and output image of width x height pixels
+    Image<int> in_int(width, height, input_int);
+    Image<int> out_int(width, height);
+    Image<int> out_acc_int(width, height, input_int);
+    Image<float> in_float(width, height, input_float);
+    Image<float> out_float(width, height);
+
+    Accessor<int> acc_in_int(in_int);
+    Accessor<int> acc_roi_int(in_int, width/3, height/3, width/3, height/3);
+    Accessor<float> acc_in_float(in_float);
+
+    // iteration spaces
+    IterationSpace<int> out_int_iter(out_int);
+    IterationSpace<int> out_acc_int_iter(out_acc_int, width/3, height/3, width/3, height/3);
+    IterationSpace<float> out_float_iter(out_float);
+
+    IntegralImageInt integralInt(out_int_iter, acc_in_int);
+    IntegralImageInt integralAccInt(out_acc_int_iter, acc_roi_int);
+    IntegralImageFloat integralFloat(out_float_iter, acc_in_float);
+
+    fprintf(stderr, "Calculating integral images ...\n");
+    time0 = time_ms();
+
+    integralInt.execute();
+    integralAccInt.execute();
+    integralFloat.execute();
+
+    time1 = time_ms();
+    dt = time1 - time0;
+
+    // get pointer to result data
+    int *output_int = out_int.data();
+    int *output_acc_int = out_acc_int.data();
+    float *output_float = out_float.data();
+
+    fprintf(stderr, "Hipacc: %.3f ms, %.3f Mpixel/s\n", dt, ((width*height)/dt)/1000);
+
+
+    fprintf(stderr, "\nCalculating reference ...\n");
+    time0 = time_ms();
+
+    // calculate reference
+    integral_image(input_int, reference_out_int, width, height);
+    integral_image(input_int, reference_acc_int, width, height, width/3, height/3, width/3, height/3);
+    integral_image(input_float, reference_out_float, width, height);
+
+    time1 = time_ms();
+    dt = time1 - time0;
+    fprintf(stderr, "Reference: %.3f ms, %.3f Mpixel/s\n", dt, (width*height/dt)/1000);
+
+    // compare results
+    bool passed_all = true;
+    fprintf(stderr, "\nComparing results ...\n");
+    passed_all &= compare(output_int, reference_out_int, width, height, "img, int");
+    passed_all &= compare(output_acc_int, reference_acc_int, width, height, "acc, int");
+    passed_all &= compare(output_float, reference_out_float, width, height, "img, float");
+
+    // print final result
+    if (passed_all) {
+        fprintf(stderr, "Tests PASSED\n");
+    } else {
+        fprintf(stderr, "Tests FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // memory cleanup
+    free(input_int);
+    free(reference_out_int);
+    free(reference_acc_int);
+    free(input_float);
+    free(reference_out_float);
+
+    return EXIT_SUCCESS;
+}
+
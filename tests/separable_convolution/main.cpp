@@ -0,0 +1,248 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+#define EPS 1e-4f
+#define SIZE 5
+#define CONST_VAL 0.5f
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+// reference: 2D convolution using the boundary handling of the DSL; the
+// region of interest of the output starts at pixel (0,0) of the input
+float get_pixel(float *in, int x, int y, int width, int height, Boundary
+        mode) {
+    switch (mode) {
+        case Boundary::CLAMP:
+            x = std::min(std::max(x, 0), width-1);
+            y = std::min(std::max(y, 0), height-1);
+            break;
+        case Boundary::MIRROR:
+            if (x < 0) x = -x-1;
+            if (y < 0) y = -y-1;
+            if (x >= width) x = width - (x+1 - width);
+            if (y >= height) y = height - (y+1 - height);
+            break;
+        case Boundary::CONSTANT:
+            if (x < 0 || y < 0 || x >= width || y >= height) return CONST_VAL;
+            break;
+        default:
+            break;
+    }
+    return in[y*width + x];
+}
+void convolution(float *in, float *out, const float *filter, int width, int
+        height, int offset_x, int offset_y, int is_width, int is_height,
+        Boundary mode) {
+    const int anchor = SIZE >> 1;
+
+    for (int y=offset_y; y<offset_y+is_height; ++y) {
+        for (int x=offset_x; x<offset_x+is_width; ++x) {
+            float sum = 0.0f;
+            for (int yf=-anchor; yf<=anchor; ++yf) {
+                for (int xf=-anchor; xf<=anchor; ++xf) {
+                    sum += filter[(yf+anchor)*SIZE + xf+anchor] *
+                           get_pixel(in, x-offset_x+xf, y-offset_y+yf, width,
+                                     height, mode);
+                }
+            }
+            out[y*width + x] = sum;
+        }
+    }
+}
+
+
+// Kernel description in HIPAcc: the constant Mask is separated into row and
+// column kernels by the compiler
+class GaussianFilter : public Kernel<float> {
+    private:
+        Accessor<float> &input;
+        Mask<float> &mask;
+
+    public:
+        GaussianFilter(IterationSpace<float> &iter, Accessor<float> &input,
+                Mask<float> &mask) :
+            Kernel(iter),
+            input(input),
+            mask(mask)
+        { add_accessor(&input); }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> float {
+                    return mask() * input(mask);
+                    });
+        }
+};
+
+
+// compare the region of interest of the result against the reference
+bool compare(float *output, float *reference, int width, int offset_x, int
+        offset_y, int is_width, int is_height, const char *name) {
+    for (int y=offset_y; y<offset_y+is_height; ++y) {
+        for (int x=offset_x; x<offset_x+is_width; ++x) {
+            double ref = reference[y*width + x];
+            double derr = fabs(ref - output[y*width + x]);
+            if (derr > EPS * fmax(1.0, fabs(ref))) {
+                fprintf(stderr, "Test FAILED for separable convolution (%s), at (%d,%d): %f vs. %f\n",
+                        name, x, y, (double)output[y*width + x], ref);
+                return false;
+            }
+        }
+    }
+    fprintf(stderr, "Separable convolution (%s): PASSED\n", name);
+
+    return true;
+}
+
+
+int main(int argc, const char **argv) {
+    double time0, time1, dt;
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int offset_x = width/4, offset_y = height/4;
+    const int is_width = width/2, is_height = height/2;
+
+    // Gaussian filter mask: outer product of the binomial coefficients
+    const float filter_xy[SIZE][SIZE] = {
+        { 0.00390625f, 0.015625f, 0.0234375f, 0.015625f, 0.00390625f },
+        { 0.015625f,   0.0625f,   0.09375f,   0.0625f,   0.015625f   },
+        { 0.0234375f,  0.09375f,  0.140625f,  0.09375f,  0.0234375f  },
+        { 0.015625f,   0.0625f,   0.09375f,   0.0625f,   0.015625f   },
+        { 0.00390625f, 0.015625f, 0.0234375f, 0.015625f, 0.00390625f }
+    };
+
+    // host memory for image of width x height pixels
+    float *input = (float *)malloc(sizeof(float)*width*height);
+    float *reference_clamp = (float *)malloc(sizeof(float)*width*height);
+    float *reference_mirror = (float *)malloc(sizeof(float)*width*height);
+    float *reference_const = (float *)malloc(sizeof(float)*width*height);
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input[y*width + x] = (float) ((x*7 + y*13) % 17);
+        }
+    }
+
+    // input and output images of width x height pixels
+    Image<float> in(width, height, input);
+    Image<float> out_clamp(width, height);
+    Image<float> out_mirror(width, height);
+    Image<float> out_const(width, height);
+
+    Mask<float> M(filter_xy);
+
+    BoundaryCondition<float> bc_clamp(in, M, Boundary::CLAMP);
+    BoundaryCondition<float> bc_mirror(in, M, Boundary::MIRROR);
+    BoundaryCondition<float> bc_const(in, M, Boundary::CONSTANT, CONST_VAL);
+    Accessor<float> acc_clamp(bc_clamp);
+    Accessor<float> acc_mirror(bc_mirror);
+    Accessor<float> acc_const(bc_const);
+
+    // iteration spaces: the whole image and regions of interest
+    IterationSpace<float> clamp_iter(out_clamp);
+    IterationSpace<float> mirror_iter(out_mirror, is_width, is_height, offset_x, offset_y);
+    IterationSpace<float> const_iter(out_const, is_width, is_height, offset_x, offset_y);
+
+    GaussianFilter filterClamp(clamp_iter, acc_clamp, M);
+    GaussianFilter filterMirror(mirror_iter, acc_mirror, M);
+    GaussianFilter filterConst(const_iter, acc_const, M);
+
+    fprintf(stderr, "Calculating separable convolutions ...\n");
+    time0 = time_ms();
+
+    filterClamp.execute();
+    filterMirror.execute();
+    filterConst.execute();
+
+    time1 = time_ms();
+    dt = time1 - time0;
+
+    // get pointer to result data
+    float *output_clamp = out_clamp.data();
+    float *output_mirror = out_mirror.data();
+    float *output_const = out_const.data();
+
+    fprintf(stderr, "Hipacc: %.3f ms, %.3f Mpixel/s\n", dt, ((width*height)/dt)/1000);
+
+
+    fprintf(stderr, "\nCalculating reference ...\n");
+    time0 = time_ms();
+
+    // calculate reference
+    convolution(input, reference_clamp, &filter_xy[0][0], width, height, 0, 0, width, height, Boundary::CLAMP);
+    convolution(input, reference_mirror, &filter_xy[0][0], width, height, offset_x, offset_y, is_width, is_height, Boundary::MIRROR);
+    convolution(input, reference_const, &filter_xy[0][0], width, height, offset_x, offset_y, is_width, is_height, Boundary::CONSTANT);
+
+    time1 = time_ms();
+    dt = time1 - time0;
+    fprintf(stderr, "Reference: %.3f ms, %.3f Mpixel/s\n", dt, (width*height/dt)/1000);
+
+    // compare results
+    bool passed_all = true;
+    fprintf(stderr, "\nComparing results ...\n");
+    passed_all &= compare(output_clamp, reference_clamp, width, 0, 0, width, height, "clamp");
+    passed_all &= compare(output_mirror, reference_mirror, width, offset_x, offset_y, is_width, is_height, "mirror, roi");
+    passed_all &= compare(output_const, reference_const, width, offset_x, offset_y, is_width, is_height, "constant, roi");
+
+    // print final result
+    if (passed_all) {
+        fprintf(stderr, "Tests PASSED\n");
+    } else {
+        fprintf(stderr, "Tests FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // memory cleanup
+    free(input);
+    free(reference_clamp);
+    free(reference_mirror);
+    free(reference_const);
+
+    return EXIT_SUCCESS;
+}